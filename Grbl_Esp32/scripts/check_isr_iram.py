@@ -0,0 +1,198 @@
+# PlatformIO post-build check: fails the build if code reachable from the stepper ISR
+# is not in IRAM.
+#
+# The ISR keeps stepping while the flash cache is busy (NVS writes, OTA, WiFi code
+# thrashing the cache) only if everything it runs and reads is in IRAM, ROM or DRAM.
+# This walks the calls starting at the ISR entry points in the linked firmware.elf and
+# reports:
+# - every callee that lives in flash
+# - every literal that points into flash: constant tables, switch jump tables, string
+#   constants and function pointers to flash code
+# - every indirect call (callx) outside the functions listed in INDIRECT_CALLERS
+#
+# Indirect calls cannot be followed from the disassembly. The stepper ISR calls the
+# motor and spindle methods through function pointers resolved at boot (see
+# motors_resolve_isr() and st_isr_attach()), and the I2S render function calls the
+# pulse callback. Those call sites are listed in INDIRECT_CALLERS, and the functions
+# they may reach are checked as roots of their own. At run time st_isr_attach() only
+# allocates the interrupt with ESP_INTR_FLAG_IRAM if the resolved methods are in IRAM.
+
+Import("env")
+
+import re
+import struct
+import subprocess
+
+# Entry points, as regular expressions on mangled names. Each one must be found.
+ISR_ENTRY_ROOTS = [
+    r"^_Z\d+onStepperDriverTimerPv$",
+]
+
+# Entry points that only exist with I2S stepping. Required when the I2S render code is linked.
+I2S_ENTRY_ROOTS = [
+    r"^_ZL\d+stepper_pulse_streamv$",
+    r"^_ZL\d+i2s_shift_reg_renderv$",
+]
+
+# Targets of the indirect calls: the motor and spindle methods the ISR may call. Only the
+# classes the firmware uses are linked, so these need not all be present.
+ISR_INDIRECT_ROOTS = [
+    r"^_ZN6Motors5Motor(4step|6unstep|13set_direction|11set_disable)E",
+    r"^_ZN6Motors15StandardStepper(4step|6unstep|13set_direction|11set_disable)E",
+    r"^_ZN6Motors13UnipolarMotor(4step|13set_direction|11set_disable)E",
+    r"^_ZN8Spindles4Null7set_rpmE",
+]
+
+# Functions whose callx instructions are the indirect calls above. The compiler may inline
+# them into their callers, which are listed too.
+INDIRECT_CALLERS = [
+    r"^_Z\d+motors_step",
+    r"^_Z\d+motors_unstep",
+    r"^_Z\d+motors_direction",
+    r"^_Z\d+motors_set_disable",
+    r"^_ZL\d+stepper_pulse_funcv$",
+    r"^_Z\d+st_go_idlev$",
+    r"^_Z\d+onStepperDriverTimerPv$",
+    r"^_ZL\d+stepper_pulse_streamv$",
+    r"^_ZL\d+i2s_shift_reg_renderv$",
+]
+
+# ESP32-S3 address ranges that are safe to run with the flash cache disabled
+SAFE_CODE = [
+    (0x40000000, 0x40060000),  # ROM
+    (0x40370000, 0x403E0000),  # Internal SRAM, instruction bus (IRAM)
+    (0x600FE000, 0x60100000),  # RTC fast memory
+]
+
+# ESP32-S3 address ranges mapped through the flash cache
+FLASH = [
+    (0x3C000000, 0x3E000000),  # Data bus (DROM, rodata)
+    (0x42000000, 0x44000000),  # Instruction bus (IROM, flash code)
+]
+
+FUNC_RE = re.compile(r"^([0-9a-f]+) <(.+)>:$")
+CALL_RE = re.compile(r"\bcall(?:0|4|8|12)\s+([0-9a-f]+)(?:\s+<([^>+]+)(?:\+0x[0-9a-f]+)?>)?")
+CALLX_RE = re.compile(r"\bcallx(?:0|4|8|12)\b")
+L32R_RE = re.compile(r"\bl32r\s+a\d+,\s*([0-9a-f]+)")
+DUMP_RE = re.compile(r"^ ([0-9a-f]+) ((?:[0-9a-f]{1,8} ){1,4})")
+
+
+def in_ranges(addr, ranges):
+    return any(lo <= addr < hi for lo, hi in ranges)
+
+
+def tool(env, name):
+    # $CC is e.g. xtensa-esp32s3-elf-gcc
+    return env.subst("$CC").rsplit("-", 1)[0] + "-" + name
+
+
+def load_symbols(env, elf):
+    symbols = {}
+    out = subprocess.check_output([tool(env, "nm"), "--defined-only", elf], universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[1] in "tTwW":
+            symbols[fields[2]] = int(fields[0], 16)
+    return symbols
+
+
+def load_code(env, elf):
+    # Only IRAM code needs disassembling; anything it calls in flash is a failure anyway.
+    # Returns, per function, its direct calls, the literal addresses it loads and whether
+    # it makes indirect calls.
+    code = {}
+    current = None
+    out = subprocess.check_output(
+        [tool(env, "objdump"), "-d", "--no-show-raw-insn", "-j", ".iram0.text", elf], universal_newlines=True
+    )
+    for line in out.splitlines():
+        m = FUNC_RE.match(line)
+        if m:
+            current = {"calls": [], "literals": [], "callx": False}
+            code[m.group(2)] = current
+            continue
+        if current is None:
+            continue
+        m = CALL_RE.search(line)
+        if m:
+            current["calls"].append((int(m.group(1), 16), m.group(2) or m.group(1)))
+            continue
+        if CALLX_RE.search(line):
+            current["callx"] = True
+            continue
+        m = L32R_RE.search(line)
+        if m:
+            current["literals"].append(int(m.group(1), 16))
+    return code
+
+
+def load_words(env, elf):
+    # The 32 bit words of .iram0.text, where the literal pools of IRAM code are, by address
+    words = {}
+    out = subprocess.check_output([tool(env, "objdump"), "-s", "-j", ".iram0.text", elf], universal_newlines=True)
+    for line in out.splitlines():
+        m = DUMP_RE.match(line)
+        if not m:
+            continue
+        addr = int(m.group(1), 16)
+        for chunk in m.group(2).split():
+            if len(chunk) == 8:
+                words[addr] = struct.unpack("<I", bytes.fromhex(chunk))[0]
+            addr += len(chunk) // 2
+    return words
+
+
+def find_roots(symbols, patterns, required, errors):
+    roots = []
+    for pattern in patterns:
+        found = [name for name in symbols if re.match(pattern, name)]
+        if required and not found:
+            errors.append("ISR root %s not found" % pattern)
+        roots += found
+    return roots
+
+
+def check_isr_iram(source, target, env):
+    elf = str(target[0])
+    symbols = load_symbols(env, elf)
+    code = load_code(env, elf)
+    words = load_words(env, elf)
+
+    errors = []
+    roots = find_roots(symbols, ISR_ENTRY_ROOTS, True, errors)
+    i2s = any("i2s_shift_reg" in name for name in symbols)
+    roots += find_roots(symbols, I2S_ENTRY_ROOTS, i2s, errors)
+    roots += find_roots(symbols, ISR_INDIRECT_ROOTS, False, errors)
+
+    seen = set()
+    pending = [(name, symbols[name], None) for name in roots]
+    while pending:
+        name, addr, caller = pending.pop()
+        if name in seen:
+            continue
+        seen.add(name)
+        if not in_ranges(addr, SAFE_CODE):
+            errors.append("%s (0x%08x) called from %s" % (name, addr, caller or "ISR"))
+            continue
+        body = code.get(name)
+        if body is None:
+            continue  # ROM
+        if body["callx"] and not any(re.match(pattern, name) for pattern in INDIRECT_CALLERS):
+            errors.append("%s makes an indirect call that the check cannot follow" % name)
+        for literal in body["literals"]:
+            value = words.get(literal)
+            if value is not None and in_ranges(value, FLASH):
+                errors.append("%s loads flash address 0x%08x (constant data, jump table or flash code)" % (name, value))
+        for callee_addr, callee in body["calls"]:
+            pending.append((callee, callee_addr, name))
+
+    if errors:
+        print("Stepper ISR reaches code or data outside IRAM/DRAM:")
+        for error in sorted(set(errors)):
+            print("    " + error)
+        print("Mark code IRAM_ATTR and constant data DRAM_ATTR, or remove them from the ISR path.")
+        env.Exit(1)
+    print("Stepper ISR IRAM check: %d functions OK" % len(seen))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_isr_iram)
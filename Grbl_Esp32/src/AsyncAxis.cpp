@@ -0,0 +1,195 @@
+/*
+  AsyncAxis.cpp - Independent motion queue for one axis
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+#ifdef ASYNC_AXIS
+
+// A queued async axis move
+typedef struct {
+    int32_t steps;         // Signed step count of the move
+    float   rate;          // Cruise rate (steps/min)
+    float   acceleration;  // (steps/min^2)
+} async_move_t;
+
+// Move ring. The main loop adds moves at the head, the segment prep takes them from the tail.
+// Both ends are only accessed with the prep lock held, as the two run on different cores.
+static async_move_t async_buffer[ASYNC_AXIS_BUFFER_SIZE];
+static uint8_t      async_buffer_tail;
+static uint8_t      async_buffer_head;
+
+// Velocity profile of the move being prepped. Accessed only with the prep lock held.
+typedef struct {
+    bool     active;        // A move is loaded
+    bool     reverse;       // The move is in the negative direction
+    uint32_t remaining;     // Whole steps left to take
+    float    rate;          // (steps/min)
+    float    acceleration;  // (steps/min^2)
+    float    speed;         // Speed at the end of the last prepped time slice (steps/min)
+    float    fraction;      // Distance covered but not yet taken as a whole step (steps)
+} async_prep_t;
+static async_prep_t async_prep;
+
+static uint8_t async_next_index(uint8_t index) {
+    index++;
+    return index == ASYNC_AXIS_BUFFER_SIZE ? 0 : index;
+}
+
+void async_reset() {
+    st_prep_lock();
+    async_buffer_tail = 0;
+    async_buffer_head = 0;
+    memset(&async_prep, 0, sizeof(async_prep_t));
+    st_prep_unlock();
+}
+
+bool async_busy() {
+    st_prep_lock();
+    bool busy = async_buffer_head != async_buffer_tail || async_prep.active;
+    st_prep_unlock();
+    return busy;
+}
+
+static bool async_full() {
+    st_prep_lock();
+    bool full = async_next_index(async_buffer_head) == async_buffer_tail;
+    st_prep_unlock();
+    return full;
+}
+
+bool async_ready() {
+    return !plan_axis_queued(ASYNC_AXIS) && !async_full();
+}
+
+// Keeps the realtime protocol and the cycle going while waiting on the queues.
+static bool async_wait_step() {
+    protocol_auto_cycle_start();
+    protocol_execute_realtime();
+    return !sys.abort;
+}
+
+void async_synchronize() {
+    while (async_busy()) {
+        if (!async_wait_step()) {
+            return;
+        }
+    }
+}
+
+void async_release_axis(float* target) {
+    int32_t target_steps = lround(target[ASYNC_AXIS] * axis_settings[ASYNC_AXIS]->steps_per_mm->get());
+    if (target_steps != plan_get_axis_position(ASYNC_AXIS)) {
+        async_synchronize();
+    }
+}
+
+Error async_execute(parser_block_t* gc_block) {
+    if (soft_limits->get()) {
+        if (limitsCheckTravel(gc_block->values.xyz)) {
+            return Error::TravelExceeded;
+        }
+    }
+    // If in check gcode mode, prevent motion. Soft limits still work.
+    if (sys.state == State::CheckMode) {
+        return Error::Ok;
+    }
+    // Planner blocks that move the axis go first. Once they have left the planner, their steps
+    // are in segments ahead of any the async queue adds.
+    while (!async_ready()) {
+        if (!async_wait_step()) {
+            return Error::Ok;
+        }
+    }
+
+    float steps_per_mm = axis_settings[ASYNC_AXIS]->steps_per_mm->get();
+    float max_rate     = axis_settings[ASYNC_AXIS]->max_rate->get();
+    float rate         = gc_block->modal.motion == Motion::Seek ? max_rate : MIN(gc_block->values.f, max_rate);
+
+    int32_t target_steps = lround(gc_block->values.xyz[ASYNC_AXIS] * steps_per_mm);
+    st_prep_lock();
+    int32_t steps = target_steps - plan_get_axis_position(ASYNC_AXIS);
+    if (steps != 0) {
+        async_move_t* move = &async_buffer[async_buffer_head];
+        move->steps        = steps;
+        move->rate         = MAX(rate, MINIMUM_FEED_RATE) * steps_per_mm;
+        move->acceleration = axis_settings[ASYNC_AXIS]->acceleration->get() * SEC_PER_MIN_SQ * steps_per_mm;
+        async_buffer_head  = async_next_index(async_buffer_head);
+        // Planner blocks queued from here on start where this move ends.
+        plan_set_axis_position(ASYNC_AXIS, target_steps);
+    }
+    st_prep_unlock();
+    st_prep_wake();
+    return Error::Ok;
+}
+
+int32_t async_prep_steps(float dt, uint32_t max_steps, bool hold) {
+    if (!async_prep.active) {
+        if (hold || async_buffer_tail == async_buffer_head) {
+            return 0;
+        }
+        async_move_t* move      = &async_buffer[async_buffer_tail];
+        async_prep.reverse      = move->steps < 0;
+        async_prep.remaining    = labs(move->steps);
+        async_prep.rate         = move->rate;
+        async_prep.acceleration = move->acceleration;
+        async_prep.speed        = 0.0;
+        async_prep.fraction     = 0.0;
+        async_prep.active       = true;
+        async_buffer_tail       = async_next_index(async_buffer_tail);
+    }
+
+    // Accelerate towards the move rate, or decelerate once the rest of the move is within
+    // stopping distance or a hold is in progress.
+    float v0        = async_prep.speed;
+    float stop_dist = v0 * v0 / (2.0 * async_prep.acceleration);
+    float v1;
+    if (hold || stop_dist >= async_prep.remaining - async_prep.fraction) {
+        v1 = MAX(v0 - async_prep.acceleration * dt, 0.0);
+    } else {
+        v1 = MIN(v0 + async_prep.acceleration * dt, async_prep.rate);
+    }
+    float    distance = async_prep.fraction + 0.5 * (v0 + v1) * dt;
+    uint32_t steps    = floor(distance);
+    if (steps > max_steps) {
+        // Fewer ISR ticks than steps in this slice. Slow down to what the ticks can carry.
+        steps    = max_steps;
+        distance = steps;
+        v1       = MIN(v1, steps / dt);
+    }
+    if (steps >= async_prep.remaining) {
+        // Move complete. The next one starts from rest.
+        steps             = async_prep.remaining;
+        async_prep.speed  = 0.0;
+        async_prep.active = false;
+    } else {
+        async_prep.remaining -= steps;
+        async_prep.fraction = distance - steps;
+        async_prep.speed    = v1;
+    }
+    return async_prep.reverse ? -int32_t(steps) : int32_t(steps);
+}
+
+bool async_prep_stopped() {
+    return async_prep.speed == 0.0;
+}
+
+void async_prep_halt() {
+    async_prep.speed = 0.0;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+  AsyncAxis.h - Independent motion queue for one axis
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// With ASYNC_AXIS defined in the machine file, G-code lines starting with '@' move that axis
+// through a queue of its own, concurrently with the planner blocks of the other axes:
+//
+//   @G1 A12.5 F300   Move the async axis to 12.5 at 300 mm/min (G0 moves at its max rate)
+//   M400             Wait until both queues are empty
+//
+// '@' lines accept G0/G1, G90/G91, G20/G21, G53, N, F and the async axis word only, and do not
+// change the modal state of the parser. Each move runs rest-to-rest at the axis acceleration.
+// The steps ride on the segments of the stepper ISR, so they need no timer of their own; a segment
+// gets ISR ticks enough for whichever of its axes steps fastest, the async one included. Ordinary
+// G-code may still move the axis; it waits for the async queue to drain first, and '@' lines wait
+// for planner blocks that move the axis.
+
+#include "Grbl.h"
+
+#ifdef ASYNC_AXIS
+
+// Number of moves the async axis queue holds.
+#    ifndef ASYNC_AXIS_BUFFER_SIZE
+#        define ASYNC_AXIS_BUFFER_SIZE 16
+#    endif
+
+// Clears the queue and stops the async profile. Called by st_reset(), as the async steps in the
+// segment buffer are dropped with it.
+void async_reset();
+
+// Queues the async axis move of an '@' line. Its target is in machine coordinates (mm).
+// Waits for room in the queue, and for planner blocks that move the axis to finish.
+Error async_execute(parser_block_t* gc_block);
+
+// Waits for the async axis queue to be empty and its last step taken.
+void async_synchronize();
+
+// Called by mc_line() before a planner block is queued. If the block moves the async axis,
+// waits for the async queue to finish first.
+void async_release_axis(float* target);
+
+// True while async moves are queued or being prepped.
+bool async_busy();
+
+// True if async_execute() can queue a move at once: the queue has room and no planner block
+// moves the axis.
+bool async_ready();
+
+// Segment prep interface. Called with the prep lock held.
+// Advances the async profile by dt minutes and returns the signed number of whole steps to take
+// in that time, at most max_steps. A hold decelerates the axis to a stop.
+int32_t async_prep_steps(float dt, uint32_t max_steps, bool hold);
+// True if the axis is at rest, though moves may still be pending.
+bool async_prep_stopped();
+// Drops the profile speed to zero, for when the segment buffer stops without a deceleration.
+void async_prep_halt();
+
+#endif
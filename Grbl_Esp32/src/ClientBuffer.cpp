@@ -0,0 +1,92 @@
+/*
+  ClientBuffer.cpp - Receive queue of one client
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ClientBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The ring doesn't depend on the rest of Grbl, so it builds on the host for the tests in test/.
+#ifdef ESP_PLATFORM
+#    include <esp_heap_caps.h>
+#    define client_buffer_alloc(size) heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#else
+#    include <cstdlib>
+#    define client_buffer_alloc(size) malloc(size)
+#endif
+
+bool ClientBuffer::begin(uint32_t capacity) {
+    while (capacity & (capacity - 1)) {
+        capacity &= capacity - 1;  // Clear the low bits down to the top one
+    }
+    _data = (uint8_t*)client_buffer_alloc(capacity);
+    if (_data == NULL) {
+        return false;
+    }
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _capacity = capacity;
+    return true;
+}
+
+size_t ClientBuffer::writeSpan(uint8_t** span) {
+    uint32_t head   = _head.load(std::memory_order_relaxed);
+    uint32_t free   = _capacity - (head - _tail.load(std::memory_order_acquire));
+    uint32_t offset = head & (_capacity - 1);
+    *span           = _data + offset;
+    return std::min(free, _capacity - offset);
+}
+
+size_t ClientBuffer::write(const uint8_t* data, size_t len) {
+    size_t done = 0;
+    // The free room wraps at most once, so two spans cover it.
+    for (int i = 0; i < 2 && done < len; i++) {
+        uint8_t* span;
+        size_t   n = std::min(writeSpan(&span), len - done);
+        if (n == 0) {
+            break;
+        }
+        memcpy(span, data + done, n);
+        commitWrite(n);
+        done += n;
+    }
+    return done;
+}
+
+size_t ClientBuffer::readSpan(const uint8_t** span) {
+    uint32_t tail   = _tail.load(std::memory_order_relaxed);
+    uint32_t fill   = _head.load(std::memory_order_acquire) - tail;
+    uint32_t offset = tail & (_capacity - 1);
+    *span           = _data + offset;
+    return std::min(fill, _capacity - offset);
+}
+
+size_t ClientBuffer::read(uint8_t* data, size_t len) {
+    size_t done = 0;
+    for (int i = 0; i < 2 && done < len; i++) {
+        const uint8_t* span;
+        size_t         n = std::min(readSpan(&span), len - done);
+        if (n == 0) {
+            break;
+        }
+        memcpy(data + done, span, n);
+        consume(n);
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+  ClientBuffer.h - Receive queue of one client
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The client reader task fills the queue of each client and the protocol loop empties it, from
+// tasks that may run on different cores. With exactly one writer and one reader, the two sides
+// share nothing but the head and tail counters. Only the writer moves the head and only the
+// reader moves the tail, and each side publishes its counter after the bytes it covers, so
+// neither side takes a lock or turns interrupts off.
+//
+// The counters run freely and wrap at 2^32. Their difference is the fill, and the capacity, a
+// power of two, masks them into the storage. The storage is allocated by begin(), once at boot,
+// before either side runs. Until then the buffer is empty and has no room.
+//
+// Both sides can also work in spans. writeSpan() returns the contiguous free room at the head,
+// which the writer fills and then publishes with commitWrite(). readSpan() returns the
+// contiguous bytes at the tail, which the reader releases with consume(). A span stops at the
+// end of the storage, so moving all the free room or all the data takes at most two spans.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class ClientBuffer {
+public:
+    ClientBuffer() : _head(0), _tail(0), _capacity(0), _data(NULL) {}
+
+    // Allocates capacity bytes of storage, rounded down to a power of two. Returns false if
+    // there is not enough memory.
+    bool begin(uint32_t capacity);
+
+    uint32_t capacity() const { return _capacity; }
+
+    // Writer side
+
+    size_t availableForWrite() const { return _capacity - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire)); }
+
+    bool write(uint8_t c) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == _capacity) {
+            return false;
+        }
+        _data[head & (_capacity - 1)] = c;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copies as much of data as fits. Returns the number of bytes written.
+    size_t write(const uint8_t* data, size_t len);
+
+    // Sets span to the contiguous free room at the head and returns its length.
+    size_t writeSpan(uint8_t** span);
+
+    // Publishes len bytes written into the span from writeSpan().
+    void commitWrite(size_t len) { _head.store(_head.load(std::memory_order_relaxed) + len, std::memory_order_release); }
+
+    // Reader side
+
+    size_t available() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed); }
+
+    // Returns the next byte, or -1 if the buffer is empty.
+    int read() {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail) {
+            return -1;
+        }
+        uint8_t c = _data[tail & (_capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return c;
+    }
+
+    // Copies up to len bytes into data. Returns the number of bytes read.
+    size_t read(uint8_t* data, size_t len);
+
+    // Sets span to the contiguous bytes at the tail and returns their number.
+    size_t readSpan(const uint8_t** span);
+
+    // Releases len bytes read from the span from readSpan().
+    void consume(size_t len) { _tail.store(_tail.load(std::memory_order_relaxed) + len, std::memory_order_release); }
+
+    // Drops everything written so far. A reader-side call, so it is safe while the writer runs.
+    void clear() { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    std::atomic<uint32_t> _head;  // Free-running count of bytes written
+    std::atomic<uint32_t> _tail;  // Free-running count of bytes read
+    uint32_t              _capacity;
+    uint8_t*              _data;
+};
+
+// Moves bytes from the reader task to the protocol loop through a ClientBuffer and, for
+// comparison, through an InputBuffer guarded by a critical section per byte, and reports the
+// bytes/s of each.
+void client_buffer_benchmark(uint8_t client);
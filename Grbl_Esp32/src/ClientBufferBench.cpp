@@ -0,0 +1,147 @@
+/*
+  ClientBufferBench.cpp - Benchmark of the client receive queue
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+const uint32_t CLIENT_BENCH_BYTES = 256 * 1024;
+const uint32_t CLIENT_BENCH_SIZE  = 256;  // The size of an InputBuffer, for a like for like race
+const uint32_t CLIENT_BENCH_CHUNK = 64;  // Bytes per bulk transfer, about one line of G-code
+
+enum class BenchPath : uint8_t {
+    Locked,  // InputBuffer, with a critical section around every byte on both sides
+    Byte,    // ClientBuffer, one byte at a time
+    Span,    // ClientBuffer, in spans
+};
+
+static portMUX_TYPE        bench_mutex = portMUX_INITIALIZER_UNLOCKED;
+static WebUI::InputBuffer  bench_locked;
+static ClientBuffer        bench_ring;
+static volatile BenchPath  bench_path;
+static TaskHandle_t        bench_caller;
+
+static inline uint8_t bench_byte(uint32_t i) {
+    return i % 251;  // Prime period, so a lost or doubled byte shows up
+}
+
+// Writer side. Runs on the other core from the reader, so the two sides really run at once and
+// the race includes the cost of moving the counters and bytes between the cores.
+static void client_bench_task(void* pvParameters) {
+    uint32_t sent = 0;
+    while (sent < CLIENT_BENCH_BYTES) {
+        switch (bench_path) {
+            case BenchPath::Locked: {
+                vPortEnterCritical(&bench_mutex);
+                size_t n = bench_locked.write(bench_byte(sent));
+                vPortExitCritical(&bench_mutex);
+                sent += n;
+            } break;
+            case BenchPath::Byte:
+                sent += bench_ring.write(bench_byte(sent));
+                break;
+            case BenchPath::Span: {
+                uint8_t  chunk[CLIENT_BENCH_CHUNK];
+                uint32_t n = MIN(CLIENT_BENCH_CHUNK, CLIENT_BENCH_BYTES - sent);
+                for (uint32_t i = 0; i < n; i++) {
+                    chunk[i] = bench_byte(sent + i);
+                }
+                uint32_t done = 0;
+                while (done < n) {
+                    done += bench_ring.write(chunk + done, n - done);
+                }
+                sent += n;
+            } break;
+        }
+    }
+    xTaskNotifyGive(bench_caller);
+    vTaskDelete(NULL);
+}
+
+// Reader side. Returns the number of bytes that did not match what was written.
+static uint32_t client_bench_read() {
+    uint32_t received = 0;
+    uint32_t errors   = 0;
+    while (received < CLIENT_BENCH_BYTES) {
+        switch (bench_path) {
+            case BenchPath::Locked: {
+                vPortEnterCritical(&bench_mutex);
+                int c = bench_locked.read();
+                vPortExitCritical(&bench_mutex);
+                if (c != -1) {
+                    errors += c != bench_byte(received++);
+                }
+            } break;
+            case BenchPath::Byte: {
+                int c = bench_ring.read();
+                if (c != -1) {
+                    errors += c != bench_byte(received++);
+                }
+            } break;
+            case BenchPath::Span: {
+                const uint8_t* span;
+                size_t         n = bench_ring.readSpan(&span);
+                for (size_t i = 0; i < n; i++) {
+                    errors += span[i] != bench_byte(received++);
+                }
+                bench_ring.consume(n);
+            } break;
+        }
+    }
+    return errors;
+}
+
+void client_buffer_benchmark(uint8_t client) {
+    const struct {
+        BenchPath   path;
+        const char* name;
+    } paths[] = { { BenchPath::Locked, "InputBuffer+lock" }, { BenchPath::Byte, "ring by byte" }, { BenchPath::Span, "ring by span" } };
+
+    if (bench_ring.capacity() == 0 && !bench_ring.begin(CLIENT_BENCH_SIZE)) {
+        grbl_msg_sendf(client, MsgLevel::Error, "No room for the benchmark buffer");
+        return;
+    }
+    bench_caller = xTaskGetCurrentTaskHandle();
+    for (auto path : paths) {
+        bench_path = path.path;
+        bench_locked.begin();
+        bench_ring.clear();
+        ulTaskNotifyTake(pdTRUE, 0);
+        int64_t start = esp_timer_get_time();
+        if (xTaskCreatePinnedToCore(client_bench_task,       // task
+                                    "clientBenchTask",       // name for task
+                                    2048,                    // size of task stack
+                                    NULL,                    // parameters
+                                    1,                       // priority
+                                    NULL,                    // task handle
+                                    1 - xPortGetCoreID()     // core, the one the reader is not on
+                                    ) != pdPASS) {
+            grbl_msg_sendf(client, MsgLevel::Error, "No room for the benchmark task");
+            return;
+        }
+        uint32_t errors = client_bench_read();
+        float    secs   = (esp_timer_get_time() - start) / 1000000.0;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // The writer is done with the buffers
+        grbl_msg_sendf(client,
+                       MsgLevel::Info,
+                       "%s: %d bytes in %.1fms, %.0f bytes/s, %d errors",
+                       path.name,
+                       CLIENT_BENCH_BYTES,
+                       secs * 1000.0,
+                       CLIENT_BENCH_BYTES / secs,
+                       errors);
+    }
+}
@@ -99,6 +99,10 @@ const int MAX_N_AXIS = 6;
 // serial monitor, sender, etc uses a different value than 115200
 #define BAUD_RATE 115200
 
+// Adds the native USB port of the ESP32-S3 as a client of its own, next to the serial port.
+// Needs the Hardware CDC and JTAG USB mode, as in platformio.ini. See UsbClient.h.
+// #define ENABLE_USB_CDC
+
 //Connect to your local AP with these credentials
 #define CONNECT_TO_SSID  "NETGEAR13"
 #define SSID_PASSWORD  "dynamicnest700"
@@ -462,6 +466,8 @@ const int DWELL_TIME_STEP = 50;  // Integer (1-255) (milliseconds)
 // available RAM, like when re-compiling for a Mega2560. Or decrease if the Arduino begins to
 // crash due to the lack of available RAM or if the CPU is having trouble keeping up with planning
 // new incoming motions as they are executed.
+// This is the default of $Planner/Blocks, which sets the buffer size at boot, up to
+// MAX_BLOCK_BUFFER_SIZE. The planner reports the memory used at startup.
 // #define BLOCK_BUFFER_SIZE 16 // Uncomment to override default in planner.h.
 
 // Governs the size of the intermediary step segment buffer between the step execution algorithm
@@ -470,8 +476,16 @@ const int DWELL_TIME_STEP = 50;  // Integer (1-255) (milliseconds)
 // block velocity profile is traced exactly. The size of this buffer governs how much step
 // execution lead time there is for other Grbl processes have to compute and do their thing
 // before having to come back and refill this buffer, currently at ~50msec of step moves.
+// This is the default of $Stepper/Segments, which sets the buffer size at boot.
 // #define SEGMENT_BUFFER_SIZE 6 // Uncomment to override default in stepper.h.
 
+// Runs the Bresenham line tracer in st_prep_buffer() instead of the stepper ISR. Each segment is
+// pre-rendered into one step bit mask per ISR tick, so the ISR only outputs the next mask. This
+// trades SEGMENT_BUFFER_SIZE * STEP_PATTERN_MAX_TICKS bytes of RAM for much shorter worst case ISR
+// time. Segments with more ticks than STEP_PATTERN_MAX_TICKS are traced in the ISR as usual.
+// #define STEP_PATTERN_PRERENDER  // Default disabled. Uncomment to enable.
+// #define STEP_PATTERN_MAX_TICKS 256  // Uncomment to override default in stepper.h.
+
 // Line buffer size from the serial input stream to be executed. Also, governs the size of
 // each of the startup blocks, as they are each stored as a string of this size.
 // NOTE: 80 characters is not a problem except for extreme cases, but the line buffer size
@@ -489,7 +503,7 @@ const int DWELL_TIME_STEP = 50;  // Integer (1-255) (milliseconds)
 // 115200 baud will take 5 msec to transmit a typical 55 character report. Worst case reports are
 // around 90-100 characters. As long as the serial TX buffer doesn't get continually maxed, Grbl
 // will continue operating efficiently. Size the TX buffer around the size of a worst-case report.
-// #define RX_BUFFER_SIZE 128 // (1-254) Uncomment to override defaults in serial.h
+// #define RX_BUFFER_SIZE 4096 // (power of two) Default of $Client/RxBuffer. Uncomment to override defaults in serial.h
 // #define TX_BUFFER_SIZE 100 // (1-254)
 
 // A simple software debouncing feature for hard limit switches. When enabled, the limit
@@ -561,6 +575,12 @@ const int DEBOUNCE_PERIOD = 32;  // in milliseconds default 32 microseconds
 // repeatable. If needed, you can disable this behavior by uncommenting the define below.
 // #define ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES // Default disabled. Uncomment to enable.
 
+// Latches the probe position from a pin change interrupt on PROBE_PIN, rather than reading the pin
+// on every stepper ISR tick. The position and time are taken as the edge arrives, so they no longer
+// depend on the tick rate, and the stepper ISR does less work while probing. Fast probing moves,
+// like liquid level detection, then overshoot less. Comment to poll the pin from the stepper ISR.
+#define PROBE_EDGE_LATCH  // Default enabled. Comment to disable.
+
 // Enables and configures parking motion methods upon a safety door state. Primarily for OEMs
 // that desire this feature for their integrated machines. At the moment, Grbl assumes that
 // the parking motion only involves one axis, although the parking implementation was written
@@ -615,3 +635,13 @@ const int N_PIECES = 3;
 
 const double RPM_MAX = 23935.2;
 const double RPM_MIN = 2412.2;
+
+// Enables a piecewise linear calibration of the syringe axis (SYRINGE_AXIS, see Syringe.h) in
+// place of the single $Syringe/UlPerMm factor. Set it in the machine file along with the table:
+// machine positions in mm and the volumes in uL drawn at them, both increasing, at least two
+// points. Positions past the ends of the table extend the first and last pieces.
+// #define ENABLE_PIECEWISE_LINEAR_SYRINGE  // Default disabled. Uncomment to enable.
+/*
+#define SYRINGE_CALIBRATION_MM { 0.0, 2.0, 41.5 }
+#define SYRINGE_CALIBRATION_UL { 0.0, 45.0, 1000.0 }
+*/
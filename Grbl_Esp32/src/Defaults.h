@@ -130,6 +130,10 @@
 #    define DEFAULT_HOMING_SQUARED_AXES 0
 #endif
 
+#ifndef DEFAULT_HOMING_CONCURRENT
+#    define DEFAULT_HOMING_CONCURRENT 0  // Cycles after Cycle0 run one after the other
+#endif
+
 #ifndef DEFAULT_HOMING_CYCLE_0
 #    define DEFAULT_HOMING_CYCLE_0 bit(Z_AXIS)
 #endif
@@ -320,6 +324,85 @@
 #    define DEFAULT_C_ACCELERATION 200.0
 #endif
 
+// ============== Axis Jerk =========
+#define SEC_PER_MIN_CU (60.0 * 60.0 * 60.0)  // Seconds Per Minute Cubed, for jerk conversion
+// Default jerk limits are expressed in mm/sec^3. 0 keeps the trapezoid profile.
+#ifndef DEFAULT_X_JERK
+#    define DEFAULT_X_JERK 0.0
+#endif
+#ifndef DEFAULT_Y_JERK
+#    define DEFAULT_Y_JERK 0.0
+#endif
+#ifndef DEFAULT_Z_JERK
+#    define DEFAULT_Z_JERK 0.0
+#endif
+#ifndef DEFAULT_A_JERK
+#    define DEFAULT_A_JERK 0.0
+#endif
+#ifndef DEFAULT_B_JERK
+#    define DEFAULT_B_JERK 0.0
+#endif
+#ifndef DEFAULT_C_JERK
+#    define DEFAULT_C_JERK 0.0
+#endif
+
+// ============== Axis Input Shapers =========
+// Default shaper type, resonance frequency in Hz and damping ratio
+#ifndef DEFAULT_X_SHAPER_TYPE
+#    define DEFAULT_X_SHAPER_TYPE ShaperType::None
+#endif
+#ifndef DEFAULT_X_SHAPER_FREQUENCY
+#    define DEFAULT_X_SHAPER_FREQUENCY 40.0
+#endif
+#ifndef DEFAULT_X_SHAPER_DAMPING
+#    define DEFAULT_X_SHAPER_DAMPING 0.1
+#endif
+#ifndef DEFAULT_Y_SHAPER_TYPE
+#    define DEFAULT_Y_SHAPER_TYPE ShaperType::None
+#endif
+#ifndef DEFAULT_Y_SHAPER_FREQUENCY
+#    define DEFAULT_Y_SHAPER_FREQUENCY 40.0
+#endif
+#ifndef DEFAULT_Y_SHAPER_DAMPING
+#    define DEFAULT_Y_SHAPER_DAMPING 0.1
+#endif
+#ifndef DEFAULT_Z_SHAPER_TYPE
+#    define DEFAULT_Z_SHAPER_TYPE ShaperType::None
+#endif
+#ifndef DEFAULT_Z_SHAPER_FREQUENCY
+#    define DEFAULT_Z_SHAPER_FREQUENCY 40.0
+#endif
+#ifndef DEFAULT_Z_SHAPER_DAMPING
+#    define DEFAULT_Z_SHAPER_DAMPING 0.1
+#endif
+#ifndef DEFAULT_A_SHAPER_TYPE
+#    define DEFAULT_A_SHAPER_TYPE ShaperType::None
+#endif
+#ifndef DEFAULT_A_SHAPER_FREQUENCY
+#    define DEFAULT_A_SHAPER_FREQUENCY 40.0
+#endif
+#ifndef DEFAULT_A_SHAPER_DAMPING
+#    define DEFAULT_A_SHAPER_DAMPING 0.1
+#endif
+#ifndef DEFAULT_B_SHAPER_TYPE
+#    define DEFAULT_B_SHAPER_TYPE ShaperType::None
+#endif
+#ifndef DEFAULT_B_SHAPER_FREQUENCY
+#    define DEFAULT_B_SHAPER_FREQUENCY 40.0
+#endif
+#ifndef DEFAULT_B_SHAPER_DAMPING
+#    define DEFAULT_B_SHAPER_DAMPING 0.1
+#endif
+#ifndef DEFAULT_C_SHAPER_TYPE
+#    define DEFAULT_C_SHAPER_TYPE ShaperType::None
+#endif
+#ifndef DEFAULT_C_SHAPER_FREQUENCY
+#    define DEFAULT_C_SHAPER_FREQUENCY 40.0
+#endif
+#ifndef DEFAULT_C_SHAPER_DAMPING
+#    define DEFAULT_C_SHAPER_DAMPING 0.1
+#endif
+
 // ========= AXIS MAX TRAVEL ============
 
 #ifndef DEFAULT_X_MAX_TRAVEL
@@ -664,6 +747,19 @@
 #    define USER_ANALOG_PIN_3_FREQ 5000
 #endif
 
+// ========= SYRINGE ============
+#ifndef DEFAULT_SYRINGE_VOLUMETRIC
+#    define DEFAULT_SYRINGE_VOLUMETRIC 0  // false
+#endif
+#ifndef DEFAULT_SYRINGE_UL_PER_MM
+#    define DEFAULT_SYRINGE_UL_PER_MM 1.0  // uL/mm
+#endif
+
+// ========= DECK MAP ============
+#ifndef DEFAULT_DECK_CLEARANCE
+#    define DEFAULT_DECK_CLEARANCE 2.0  // mm
+#endif
+
 #ifndef DEFAULT_USER_MACRO0
 #    define DEFAULT_USER_MACRO0 ""
 #endif
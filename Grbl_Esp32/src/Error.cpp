@@ -41,6 +41,7 @@ std::map<Error, const char*> ErrorNames = {
     { Error::InvalidJogCommand, "Invalid jog command" },
     { Error::SettingDisabledLaser, "Laser mode requires PWM output" },
     { Error::HomingNoCycles, "No Homing/Cycle defined in settings" },
+    { Error::InvalidAsyncCommand, "Invalid async axis command" },
     { Error::GcodeUnsupportedCommand, "Unsupported GCode command" },
     { Error::GcodeModalGroupViolation, "Gcode modal group violation" },
     { Error::GcodeUndefinedFeedRate, "Gcode undefined feed rate" },
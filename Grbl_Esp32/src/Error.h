@@ -44,6 +44,7 @@ enum class Error : uint8_t {
     InvalidJogCommand           = 16,
     SettingDisabledLaser        = 17,
     HomingNoCycles              = 18,
+    InvalidAsyncCommand         = 19,
     GcodeUnsupportedCommand     = 20,
     GcodeModalGroupViolation    = 21,
     GcodeUndefinedFeedRate      = 22,
@@ -83,6 +84,7 @@ enum class Error : uint8_t {
     NvsGetStatsFailed           = 101,
     AuthenticationFailed        = 110,
     Eol                         = 111,
+    LineDeferred                = 112,  // Not reported; the line waits in its buffer. See gc_execute_line().
     AnotherInterfaceBusy        = 120,
     JogCancelled                = 130,
 };
@@ -48,12 +48,17 @@ void gc_init() {
     // Load default G54 coordinate system.
     gc_state.modal.coord_select = CoordIndex::G54;
     coords[gc_state.modal.coord_select]->get(gc_state.coord_system);
+#ifdef LABWARE_SLOTS
+    gc_visits_clear();  // A reset drops the wells of a visit set that have not run yet
+#endif
 }
 
 // Sets g-code parser position in mm. Input in steps. Called by the system abort and hard
 // limit pull-off routines.
 void gc_sync_position() {
-    system_convert_array_steps_to_mpos(gc_state.position, sys_position);
+    int32_t steps[MAX_N_AXIS];
+    st_get_realtime_position(steps);
+    system_convert_array_steps_to_mpos(gc_state.position, steps);
 }
 
 // Edit GCode line in-place, removing whitespace and comments and
@@ -115,17 +120,85 @@ void collapseGCode(char* line) {
     *outPtr = '\0';
 }
 
+// True if the word of an axis is a syringe volume in uL rather than a length. See Syringe.h.
+static bool gc_axis_is_volume(uint8_t axis) {
+#ifdef SYRINGE_AXIS
+    return axis == SYRINGE_AXIS && syringe_volumetric->get();
+#else
+    return false;
+#endif
+}
+
+#ifdef LABWARE_SLOTS
+// Wells of the visit set an M471 handed to protocol_main_loop(), in visit order, and the next one to run
+static uint16_t gc_visit_order[WELL_ORDER_MAX];
+static uint16_t gc_visit_count = 0;
+static uint16_t gc_visit_index = 0;
+
+// Orders the visit set for the least travel time and hands it to protocol_main_loop(), which runs
+// each well as a W line of its own with gc_visit_next().
+static Error gc_visit_wells() {
+#    ifdef SYRINGE_AXIS
+    // A multi-dispense into every well of the set must fit in the syringe.
+    float capacity = syringe_capacity();
+    if (gc_state.dispense_volume > 0.0 && capacity > 0.0 && gc_state.dispense_volume * well_order_count() > capacity) {
+        well_order_clear();
+        return Error::GcodeMaxValueExceeded;
+    }
+#    endif
+    const uint16_t* order = well_order_solve(labware[gc_state.labware], gc_state.position[X_AXIS], gc_state.position[Y_AXIS]);
+    gc_visit_count        = well_order_count();
+    gc_visit_index        = 0;
+    memcpy(gc_visit_order, order, gc_visit_count * sizeof(uint16_t));
+    well_order_clear();
+    return Error::Ok;
+}
+
+bool gc_visits_pending() {
+    return gc_visit_index < gc_visit_count;
+}
+
+Error gc_visit_next(uint8_t client, gc_wait_t* wait) {
+    char line[16];
+    snprintf(line, sizeof(line), "W%d", gc_visit_order[gc_visit_index]);
+    Error status = gc_execute_line(line, client, wait);
+    if (status != Error::LineDeferred) {
+        gc_visit_index++;
+    }
+    return status;
+}
+
+void gc_visits_clear() {
+    gc_visit_count = 0;
+    gc_visit_index = 0;
+}
+#endif
+
+// Defers a block whose execution needs room in the motion queues that they do not have yet.
+// Returns true if it did. See gc_wait_t.
+static bool gc_defer(gc_wait_t* wait, const gc_wait_t* need) {
+    if (wait == NULL || protocol_wait_over(need)) {
+        return false;
+    }
+    *wait          = *need;
+    wait->deferred = true;
+    return true;
+}
+
 // Executes one line of NUL-terminated G-Code.
 // The line may contain whitespace and comments, which are first removed,
 // and lower case characters, which are converted to upper case.
 // In this function, all units and positions are converted and
 // exported to grbl's internal functions in terms of (mm, mm/min) and absolute machine
 // coordinates, respectively.
-Error gc_execute_line(char* line, uint8_t client) {
+Error gc_execute_line(char* line, uint8_t client, gc_wait_t* wait) {
+    bool retry = wait != NULL && wait->deferred;  // The line was deferred before and has been reported on
     // Step 0 - remove whitespace and comments and convert to upper case
     collapseGCode(line);
 #ifdef REPORT_ECHO_LINE_RECEIVED
-    report_echo_line_received(line, client);
+    if (!retry) {
+        report_echo_line_received(line, client);
+    }
 #endif
 
     /* -------------------------------------------------------------------------------------
@@ -145,7 +218,7 @@ Error gc_execute_line(char* line, uint8_t client) {
     // Initialize command and value words and parser flags variables.
     uint32_t command_words   = 0;  // Tracks G and M command words. Also used for modal group violations.
     uint32_t value_words     = 0;  // Tracks value words.
-    uint8_t  gc_parser_flags = GCParserNone;
+    uint16_t gc_parser_flags = GCParserNone;
     auto     n_axis          = number_axis->get();
     float    coord_data[MAX_N_AXIS];  // Used by WCO-related commands
     uint8_t  pValue;                  // Integer value of P word
@@ -160,6 +233,14 @@ Error gc_execute_line(char* line, uint8_t client) {
         gc_block.values.n = JOG_LINE_NUMBER;  // Initialize default line number reported during jog.
 #endif
     }
+#ifdef ASYNC_AXIS
+    // Async axis lines are G1 by default, and in G94, like jogs. See AsyncAxis.h.
+    if (line[0] == '@') {
+        gc_parser_flags |= GCParserAsyncMotion;
+        gc_block.modal.motion    = Motion::Linear;
+        gc_block.modal.feed_rate = FeedRate::UnitsPerMin;
+    }
+#endif
 
     /* -------------------------------------------------------------------------------------
        STEP 2: Import all g-code words in the block line. A g-code word is a letter followed by
@@ -171,10 +252,12 @@ Error gc_execute_line(char* line, uint8_t client) {
     uint8_t    char_counter;
     char       letter;
     float      value;
-    uint8_t    int_value = 0;
+    uint16_t   int_value = 0;
     uint16_t   mantissa  = 0;
     if (gc_parser_flags & GCParserJogMotion) {
         char_counter = 3;  // Start parsing after `$J=`
+    } else if (gc_parser_flags & GCParserAsyncMotion) {
+        char_counter = 1;  // Start parsing after `@`
     } else {
         char_counter = 0;
     }
@@ -547,6 +630,52 @@ Error gc_execute_line(char* line, uint8_t client) {
                         gc_block.modal.io_control = IoControl::SetAnalogImmediate;
                         mg_word_bit               = ModalGroup::MM10;
                         break;
+                    case 400:
+                        // M400 - Wait for all queued motion to finish, including the async axis queue
+                        gc_block.sync_motion = true;
+                        mg_word_bit          = ModalGroup::MM11;
+                        break;
+#ifdef SYRINGE_AXIS
+                    case 440:
+                        gc_block.modal.z_follow = ZFollow::Enable;
+                        mg_word_bit             = ModalGroup::MM12;
+                        break;
+                    case 441:
+                        gc_block.modal.z_follow = ZFollow::Disable;
+                        mg_word_bit             = ModalGroup::MM12;
+                        break;
+                    case 450:
+                        gc_block.modal.dispense = Dispense::Enable;
+                        mg_word_bit             = ModalGroup::MM13;
+                        break;
+                    case 451:
+                        gc_block.modal.dispense = Dispense::Disable;
+                        mg_word_bit             = ModalGroup::MM13;
+                        break;
+#endif
+#ifdef LABWARE_SLOTS
+                    case 460:
+                        mg_word_bit = ModalGroup::MM14;
+                        break;
+                    case 470:
+                        gc_block.modal.visits = VisitSet::Collect;
+                        mg_word_bit           = ModalGroup::MM15;
+                        break;
+                    case 471:
+                        gc_block.modal.visits = VisitSet::Run;
+                        mg_word_bit           = ModalGroup::MM15;
+                        break;
+#endif
+#ifdef DECK_MAP_ROWS
+                    case 480:
+                        gc_block.modal.deck_travel = DeckTravel::Enable;
+                        mg_word_bit                = ModalGroup::MM16;
+                        break;
+                    case 481:
+                        gc_block.modal.deck_travel = DeckTravel::Disable;
+                        mg_word_bit                = ModalGroup::MM16;
+                        break;
+#endif
                     default:
                         FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported M command]
                 }
@@ -648,7 +777,9 @@ Error gc_execute_line(char* line, uint8_t client) {
                         if (value > MaxToolNumber) {
                             FAIL(Error::GcodeMaxValueExceeded);
                         }
-                        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Tool No: %d", int_value);
+                        if (!retry) {
+                            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Tool No: %d", int_value);
+                        }
                         gc_state.tool = int_value;
                         break;
                     case 'X':
@@ -679,6 +810,12 @@ Error gc_execute_line(char* line, uint8_t client) {
                             FAIL(Error::GcodeUnsupportedCommand);
                         }
                         break;
+#ifdef LABWARE_SLOTS
+                    case 'W':
+                        axis_word_bit     = GCodeWord::W;
+                        gc_block.values.w = trunc(value);
+                        break;
+#endif
                     default:
                         FAIL(Error::GcodeUnsupportedCommand);
                 }
@@ -723,6 +860,30 @@ Error gc_execute_line(char* line, uint8_t client) {
        lines in how it currently works and would require some refactoring to make it compatible.
     */
     // [0. Non-specific/common error-checks and miscellaneous setup]:
+#ifdef LABWARE_SLOTS
+    // While M470 collects a visit set, a line holds a W word only, which is added to the set
+    // instead of executed, or M470/M471.
+    if (gc_state.modal.visits == VisitSet::Collect && bit_isfalse(command_words, bit(ModalGroup::MM15))) {
+        if (command_words || axis_words || bit_isfalse(value_words, bit(GCodeWord::W)) ||
+            (value_words & ~(bit(GCodeWord::N) | bit(GCodeWord::W))) || (gc_parser_flags & (GCParserJogMotion | GCParserAsyncMotion))) {
+            FAIL(Error::GcodeUnsupportedCommand);  // [Not a visit]
+        }
+        if (gc_block.values.w < 0 || gc_block.values.w >= labware[gc_state.labware]->wells()) {
+            FAIL(Error::GcodeInvalidTarget);  // [No such well]
+        }
+        if (!well_order_add(gc_block.values.w)) {
+            FAIL(Error::GcodeMaxValueExceeded);  // [Visit set full]
+        }
+        return Error::Ok;
+    }
+    // A well word stands for the X and Y words of the well, which are filled in with the target.
+    if (bit_istrue(value_words, bit(GCodeWord::W))) {
+        if (axis_words & (bit(X_AXIS) | bit(Y_AXIS))) {
+            FAIL(Error::GcodeAxisCommandConflict);
+        }
+        axis_words |= bit(X_AXIS) | bit(Y_AXIS);
+    }
+#endif
     // Determine implicit axis command conditions. Axis words have been passed, but no explicit axis
     // command has been sent. If so, set axis command to current motion mode.
     if (axis_words) {
@@ -755,6 +916,14 @@ Error gc_execute_line(char* line, uint8_t client) {
         if (gc_block.modal.units == Units::Inches) {
             gc_block.values.f *= MM_PER_INCH;
         }
+#ifdef ASYNC_AXIS
+    } else if (gc_parser_flags & GCParserAsyncMotion) {
+        // Async axis lines carry their own feed rate. G1 without one fails the motion mode checks.
+        // For a volume axis it is in uL/min, converted with the target in STEP 4.
+        if (gc_block.modal.units == Units::Inches && !gc_axis_is_volume(ASYNC_AXIS)) {
+            gc_block.values.f *= MM_PER_INCH;
+        }
+#endif
     } else {
         if (gc_block.modal.feed_rate == FeedRate::InverseTime) {  // = G93
             // NOTE: G38 can also operate in inverse time, but is undefined as an error. Missing F word check added here.
@@ -832,6 +1001,106 @@ Error gc_execute_line(char* line, uint8_t client) {
         bit_false(value_words, bit(GCodeWord::E));
         bit_false(value_words, bit(GCodeWord::Q));
     }
+    // [Labware selection ]: M460 P word missing or not a labware slot.
+    uint8_t labware_slot = gc_state.labware;
+#ifdef LABWARE_SLOTS
+    if (bit_istrue(command_words, bit(ModalGroup::MM14))) {
+        if (bit_isfalse(value_words, bit(GCodeWord::P))) {
+            FAIL(Error::GcodeValueWordMissing);  // [P word missing]
+        }
+        if (gc_block.values.p >= LABWARE_SLOTS) {
+            FAIL(Error::GcodeMaxValueExceeded);
+        }
+        labware_slot = trunc(gc_block.values.p);
+        bit_false(value_words, bit(GCodeWord::P));
+    }
+#endif
+#ifdef LABWARE_SLOTS
+    // [Visit set ]: M470/M471 with axis words. M471 visits the wells as G0/G1 moves.
+    bool visit_run = false;
+    if (bit_istrue(command_words, bit(ModalGroup::MM15))) {
+        if (axis_words) {
+            FAIL(Error::GcodeAxisCommandConflict);
+        }
+        if (gc_block.modal.visits == VisitSet::Run && gc_state.modal.visits == VisitSet::Collect) {
+            if (gc_block.modal.motion != Motion::Seek && gc_block.modal.motion != Motion::Linear) {
+                FAIL(Error::GcodeUnsupportedCommand);  // [Visits need G0/G1]
+            }
+            visit_run = true;
+        }
+    }
+#endif
+#ifdef DECK_MAP_ROWS
+    // [Deck travel ]: M480 without a deck map.
+    if (bit_istrue(command_words, bit(ModalGroup::MM16)) && gc_block.modal.deck_travel == DeckTravel::Enable) {
+        if (!deck_map->valid()) {
+            FAIL(Error::GcodeUnsupportedCommand);  // [No deck map]
+        }
+    }
+#endif
+    // [Z-follow ]: M440 Q word missing or not positive. Without Q, the well cross-section of the active
+    // labware is used. The cross-section carries over to later blocks.
+    float z_follow_area = gc_state.z_follow_area;
+    if (bit_istrue(command_words, bit(ModalGroup::MM12))) {
+        if (gc_block.modal.z_follow == ZFollow::Enable) {
+            if (bit_istrue(value_words, bit(GCodeWord::Q))) {
+                z_follow_area = gc_block.values.q;
+                bit_false(value_words, bit(GCodeWord::Q));
+            } else {
+#ifdef LABWARE_SLOTS
+                z_follow_area = labware[labware_slot]->get()->well_area;
+#else
+                z_follow_area = 0.0;
+#endif
+                if (z_follow_area <= 0.0) {
+                    FAIL(Error::GcodeValueWordMissing);  // [Q word missing]
+                }
+            }
+            if (z_follow_area <= 0.0) {
+                FAIL(Error::NegativeValue);
+            }
+            if (z_follow_area > Z_FOLLOW_MAX_AREA) {
+                FAIL(Error::GcodeMaxValueExceeded);
+            }
+        } else {
+            z_follow_area = 0.0;
+        }
+    }
+    // [Multi-dispense ]: M450 Q word missing or not positive. R (blend length) and P (stroke feed rate)
+    // are optional. The settings carry over to later blocks.
+    float dispense_volume = gc_state.dispense_volume;
+    float dispense_blend  = gc_state.dispense_blend;
+    float dispense_rate   = gc_state.dispense_rate;
+    bool  dispense_block  = false;  // Set below, if this block travels to a well and dispenses into it.
+    if (bit_istrue(command_words, bit(ModalGroup::MM13))) {
+        if (gc_block.modal.dispense == Dispense::Enable) {
+            if (bit_isfalse(value_words, bit(GCodeWord::Q))) {
+                FAIL(Error::GcodeValueWordMissing);  // [Q word missing]
+            }
+            if (gc_block.values.q <= 0.0) {
+                FAIL(Error::NegativeValue);
+            }
+#ifdef SYRINGE_AXIS
+            float capacity = syringe_capacity();
+            if (capacity > 0.0 && gc_block.values.q > capacity) {
+                FAIL(Error::GcodeMaxValueExceeded);  // [More than the syringe holds]
+            }
+#endif
+            dispense_volume = gc_block.values.q;
+            dispense_blend  = bit_istrue(value_words, bit(GCodeWord::R)) ? gc_block.values.r : DISPENSE_BLEND_LENGTH;
+            dispense_rate   = bit_istrue(value_words, bit(GCodeWord::P)) ? gc_block.values.p : 0.0;
+            if (dispense_blend < 0.0) {
+                FAIL(Error::NegativeValue);
+            }
+            if (gc_block.modal.units == Units::Inches) {
+                dispense_blend *= MM_PER_INCH;
+                dispense_rate *= MM_PER_INCH;
+            }
+            bit_false(value_words, (bit(GCodeWord::Q) | bit(GCodeWord::R) | bit(GCodeWord::P)));
+        } else {
+            dispense_volume = 0.0;
+        }
+    }
     // [11. Set active plane ]: N/A
     switch (gc_block.modal.plane_select) {
         case Plane::XY:
@@ -855,7 +1124,7 @@ Error gc_execute_line(char* line, uint8_t client) {
     uint8_t idx;
     if (gc_block.modal.units == Units::Inches) {
         for (idx = 0; idx < n_axis; idx++) {  // Axes indices are consistent, so loop may be used.
-            if (bit_istrue(axis_words, bit(idx))) {
+            if (bit_istrue(axis_words, bit(idx)) && !gc_axis_is_volume(idx)) {
                 gc_block.values.xyz[idx] *= MM_PER_INCH;
             }
         }
@@ -902,6 +1171,20 @@ Error gc_execute_line(char* line, uint8_t client) {
     // commands all treat axis words differently. G10 as absolute offsets or computes current position as
     // the axis value, G92 similarly to G10 L20, and G28/30 as an intermediate target position that observes
     // all the current coordinate system and G92 offsets.
+#ifdef LABWARE_SLOTS
+    // [Well word G10/G92 Errors]: Wells are only motion targets.
+    if ((gc_block.non_modal_command == NonModal::SetCoordinateData || gc_block.non_modal_command == NonModal::SetCoordinateOffset) &&
+        bit_istrue(value_words, bit(GCodeWord::W))) {
+        FAIL(Error::GcodeUnsupportedCommand);
+    }
+#endif
+#ifdef SYRINGE_AXIS
+    // [Volumetric G10/G92 Errors]: Work offsets don't apply to syringe volumes, so they can't be set.
+    if ((gc_block.non_modal_command == NonModal::SetCoordinateData || gc_block.non_modal_command == NonModal::SetCoordinateOffset) &&
+        bit_istrue(axis_words, bit(SYRINGE_AXIS)) && gc_axis_is_volume(SYRINGE_AXIS)) {
+        FAIL(Error::GcodeUnsupportedCommand);
+    }
+#endif
     switch (gc_block.non_modal_command) {
         case NonModal::SetCoordinateData:
             // [G10 Errors]: L missing and is not 2 or 20. P word missing. (Negative P value done.)
@@ -984,6 +1267,15 @@ Error gc_execute_line(char* line, uint8_t client) {
                     for (idx = 0; idx < n_axis; idx++) {  // Axes indices are consistent, so loop may be used to save flash space.
                         if (bit_isfalse(axis_words, bit(idx))) {
                             gc_block.values.xyz[idx] = gc_state.position[idx];  // No axis word in block. Keep same axis position.
+#ifdef SYRINGE_AXIS
+                        } else if (gc_axis_is_volume(idx)) {
+                            // Volumes are absolute in the syringe, so only the distance mode applies.
+                            float volume = gc_block.values.xyz[idx];
+                            if (gc_block.non_modal_command != NonModal::AbsoluteOverride && gc_block.modal.distance == Distance::Incremental) {
+                                volume += syringe_mm_to_ul(gc_state.position[idx]);
+                            }
+                            gc_block.values.xyz[idx] = syringe_ul_to_mm(volume);
+#endif
                         } else {
                             // Update specified value according to distance mode or ignore if absolute override is active.
                             // NOTE: G53 is never active with G28/30 since they are in the same modal group.
@@ -1002,6 +1294,38 @@ Error gc_execute_line(char* line, uint8_t client) {
                     }
                 }
             }
+#ifdef LABWARE_SLOTS
+            // Well word: The X and Y of the well, in machine coordinates, from the precomputed well positions.
+            if (bit_istrue(value_words, bit(GCodeWord::W))) {
+                if (!labware[labware_slot]->wellPosition(gc_block.values.w, &gc_block.values.xyz[X_AXIS], &gc_block.values.xyz[Y_AXIS])) {
+                    FAIL(Error::GcodeInvalidTarget);  // [No such well]
+                }
+                bit_false(value_words, bit(GCodeWord::W));
+            }
+#endif
+#ifdef SYRINGE_AXIS
+            // Z-follow: A G0/G1 that moves the syringe without a Z word moves Z with the liquid surface,
+            // down by the aspirated volume over the cross-section. Jogs and '@' lines don't follow.
+            if (z_follow_area > 0.0 && axis_command == AxisCommand::MotionMode &&
+                (gc_block.modal.motion == Motion::Seek || gc_block.modal.motion == Motion::Linear) &&
+                bit_istrue(axis_words, bit(SYRINGE_AXIS)) && bit_isfalse(axis_words, bit(Z_AXIS)) &&
+                !(gc_parser_flags & (GCParserJogMotion | GCParserAsyncMotion))) {
+                float aspirated =
+                    syringe_mm_to_ul(gc_block.values.xyz[SYRINGE_AXIS]) - syringe_mm_to_ul(gc_state.position[SYRINGE_AXIS]);
+                gc_block.values.xyz[Z_AXIS] = gc_state.position[Z_AXIS] - aspirated / z_follow_area;
+            }
+            // Multi-dispense: Each G0/G1 is the travel to a well, and gets the stroke that dispenses into it.
+            if (dispense_volume > 0.0 && axis_command == AxisCommand::MotionMode &&
+                (gc_block.modal.motion == Motion::Seek || gc_block.modal.motion == Motion::Linear) &&
+                !(gc_parser_flags & (GCParserJogMotion | GCParserAsyncMotion))) {
+                if (bit_istrue(axis_words, bit(SYRINGE_AXIS))) {
+                    FAIL(Error::GcodeAxisCommandConflict);  // [Syringe word while dispensing]
+                }
+                dispense_block = true;
+                gc_block.values.xyz[SYRINGE_AXIS] =
+                    syringe_ul_to_mm(syringe_mm_to_ul(gc_state.position[SYRINGE_AXIS]) - dispense_volume);
+            }
+#endif
             // Check remaining non-modal commands for errors.
             switch (gc_block.non_modal_command) {
                 case NonModal::GoHome0:  // G28
@@ -1044,6 +1368,9 @@ Error gc_execute_line(char* line, uint8_t client) {
             }
     }
     // [20. Motion modes ]:
+    float   probe_retract   = 0.0;  // Back-off for the slow touches of a two-phase probe, 0 for a single touch
+    float   probe_slow_rate = 0.0;  // Feed rate of the slow touches, 0 for the default
+    uint8_t probe_touches   = 1;    // Slow touches averaged
     if (gc_block.modal.motion == Motion::None) {
         // [G80 Errors]: Axis word are programmed while G80 is active.
         // NOTE: Even non-modal commands or TLO that use axis words will throw this strict error.
@@ -1240,6 +1567,34 @@ Error gc_execute_line(char* line, uint8_t client) {
                     if (isequal_position_vector(gc_state.position, gc_block.values.xyz)) {
                         FAIL(Error::GcodeInvalidTarget);  // [Invalid target]
                     }
+                    // [Two-phase probe Errors]: Probing away. R (back-off) or P (slow feed rate) not positive.
+                    //   L (touches) out of range.
+                    if (bit_istrue(value_words, bit(GCodeWord::R))) {
+                        if (gc_parser_flags & GCParserProbeIsAway) {
+                            FAIL(Error::GcodeUnsupportedCommand);  // [Two-phase G38.4/G38.5]
+                        }
+                        probe_retract = gc_block.values.r;
+                        if (bit_istrue(value_words, bit(GCodeWord::P))) {
+                            probe_slow_rate = gc_block.values.p;
+                            if (probe_slow_rate <= 0.0) {
+                                FAIL(Error::NegativeValue);
+                            }
+                        }
+                        if (bit_istrue(value_words, bit(GCodeWord::L))) {
+                            probe_touches = gc_block.values.l;
+                        }
+                        if (probe_retract <= 0.0) {
+                            FAIL(Error::NegativeValue);
+                        }
+                        if (probe_touches < 1 || probe_touches > PROBE_MAX_TOUCHES) {
+                            FAIL(Error::GcodeMaxValueExceeded);
+                        }
+                        if (gc_block.modal.units == Units::Inches) {
+                            probe_retract *= MM_PER_INCH;
+                            probe_slow_rate *= MM_PER_INCH;
+                        }
+                        bit_false(value_words, (bit(GCodeWord::R) | bit(GCodeWord::P) | bit(GCodeWord::L)));
+                    }
                     break;
             }
         }
@@ -1247,7 +1602,7 @@ Error gc_execute_line(char* line, uint8_t client) {
     // [21. Program flow ]: No error checks required.
     // [0. Non-specific error-checks]: Complete unused value words check, i.e. IJK used when in arc
     // radius mode, or axis words that aren't used in the block.
-    if (gc_parser_flags & GCParserJogMotion) {
+    if (gc_parser_flags & (GCParserJogMotion | GCParserAsyncMotion)) {
         // Jogging only uses the F feed rate and XYZ value words. N is valid, but S and T are invalid.
         bit_false(value_words, (bit(GCodeWord::N) | bit(GCodeWord::F)));
     } else {
@@ -1296,6 +1651,43 @@ Error gc_execute_line(char* line, uint8_t client) {
         // JogCancelled is not reported as a GCode error
         return status == Error::JogCancelled ? Error::Ok : status;
     }
+#ifdef ASYNC_AXIS
+    // Queue async axis lines to the async queue. Like jogs, they only update the parser position.
+    if (gc_parser_flags & GCParserAsyncMotion) {
+        // Only G0/G1, distance and unit modal commands and G53 are allowed, on the async axis alone.
+        if (command_words & ~(bit(ModalGroup::MG0) | bit(ModalGroup::MG1) | bit(ModalGroup::MG3) | bit(ModalGroup::MG6))) {
+            FAIL(Error::InvalidAsyncCommand);
+        }
+        if (!(gc_block.non_modal_command == NonModal::AbsoluteOverride || gc_block.non_modal_command == NonModal::NoAction)) {
+            FAIL(Error::InvalidAsyncCommand);
+        }
+        if (!(gc_block.modal.motion == Motion::Seek || gc_block.modal.motion == Motion::Linear) || (axis_words & ~bit(ASYNC_AXIS))) {
+            FAIL(Error::InvalidAsyncCommand);
+        }
+        if (!axis_words) {
+            FAIL(Error::GcodeNoAxisWords);
+        }
+#    ifdef SYRINGE_AXIS
+        if (gc_axis_is_volume(ASYNC_AXIS)) {
+            // uL/min to mm/min, over the whole move
+            float volume = fabs(syringe_mm_to_ul(gc_block.values.xyz[ASYNC_AXIS]) - syringe_mm_to_ul(gc_state.position[ASYNC_AXIS]));
+            if (volume > 0.0) {
+                gc_block.values.f *= fabs(gc_block.values.xyz[ASYNC_AXIS] - gc_state.position[ASYNC_AXIS]) / volume;
+            }
+        }
+#    endif
+        gc_wait_t need  = {};
+        need.async_room = true;
+        if (gc_defer(wait, &need)) {
+            return Error::LineDeferred;
+        }
+        Error status = async_execute(&gc_block);
+        if (status == Error::Ok) {
+            gc_state.position[ASYNC_AXIS] = gc_block.values.xyz[ASYNC_AXIS];
+        }
+        return status;
+    }
+#endif
     // If in laser mode, setup laser power based on current and past parser conditions.
     if (spindle->inLaserMode()) {
         if (!((gc_block.modal.motion == Motion::Linear) || (gc_block.modal.motion == Motion::CwArc) ||
@@ -1325,6 +1717,80 @@ Error gc_execute_line(char* line, uint8_t client) {
             }
         }
     }
+    // Defer the block until the motion queues have the room its execution needs, rather than wait
+    // for it in here. Nothing of the block has been executed yet.
+    if (wait != NULL) {
+        gc_wait_t need = {};
+        // Spindle, coolant, synced I/O, M400, G4, M6, M0/M2/M30 and probes sync with the motion first.
+        need.drain = gc_block.modal.spindle != gc_state.modal.spindle || gc_block.coolant != GCodeCoolant::None ||
+                     gc_block.modal.io_control == IoControl::DigitalOnSync || gc_block.modal.io_control == IoControl::DigitalOffSync ||
+                     gc_block.modal.io_control == IoControl::SetAnalogSync || gc_block.sync_motion ||
+                     gc_block.non_modal_command == NonModal::Dwell || gc_block.modal.tool_change == ToolChange::Enable ||
+                     gc_block.modal.program_flow == ProgramFlow::Paused || gc_block.modal.program_flow == ProgramFlow::CompletedM2 ||
+                     gc_block.modal.program_flow == ProgramFlow::CompletedM30;
+        if ((gc_state.spindle_speed != gc_block.values.s || bit_istrue(gc_parser_flags, GCParserLaserForceSync)) &&
+            gc_state.modal.spindle != SpindleState::Disable && bit_isfalse(gc_parser_flags, GCParserLaserIsMotion)) {
+            need.drain = true;
+        }
+#ifdef ENABLE_PARKING_OVERRIDE_CONTROL
+        if (gc_state.modal.override != gc_block.modal.override) {
+            need.drain = true;
+        }
+#endif
+        bool go_home = gc_block.non_modal_command == NonModal::GoHome0 || gc_block.non_modal_command == NonModal::GoHome1;
+        if (go_home) {
+            need.planner_blocks = axis_command != AxisCommand::None ? 2 : 1;
+        } else if (gc_block.modal.motion != Motion::None && axis_command == AxisCommand::MotionMode) {
+            need.planner_blocks = 1;
+            switch (gc_block.modal.motion) {
+                case Motion::Seek:
+#ifdef DECK_MAP_ROWS
+                    if (!dispense_block && gc_block.modal.deck_travel == DeckTravel::Enable &&
+                        (gc_block.values.xyz[X_AXIS] != gc_state.position[X_AXIS] || gc_block.values.xyz[Y_AXIS] != gc_state.position[Y_AXIS])) {
+                        need.planner_blocks = mc_deck_travel_blocks(gc_block.values.xyz, gc_state.position);
+                    }
+#endif
+                    break;
+                case Motion::CwArc:
+                case Motion::CcwArc:
+                    need.planner_blocks = mc_arc_blocks(gc_block.values.xyz,
+                                                        gc_state.position,
+                                                        gc_block.values.ijk,
+                                                        gc_block.values.r,
+                                                        axis_0,
+                                                        axis_1,
+                                                        bit_istrue(gc_parser_flags, GCParserArcIsClockwise));
+                    break;
+                case Motion::Linear:
+                    break;
+                default:  // Probes
+                    need.drain = true;
+                    break;
+            }
+#ifdef SYRINGE_AXIS
+            if (dispense_block) {
+                bool deck_travel = false;
+#    ifdef DECK_MAP_ROWS
+                deck_travel = gc_block.modal.motion == Motion::Seek && gc_block.modal.deck_travel == DeckTravel::Enable;
+#    endif
+                need.planner_blocks = mc_dispense_blocks(gc_block.values.xyz, gc_state.position, dispense_blend, deck_travel);
+            }
+#endif
+        }
+#ifdef ASYNC_AXIS
+        // mc_line() lets the async queue finish before a block moves the async axis.
+        if (need.planner_blocks > 0) {
+            float async_end = go_home ? coord_data[ASYNC_AXIS] : gc_block.values.xyz[ASYNC_AXIS];
+            if (async_end != gc_state.position[ASYNC_AXIS] ||
+                (go_home && axis_command != AxisCommand::None && gc_block.values.xyz[ASYNC_AXIS] != gc_state.position[ASYNC_AXIS])) {
+                need.async_idle = true;
+            }
+        }
+#endif
+        if (gc_defer(wait, &need)) {
+            return Error::LineDeferred;
+        }
+    }
     // [0. Non-specific/common error-checks and miscellaneous setup]:
     // NOTE: If no line number is present, the value is zero.
     gc_state.line_number = gc_block.values.n;
@@ -1431,6 +1897,29 @@ Error gc_execute_line(char* line, uint8_t client) {
         mc_override_ctrl_update(gc_state.modal.override);
     }
 #endif
+    // Wait for the motion queues to drain.
+    if (gc_block.sync_motion) {
+        protocol_buffer_synchronize();
+    }
+    // Set the labware W words address.
+    gc_state.labware = labware_slot;
+#ifdef LABWARE_SLOTS
+    // Start collecting a visit set.
+    if (bit_istrue(command_words, bit(ModalGroup::MM15)) && gc_block.modal.visits == VisitSet::Collect) {
+        well_order_clear();
+    }
+    gc_state.modal.visits = gc_block.modal.visits;
+#endif
+    // Set the deck travel mode.
+    gc_state.modal.deck_travel = gc_block.modal.deck_travel;
+    // Set the Z-follow cross-section.
+    gc_state.modal.z_follow = gc_block.modal.z_follow;
+    gc_state.z_follow_area  = z_follow_area;
+    // Set the multi-dispense volume and stroke.
+    gc_state.modal.dispense  = gc_block.modal.dispense;
+    gc_state.dispense_volume = dispense_volume;
+    gc_state.dispense_blend  = dispense_blend;
+    gc_state.dispense_rate   = dispense_rate;
     // [10. Dwell ]:
     if (gc_block.non_modal_command == NonModal::Dwell) {
         mc_dwell(int32_t(gc_block.values.p * 1000.0f));
@@ -1514,13 +2003,33 @@ Error gc_execute_line(char* line, uint8_t client) {
     if (gc_state.modal.motion != Motion::None) {
         if (axis_command == AxisCommand::MotionMode) {
             GCUpdatePos gc_update_pos = GCUpdatePos::Target;
-            if (gc_state.modal.motion == Motion::Linear) {
+#ifdef SYRINGE_AXIS
+            if (dispense_block) {
+                if (gc_state.modal.motion == Motion::Seek) {
+                    pl_data->motion.rapidMotion = 1;  // Set rapid motion flag.
+                }
+                limitsCheckSoft(gc_block.values.xyz);
+                bool deck_travel = false;
+#    ifdef DECK_MAP_ROWS
+                deck_travel = gc_state.modal.motion == Motion::Seek && gc_state.modal.deck_travel == DeckTravel::Enable;
+#    endif
+                mc_dispense(gc_block.values.xyz, pl_data, gc_state.position, dispense_blend, dispense_rate, deck_travel);
+            } else
+#endif
+                if (gc_state.modal.motion == Motion::Linear) {
                 limitsCheckSoft(gc_block.values.xyz);
                 cartesian_to_motors(gc_block.values.xyz, pl_data, gc_state.position);
             } else if (gc_state.modal.motion == Motion::Seek) {
                 pl_data->motion.rapidMotion = 1;  // Set rapid motion flag.
                 limitsCheckSoft(gc_block.values.xyz);
-                cartesian_to_motors(gc_block.values.xyz, pl_data, gc_state.position);
+#ifdef DECK_MAP_ROWS
+                // Deck travel: Lift Z only as far as the deck needs on the way to a new XY position.
+                if (gc_state.modal.deck_travel == DeckTravel::Enable &&
+                    (gc_block.values.xyz[X_AXIS] != gc_state.position[X_AXIS] || gc_block.values.xyz[Y_AXIS] != gc_state.position[Y_AXIS])) {
+                    mc_deck_travel(gc_block.values.xyz, pl_data, gc_state.position);
+                } else
+#endif
+                    cartesian_to_motors(gc_block.values.xyz, pl_data, gc_state.position);
             } else if ((gc_state.modal.motion == Motion::CwArc) || (gc_state.modal.motion == Motion::CcwArc)) {
                 mc_arc(gc_block.values.xyz,
                        pl_data,
@@ -1537,7 +2046,12 @@ Error gc_execute_line(char* line, uint8_t client) {
 #ifndef ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES
                 pl_data->motion.noFeedOverride = 1;
 #endif
-                gc_update_pos = mc_probe_cycle(gc_block.values.xyz, pl_data, gc_parser_flags);
+                if (probe_retract > 0.0) {
+                    gc_update_pos =
+                        mc_probe_two_phase(gc_block.values.xyz, pl_data, gc_parser_flags, probe_retract, probe_slow_rate, probe_touches);
+                } else {
+                    gc_update_pos = mc_probe_cycle(gc_block.values.xyz, pl_data, gc_parser_flags);
+                }
             }
             // As far as the parser is concerned, the position is now == target. In reality the
             // motion control system might still be processing the action and the real tool position
@@ -1583,6 +2097,11 @@ Error gc_execute_line(char* line, uint8_t client) {
             gc_state.modal.coord_select = CoordIndex::G54;
             gc_state.modal.spindle      = SpindleState::Disable;
             gc_state.modal.coolant      = {};
+            gc_state.modal.z_follow     = ZFollow::Disable;
+            gc_state.z_follow_area      = 0.0;
+            gc_state.modal.dispense     = Dispense::Disable;
+            gc_state.dispense_volume    = 0.0;
+            gc_state.modal.deck_travel  = DeckTravel::Disable;
 #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
 #    ifdef DEACTIVATE_PARKING_UPON_INIT
             gc_state.modal.override = Override::Disabled;
@@ -1608,6 +2127,13 @@ Error gc_execute_line(char* line, uint8_t client) {
             break;
     }
     gc_state.modal.program_flow = ProgramFlow::Running;  // Reset program flow.
+#ifdef LABWARE_SLOTS
+    // [22. Visit set ]: M471 visits the collected wells in travel order. This comes last, as the
+    // visits run after the block, as W lines of their own.
+    if (visit_run) {
+        return gc_visit_wells();
+    }
+#endif
 
     // TODO: % to denote start of program.
     return Error::Ok;
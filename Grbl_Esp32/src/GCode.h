@@ -49,6 +49,12 @@ enum class ModalGroup : uint8_t {
     MM8  = 13,  // [M7,M8,M9] Coolant control
     MM9  = 14,  // [M56] Override control
     MM10 = 15,  // [M62, M63, M64, M65, M67, M68] User Defined http://linuxcnc.org/docs/html/gcode/overview.html#_modal_groups
+    MM11 = 16,  // [M400] Motion queue sync
+    MM12 = 17,  // [M440,M441] Syringe Z-follow
+    MM13 = 18,  // [M450,M451] Multi-dispense
+    MM14 = 19,  // [M460] Labware selection
+    MM15 = 20,  // [M470,M471] Visit set
+    MM16 = 21,  // [M480,M481] Deck travel
 };
 
 // Command actions for within execution-type modal groups (motion, stopping, non-modal). Used
@@ -176,6 +182,30 @@ enum class IoControl : uint8_t {
 
 static const int MaxUserDigitalPin = 4;
 
+// Modal Group M12: Syringe Z-follow
+enum class ZFollow : uint8_t {
+    Disable = 0,  // M441 (Default: Must be zero)
+    Enable  = 1,  // M440
+};
+
+// Modal Group M13: Multi-dispense
+enum class Dispense : uint8_t {
+    Disable = 0,  // M451 (Default: Must be zero)
+    Enable  = 1,  // M450
+};
+
+// Modal Group M15: Visit set
+enum class VisitSet : uint8_t {
+    Run     = 0,  // M471 (Default: Must be zero)
+    Collect = 1,  // M470
+};
+
+// Modal Group M16: Deck travel
+enum class DeckTravel : uint8_t {
+    Disable = 0,  // M481 (Default: Must be zero)
+    Enable  = 1,  // M480
+};
+
 // Modal Group G8: Tool length offset
 enum class ToolLengthOffset : uint8_t {
     Cancel        = 0,  // G49 (Default: Must be zero)
@@ -210,6 +240,7 @@ enum class GCodeWord : uint8_t {
     A = 15,
     B = 16,
     C = 17,
+    W = 18,
 };
 
 // GCode parser position updating flags
@@ -230,6 +261,7 @@ enum GCParserFlags {
     GCParserLaserForceSync = bit(5),
     GCParserLaserDisable   = bit(6),
     GCParserLaserIsMotion  = bit(7),
+    GCParserAsyncMotion    = bit(8),
 };
 
 // Various places in the code access saved coordinate system data
@@ -276,6 +308,10 @@ typedef struct {
     ToolChange   tool_change;   // {M6}
     IoControl    io_control;    // {M62, M63, M67}
     Override     override;      // {M56}
+    ZFollow      z_follow;      // {M440,M441}
+    Dispense     dispense;      // {M450,M451}
+    VisitSet     visits;        // {M470,M471}
+    DeckTravel   deck_travel;   // {M480,M481}
 } gc_modal_t;
 
 typedef struct {
@@ -290,6 +326,7 @@ typedef struct {
     float   s;                // Spindle speed
     uint8_t t;                // Tool selection
     float   xyz[MAX_N_AXIS];  // X,Y,Z Translational axes
+    int32_t w;                // Well index in the active labware
 } gc_values_t;
 
 typedef struct {
@@ -306,7 +343,12 @@ typedef struct {
     // position in mm. Loaded from non-volatile storage when called.
     float coord_offset[MAX_N_AXIS];  // Retains the G92 coordinate offset (work coordinates) relative to
     // machine zero in mm. Non-persistent. Cleared upon reset and boot.
-    float tool_length_offset;  // Tracks tool length offset value when enabled.
+    float   tool_length_offset;  // Tracks tool length offset value when enabled.
+    float   z_follow_area;       // Liquid cross-section (mm^2) Z follows while M440 is active.
+    float   dispense_volume;     // Volume (uL) dispensed at each well while M450 is active.
+    float   dispense_blend;      // Length (mm) of travel the dispense stroke is blended into.
+    float   dispense_rate;       // Feed rate (mm/min) of the dispense stroke, 0 for the travel feed rate.
+    uint8_t labware;             // Labware slot W words address (M460 P).
 } parser_state_t;
 extern parser_state_t gc_state;
 
@@ -315,6 +357,7 @@ typedef struct {
     gc_modal_t   modal;
     gc_values_t  values;
     GCodeCoolant coolant;
+    bool         sync_motion;  // M400
 } parser_block_t;
 
 enum class AxisCommand : uint8_t {
@@ -324,11 +367,33 @@ enum class AxisCommand : uint8_t {
     ToolLengthOffset = 3,
 };
 
+// Room in the motion queues a block needs, so its execution does not wait in mc_line() or in a
+// buffer sync while protocol_main_loop() and every other client wait behind it.
+typedef struct {
+    uint16_t planner_blocks;  // Free planner blocks for its motion
+    bool     drain;           // Empty motion queues, for M0/M2/M30, M6, M400, G4, probes, synced I/O, spindle and coolant
+    bool     async_room;      // Room in the async axis queue, for an '@' line
+    bool     async_idle;      // An idle async axis queue, for a planner motion that moves the axis
+    bool     deferred;        // Set once the line has been deferred, so its messages are not repeated
+} gc_wait_t;
+
 // Initialize the parser
 void gc_init();
 
 // Execute one block of rs275/ngc/g-code
-Error gc_execute_line(char* line, uint8_t client);
+// With wait, a block that would wait for room in the motion queues is not executed. It returns
+// Error::LineDeferred with the room it needs in *wait, and runs once protocol_wait_over(wait).
+// A zeroed wait goes with the first attempt at a line.
+Error gc_execute_line(char* line, uint8_t client, gc_wait_t* wait = NULL);
+
+#ifdef LABWARE_SLOTS
+// An M471 hands its ordered visit set to protocol_main_loop(), which runs one well per pass with
+// gc_visit_next() while gc_visits_pending(), and holds back the M471 status and any other g-code
+// line until the set is done.
+bool  gc_visits_pending();
+Error gc_visit_next(uint8_t client, gc_wait_t* wait);  // Runs the next well as a W line of its own
+void  gc_visits_clear();
+#endif
 
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
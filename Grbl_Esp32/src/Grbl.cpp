@@ -38,9 +38,11 @@ void grbl_init() {
 #ifdef MACHINE_NAME
     report_machine_type(CLIENT_SERIAL);
 #endif
-    settings_init();  // Load Grbl settings from non-volatile storage
-    stepper_init();   // Configure stepper pins and interrupt timers
-    system_ini();     // Configure pinout pins and pin-change interrupt (Renamed due to conflict with esp32 files)
+    settings_init();   // Load Grbl settings from non-volatile storage
+    client_rx_init();  // Allocate the client receive buffers and start reading the clients
+    plan_init();       // Allocate the planner buffer
+    stepper_init();    // Configure stepper pins and interrupt timers
+    system_ini();      // Configure pinout pins and pin-change interrupt (Renamed due to conflict with esp32 files)
     init_motors();
     memset(sys_position, 0, sizeof(sys_position));  // Clear machine position.
     machine_init();                                 // weak definition in Grbl.cpp does nothing
@@ -100,7 +102,7 @@ static void reset_variables() {
     limits_init();
     probe_init();
     plan_reset();  // Clear block buffer and planner variables
-    st_reset();    // Clear stepper subsystem variables
+    st_reset();    // Clear stepper subsystem variables, and the async axis queue with them
     // Sync cleared gcode and planner positions to current system position.
     plan_sync_position();
     gc_sync_position();
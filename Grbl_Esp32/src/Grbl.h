@@ -53,15 +53,20 @@ const char* const GRBL_VERSION_BUILD = "20211103";
 #include "Protocol.h"
 #include "Uart.h"
 #include "Serial.h"
+#include "ClientBuffer.h"
+#include "UsbClient.h"
 #include "Report.h"
 #include "Pins.h"
 #include "Spindles/Spindle.h"
 #include "Motors/Motors.h"
 #include "Stepper.h"
 #include "Jog.h"
+#include "AsyncAxis.h"
+#include "Syringe.h"
 #include "WebUI/InputBuffer.h"
 #include "Settings.h"
 #include "SettingsDefinitions.h"
+#include "WellOrder.h"
 #include "WebUI/WebSettings.h"
 
 #include "UserOutput.h"
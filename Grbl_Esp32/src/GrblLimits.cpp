@@ -73,7 +73,9 @@ void IRAM_ATTR isr_limit_switches() {
 // completing. Homing is a special motion case, which involves rapid uncontrolled stops to locate
 // the trigger point of the limit switches. The rapid stops are handled by a system level axis lock
 // mask, which prevents the stepper algorithm from executing step pulses. Homing motions typically
-// circumvent the processes for executing motions in normal operation.
+// circumvent the processes for executing motions in normal operation. The axes of the cycle share
+// each phase: in the seek and locate phases every axis locks out as its own switch trips, and the
+// phase ends once they all have, so one debounce delay covers all of them.
 // NOTE: Only the abort realtime command can interrupt this process.
 // TODO: Move limit pin-specific calls to a general function for portability.
 void limits_go_home(uint8_t cycle_mask) {
@@ -29,45 +29,76 @@
 #include "I2SOut_ESP32S3.h"
 
 // Forward ESP32-S3 shift register functions to standard I2S interface
-int i2s_out_init(i2s_out_init_t& init_param) { 
-    return i2s_shift_reg_init(); 
+int i2s_out_init(i2s_out_init_t& init_param) {
+    int ret = i2s_shift_reg_init(init_param.ws_pin, init_param.bck_pin, init_param.data_pin, init_param.init_val);
+    if (ret == 0) {
+        i2s_shift_reg_set_pulse_period(init_param.pulse_period);
+        if (init_param.pulse_func != NULL) {
+            i2s_shift_reg_set_pulse_callback(init_param.pulse_func);
+        }
+    }
+    return ret;
 }
 
 int i2s_out_init() { 
     return i2s_shift_reg_init(); 
 }
 
-uint8_t i2s_out_read(uint8_t pin) { 
-    if (pin >= I2S_OUT_PIN_BASE && pin < I2S_OUT_PIN_BASE + I2S_SHIFT_REG_TOTAL_BITS) {
-        return i2s_shift_reg_read(pin - I2S_OUT_PIN_BASE) ? 1 : 0;
+uint8_t IRAM_ATTR i2s_out_read(uint8_t pin) {
+    if (pin < I2S_SHIFT_REG_TOTAL_BITS) {
+        return i2s_shift_reg_read(pin) ? 1 : 0;
     }
     return 0; 
 }
 
-void i2s_out_write(uint8_t pin, uint8_t val) {
-    if (pin >= I2S_OUT_PIN_BASE && pin < I2S_OUT_PIN_BASE + I2S_SHIFT_REG_TOTAL_BITS) {
-        i2s_shift_reg_write(pin - I2S_OUT_PIN_BASE, val != 0);
+void IRAM_ATTR i2s_out_write(uint8_t pin, uint8_t val) {
+    if (pin < I2S_SHIFT_REG_TOTAL_BITS) {
+        i2s_shift_reg_write(pin, val != 0);
     }
 }
 
-uint32_t i2s_out_push_sample(uint32_t usec) { 
-    // For ESP32-S3, this is handled internally by the I2S driver
-    return 0; 
+void IRAM_ATTR i2s_out_write_mask(uint32_t set_mask, uint32_t clear_mask) {
+    i2s_shift_reg_write_mask(set_mask, clear_mask);
 }
 
-int i2s_out_set_passthrough() { return 0; }
-int i2s_out_set_stepping() { return 0; }
-void i2s_out_delay() {}
-int i2s_out_set_pulse_period(uint32_t usec) { return 0; }
-int i2s_out_set_pulse_callback(i2s_out_pulse_func_t func) { return 0; }
+uint32_t IRAM_ATTR i2s_out_push_sample(uint32_t usec) {
+    return i2s_shift_reg_stream_push(usec);
+}
+
+int IRAM_ATTR i2s_out_set_passthrough() {
+    return i2s_shift_reg_set_passthrough();
+}
+
+int IRAM_ATTR i2s_out_set_stepping() {
+    return i2s_shift_reg_set_stepping();
+}
+
+void i2s_out_delay() {
+    i2s_shift_reg_delay();
+}
+
+int IRAM_ATTR i2s_out_set_pulse_period(uint32_t usec) {
+    return i2s_shift_reg_set_pulse_period(usec);
+}
+
+int i2s_out_set_pulse_callback(i2s_out_pulse_func_t func) {
+    return i2s_shift_reg_set_pulse_callback(func);
+}
+
+int i2s_out_reset() {
+    return i2s_shift_reg_reset();
+}
+
+i2s_out_pulser_status_t IRAM_ATTR i2s_out_get_pulser_status() {
+    return i2s_shift_reg_get_pulser_status();
+}
 
-int i2s_out_reset() { 
-    return i2s_shift_reg_deinit(); 
+uint32_t i2s_out_get_underruns() {
+    return i2s_shift_reg_get_underruns();
 }
 
-i2s_out_pulser_status_t i2s_out_get_pulser_status() {
-    // Return PASSTHROUGH for ESP32-S3 shift register mode
-    return PASSTHROUGH;
+uint32_t IRAM_ATTR i2s_out_get_lead_usec() {
+    return i2s_shift_reg_get_lead_usec();
 }
 
 #else // ESP32 classic - provide stubs for now
@@ -80,6 +111,7 @@ int i2s_out_init(i2s_out_init_t& init_param) { return 0; }
 int i2s_out_init() { return 0; }
 uint8_t i2s_out_read(uint8_t pin) { return 0; }
 void i2s_out_write(uint8_t pin, uint8_t val) {}
+void i2s_out_write_mask(uint32_t set_mask, uint32_t clear_mask) {}
 uint32_t i2s_out_push_sample(uint32_t usec) { return 0; }
 int i2s_out_set_passthrough() { return 0; }
 int i2s_out_set_stepping() { return 0; }
@@ -87,5 +119,7 @@ void i2s_out_delay() {}
 int i2s_out_set_pulse_period(uint32_t usec) { return 0; }
 int i2s_out_set_pulse_callback(i2s_out_pulse_func_t func) { return 0; }
 int i2s_out_reset() { return 0; }
+uint32_t i2s_out_get_underruns() { return 0; }
+uint32_t i2s_out_get_lead_usec() { return 0; }
 
 #endif
@@ -121,6 +121,14 @@ uint8_t i2s_out_read(uint8_t pin);
 */
 void i2s_out_write(uint8_t pin, uint8_t val);
 
+/*
+   Set and clear several bits of the internal pin state var in one update,
+   so that all of them are latched by the same I2S sample.
+   set_mask:   bit n set ... expanded pin n goes high
+   clear_mask: bit n set ... expanded pin n goes low (set_mask wins)
+*/
+void i2s_out_write_mask(uint32_t set_mask, uint32_t clear_mask);
+
 /*
     Set current pin state to the I2S bitstream buffer
     (This call will generate a future I2S_OUT_USEC_PER_PULSE μs x N bitstream)
@@ -183,6 +191,19 @@ i2s_out_pulser_status_t IRAM_ATTR i2s_out_get_pulser_status();
  */
 int i2s_out_reset();
 
+/*
+   Number of times the streaming output ran dry because the pulse callback
+   did not keep the DMA buffers filled. Counts since boot.
+ */
+uint32_t i2s_out_get_underruns();
+
+/*
+   Time from now until the last sample rendered so far reaches the expander
+   outputs. Steps counted by the pulse callback take effect this much later.
+   Safe to call from an ISR.
+ */
+uint32_t i2s_out_get_lead_usec();
+
 /*
    Reference: "ESP32 Technical Reference Manual" by Espressif Systems
      https://www.espressif.com/sites/default/files/documentation/esp32_technical_reference_manual_en.pdf
@@ -1,7 +1,7 @@
 /*
     I2SOut_ESP32S3.cpp
     ESP32-S3 I2S Output Driver for Shift Register Control
-    
+
     Implements high-speed stepper control using I2S peripheral
     to drive 3x 74HC595 shift registers
 */
@@ -16,10 +16,31 @@
 // Global I2S shift register control structure
 static i2s_shift_reg_t i2s_sr = {0};
 
+// Protects current_state read-modify-write and the pulser status
+static portMUX_TYPE i2s_sr_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+#define I2S_SR_ENTER_CRITICAL() portENTER_CRITICAL(&i2s_sr_spinlock)
+#define I2S_SR_EXIT_CRITICAL() portEXIT_CRITICAL(&i2s_sr_spinlock)
+
+// Render buffer, one 32-bit word per sample. i2s_write() takes 16-bit stereo
+// as interleaved left/right samples, so the low half of a word (Reg1, Reg0)
+// is the left channel and the high half (0, Reg2) the right channel. RCLK
+// latches on the rising WS edge after the left channel, when the chain holds
+// Reg2 of the previous sample and Reg1/Reg0 of this one, so register 2
+// follows one sample (4us) later than registers 0 and 1.
+static uint32_t i2s_sr_render_buf[I2S_DMA_BUF_LEN + I2S_SR_SAMPLE_SAFE_COUNT];
+static uint32_t i2s_sr_render_pos = 0;    // Samples rendered into the buffer
+static bool     i2s_sr_rendering  = false;  // True only while the pulse callback runs
+
+static TaskHandle_t i2s_sr_task_handle = NULL;
+static QueueHandle_t i2s_sr_event_queue = NULL;
+
+static void i2s_shift_reg_task(void* pvParameters);
+
 /*
  * Initialize I2S peripheral for shift register control
  */
-int i2s_shift_reg_init(void) {
+int i2s_shift_reg_init(uint8_t ws_pin, uint8_t bck_pin, uint8_t data_pin, uint32_t init_val) {
     if (i2s_sr.initialized) {
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "I2S shift register already initialized");
         return 0;
@@ -29,27 +50,27 @@ int i2s_shift_reg_init(void) {
     i2s_config_t i2s_config = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
         .sample_rate = I2S_SAMPLE_RATE,
-        .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
         .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
         .dma_buf_count = I2S_DMA_BUF_COUNT,
         .dma_buf_len = I2S_DMA_BUF_LEN,
         .use_apll = false,
-        .tx_desc_auto_clear = true,
+        .tx_desc_auto_clear = true,     // An underrun outputs zeros, never repeats old step pulses
         .fixed_mclk = 0
     };
 
     // I2S pin configuration
     i2s_pin_config_t pin_config = {
-        .bck_io_num = I2S_BCK_PIN,      // Bit clock → SRCLK
-        .ws_io_num = I2S_WS_PIN,        // Word select → RCLK
-        .data_out_num = I2S_DATA_PIN,   // Serial data → SER
+        .bck_io_num = bck_pin,      // Bit clock → SRCLK
+        .ws_io_num = ws_pin,        // Word select → RCLK
+        .data_out_num = data_pin,   // Serial data → SER
         .data_in_num = I2S_PIN_NO_CHANGE
     };
 
     // Install and start I2S driver
-    esp_err_t ret = i2s_driver_install(I2S_NUM_0, &i2s_config, 0, NULL);
+    esp_err_t ret = i2s_driver_install(I2S_NUM_0, &i2s_config, I2S_EVENT_QUEUE_LEN, &i2s_sr_event_queue);
     if (ret != ESP_OK) {
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "I2S driver install failed: %s", esp_err_to_name(ret));
         return -1;
@@ -71,19 +92,47 @@ int i2s_shift_reg_init(void) {
     }
 
     // Initialize state
-    i2s_sr.current_state = 0;
-    i2s_sr.step_count = 0;
+    i2s_sr.current_state = init_val & 0xFFFFFF;
+    i2s_sr.status = PASSTHROUGH;
+    i2s_sr.pulse_period = I2S_OUT_USEC_PER_PULSE;
+    i2s_sr.remain_time = 0;
+    i2s_sr.underruns = 0;
     i2s_sr.initialized = true;
 
-    // Send initial state (all outputs low)
-    i2s_shift_reg_set_state(0);
+    // The render task owns the I2S port from here on and keeps the DMA
+    // buffers filled with the current state.
+    if (i2s_sr_task_handle == NULL) {
+        xTaskCreatePinnedToCore(i2s_shift_reg_task,     // task
+                                "i2sOutTask",           // name for task
+                                4096,                   // size of task stack
+                                NULL,                   // parameters
+                                I2S_SR_TASK_PRIORITY,   // priority
+                                &i2s_sr_task_handle,    // handle
+                                I2S_SR_TASK_CORE        // core
+        );
+    } else {
+        vTaskResume(i2s_sr_task_handle);
+    }
 
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "I2S shift register initialized - 24 outputs available");
-    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Pins: DATA=%d, BCK=%d, WS=%d", I2S_DATA_PIN, I2S_BCK_PIN, I2S_WS_PIN);
-    
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Pins: DATA=%d, BCK=%d, WS=%d", data_pin, bck_pin, ws_pin);
+
     return 0;
 }
 
+int i2s_shift_reg_init(void) {
+#if defined(I2S_OUT_WS) && defined(I2S_OUT_BCK) && defined(I2S_OUT_DATA)
+    uint8_t ws_pin = I2S_OUT_WS, bck_pin = I2S_OUT_BCK, data_pin = I2S_OUT_DATA;
+#else
+    uint8_t ws_pin = I2S_WS_PIN, bck_pin = I2S_BCK_PIN, data_pin = I2S_DATA_PIN;
+#endif
+#ifdef I2S_OUT_INIT_VAL
+    return i2s_shift_reg_init(ws_pin, bck_pin, data_pin, I2S_OUT_INIT_VAL);
+#else
+    return i2s_shift_reg_init(ws_pin, bck_pin, data_pin, 0);
+#endif
+}
+
 /*
  * Deinitialize I2S peripheral
  */
@@ -92,40 +141,59 @@ int i2s_shift_reg_deinit(void) {
         return 0;
     }
 
+    i2s_sr.initialized = false;
+    i2s_sr.status = PASSTHROUGH;
+    if (i2s_sr_task_handle != NULL) {
+        vTaskSuspend(i2s_sr_task_handle);
+    }
+
     i2s_stop(I2S_NUM_0);
     i2s_driver_uninstall(I2S_NUM_0);
-    
-    i2s_sr.initialized = false;
+
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "I2S shift register deinitialized");
-    
+
     return 0;
 }
 
 /*
  * Write a single bit in the shift register chain
  */
-void i2s_shift_reg_write(uint8_t bit_num, bool value) {
+void IRAM_ATTR i2s_shift_reg_write(uint8_t bit_num, bool value) {
     if (!i2s_sr.initialized || bit_num >= I2S_SHIFT_REG_TOTAL_BITS) {
         return;
     }
 
+    I2S_SR_ENTER_CRITICAL();
     if (value) {
         i2s_sr.current_state |= (1UL << bit_num);
     } else {
         i2s_sr.current_state &= ~(1UL << bit_num);
     }
-    
-    i2s_shift_reg_push_sample(i2s_sr.current_state);
+    I2S_SR_EXIT_CRITICAL();
+}
+
+/*
+ * Set and clear several bits with one update of the output state, so
+ * step/dir bits of all axes land in the same latched sample
+ */
+void IRAM_ATTR i2s_shift_reg_write_mask(uint32_t set_mask, uint32_t clear_mask) {
+    if (!i2s_sr.initialized) {
+        return;
+    }
+
+    I2S_SR_ENTER_CRITICAL();
+    i2s_sr.current_state = ((i2s_sr.current_state & ~clear_mask) | set_mask) & 0xFFFFFF;
+    I2S_SR_EXIT_CRITICAL();
 }
 
 /*
  * Read current state of a bit
  */
-bool i2s_shift_reg_read(uint8_t bit_num) {
+bool IRAM_ATTR i2s_shift_reg_read(uint8_t bit_num) {
     if (bit_num >= I2S_SHIFT_REG_TOTAL_BITS) {
         return false;
     }
-    
+
     return (i2s_sr.current_state & (1UL << bit_num)) != 0;
 }
 
@@ -137,8 +205,7 @@ void i2s_shift_reg_set_state(uint32_t state) {
         return;
     }
 
-    i2s_sr.current_state = state & 0xFFFFFF; // Mask to 24 bits
-    i2s_shift_reg_push_sample(i2s_sr.current_state);
+    i2s_shift_reg_push_sample(state);
 }
 
 /*
@@ -149,53 +216,195 @@ uint32_t i2s_shift_reg_get_state(void) {
 }
 
 /*
- * Push a 24-bit sample to the I2S peripheral
+ * Make a 24-bit state the current output state
  * Data format: [0][Reg2][Reg1][Reg0] in a 32-bit word
+ * The render task picks it up for the next sample it queues.
  */
 void i2s_shift_reg_push_sample(uint32_t state) {
     if (!i2s_sr.initialized) {
         return;
     }
 
-    // Prepare 32-bit sample with 24-bit data
-    // ESP32-S3 I2S expects 32-bit samples, we use lower 24 bits
-    uint32_t sample = state & 0xFFFFFF;
-    
-    // Send sample via I2S DMA
-    size_t bytes_written = 0;
-    esp_err_t ret = i2s_write(I2S_NUM_0, &sample, sizeof(sample), &bytes_written, 0);
-    
-    if (ret != ESP_OK) {
-        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "I2S write failed: %s", esp_err_to_name(ret));
+    I2S_SR_ENTER_CRITICAL();
+    i2s_sr.current_state = state & 0xFFFFFF;  // Mask to 24 bits
+    I2S_SR_EXIT_CRITICAL();
+}
+
+/*
+ * Append the current state to the render buffer for usec microseconds.
+ * Only valid from within the pulse callback; at least one sample is pushed
+ * while the buffer has room. Returns the number of samples pushed.
+ */
+uint32_t IRAM_ATTR i2s_shift_reg_stream_push(uint32_t usec) {
+    if (!i2s_sr_rendering) {
+        return 0;
+    }
+
+    uint32_t space = I2S_DMA_BUF_LEN + I2S_SR_SAMPLE_SAFE_COUNT - i2s_sr_render_pos;
+    if (space == 0) {
+        return 0;
     }
+    uint32_t num = usec / I2S_OUT_USEC_PER_PULSE;
+    if (num == 0) {
+        num = 1;  // Even a short pulse must be latched
+    } else if (num > space) {
+        num = space;
+    }
+
+    uint32_t  data = i2s_sr.current_state;
+    uint32_t* buf  = &i2s_sr_render_buf[i2s_sr_render_pos];
+    uint32_t  n    = 0;
+    while (n < num) {
+        *buf++ = data;
+        n++;
+    }
+    i2s_sr_render_pos += n;
+    return n;
 }
 
 /*
- * Generate step pulse for a specific motor
- * motor_num: 0=X, 1=Y, 2=Z, 3=A
- * direction: true=forward, false=reverse
+ * Fill the render buffer with one DMA buffer worth of samples, calling
+ * the pulse callback whenever a step period has elapsed.
  */
-void i2s_shift_reg_step_pulse(uint8_t motor_num, bool direction) {
-    if (!i2s_sr.initialized || motor_num > 3) {
-        return;
+static void IRAM_ATTR i2s_shift_reg_render() {
+    i2s_sr_render_pos = 0;
+
+    I2S_SR_ENTER_CRITICAL();
+    while (i2s_sr_render_pos < I2S_DMA_BUF_LEN) {
+        if (i2s_sr.status == STEPPING && i2s_sr.remain_time < I2S_OUT_USEC_PER_PULSE && i2s_sr.pulse_func != NULL) {
+            uint32_t old_pos = i2s_sr_render_pos;
+            I2S_SR_EXIT_CRITICAL();  // The callback changes pins and may change the pulser status
+            i2s_sr_rendering = true;
+            (*i2s_sr.pulse_func)();
+            i2s_sr_rendering = false;
+            I2S_SR_ENTER_CRITICAL();
+            // The callback may have loaded a new segment, so use the period as it is now
+            i2s_sr.remain_time += (int32_t)i2s_sr.pulse_period - I2S_OUT_USEC_PER_PULSE * (int32_t)(i2s_sr_render_pos - old_pos);
+            if (i2s_sr.status != STEPPING) {
+                // Stepping stopped (or was reset) during the callback. Pad with the current state.
+                i2s_sr.remain_time = 0;
+            }
+            continue;
+        }
+        i2s_sr_render_buf[i2s_sr_render_pos] = i2s_sr.current_state;
+        i2s_sr_render_pos++;
+        if (i2s_sr.remain_time > 0) {
+            i2s_sr.remain_time -= I2S_OUT_USEC_PER_PULSE;
+        }
     }
+    I2S_SR_EXIT_CRITICAL();
+}
+
+/*
+ * Render task: keeps the DMA buffers full. i2s_write() blocks until a DMA
+ * buffer is free, which paces the rendering to the output rate.
+ * The driver reports I2S_EVENT_TX_Q_OVF when the DMA finished a buffer while
+ * no other buffer was queued, i.e. the task fell behind and the output ran
+ * dry. That is the stream mode counterpart of a late stepper timer ISR.
+ */
+static void i2s_shift_reg_task(void* pvParameters) {
+    while (true) {
+        i2s_shift_reg_render();
+
+        size_t written = 0;
+        i2s_write(I2S_NUM_0, i2s_sr_render_buf, i2s_sr_render_pos * sizeof(uint32_t), &written, portMAX_DELAY);
+
+        i2s_event_t event;
+        while (i2s_sr_event_queue != NULL && xQueueReceive(i2s_sr_event_queue, &event, 0) == pdTRUE) {
+            if (event.type == I2S_EVENT_TX_Q_OVF) {
+                i2s_sr.underruns++;
+            }
+        }
 
-    // Calculate bit positions for this motor
-    uint8_t step_bit = motor_num * 2;     // 0,2,4,6 for X,Y,Z,A step
-    uint8_t dir_bit = step_bit + 1;       // 1,3,5,7 for X,Y,Z,A direction
-
-    // Set direction first
-    i2s_shift_reg_write(dir_bit, direction);
-    
-    // Step pulse: high then low
-    i2s_shift_reg_write(step_bit, true);   // Step high
-    
-    // Small delay for step pulse width (could be hardware timer based)
-    delayMicroseconds(2);
-    
-    i2s_shift_reg_write(step_bit, false);  // Step low
-    
-    i2s_sr.step_count++;
+        // i2s_write() returns as the DMA frees a buffer, so the buffer just written goes out
+        // behind I2S_DMA_BUF_COUNT - 1 full ones. Everything up to the end of the stream is now queued.
+        I2S_SR_ENTER_CRITICAL();
+        i2s_sr.queue_end_time = esp_timer_get_time() + I2S_SR_QUEUE_USEC;
+        i2s_sr_render_pos     = 0;
+        if (i2s_sr.status == WAITING) {
+            i2s_sr.status = PASSTHROUGH;
+        }
+        I2S_SR_EXIT_CRITICAL();
+    }
+}
+
+int IRAM_ATTR i2s_shift_reg_set_stepping(void) {
+    I2S_SR_ENTER_CRITICAL();
+    if (i2s_sr.status != STEPPING) {
+        // Take the first step as soon as the render task gets to it
+        i2s_sr.remain_time = 0;
+        i2s_sr.status      = STEPPING;
+    }
+    I2S_SR_EXIT_CRITICAL();
+    return 0;
+}
+
+int IRAM_ATTR i2s_shift_reg_set_passthrough(void) {
+    I2S_SR_ENTER_CRITICAL();
+    if (i2s_sr.status == STEPPING) {
+        // The render task finishes the current buffer and then switches to passthrough
+        i2s_sr.status = WAITING;
+    }
+    I2S_SR_EXIT_CRITICAL();
+    return 0;
+}
+
+int IRAM_ATTR i2s_shift_reg_set_pulse_period(uint32_t usec) {
+    i2s_sr.pulse_period = usec;
+    return 0;
+}
+
+int i2s_shift_reg_set_pulse_callback(i2s_out_pulse_func_t func) {
+    i2s_sr.pulse_func = func;
+    return 0;
+}
+
+i2s_out_pulser_status_t IRAM_ATTR i2s_shift_reg_get_pulser_status(void) {
+    return i2s_sr.status;
+}
+
+/*
+ * Wait until pin changes made so far have reached the shift registers
+ */
+void i2s_shift_reg_delay(void) {
+    while (i2s_sr.status == WAITING) {
+        vTaskDelay(1);
+    }
+    delay(I2S_SR_QUEUE_MS);
+}
+
+/*
+ * Number of DMA underruns since boot
+ */
+uint32_t i2s_shift_reg_get_underruns(void) {
+    return i2s_sr.underruns;
+}
+
+/*
+ * Time until the last rendered sample reaches the shift registers. Samples
+ * are rendered (and their steps counted) up to one DMA buffer ahead of the
+ * ones queued, so this runs between I2S_SR_QUEUE_USEC and one DMA buffer
+ * (512us) more, depending on the render phase. After an underrun it
+ * overestimates until the queue has refilled.
+ */
+uint32_t IRAM_ATTR i2s_shift_reg_get_lead_usec(void) {
+    I2S_SR_ENTER_CRITICAL();
+    int64_t lead = i2s_sr.queue_end_time + (int64_t)i2s_sr_render_pos * I2S_OUT_USEC_PER_PULSE - esp_timer_get_time();
+    I2S_SR_EXIT_CRITICAL();
+    return lead > 0 ? lead : 0;
+}
+
+/*
+ * Stop stepping immediately. Samples already queued in the DMA buffers
+ * (at most I2S_SR_QUEUE_MS) are still shifted out; new samples repeat
+ * the current pin state.
+ */
+int i2s_shift_reg_reset(void) {
+    I2S_SR_ENTER_CRITICAL();
+    i2s_sr.status      = PASSTHROUGH;
+    i2s_sr.remain_time = 0;
+    I2S_SR_EXIT_CRITICAL();
+    return 0;
 }
 
 #endif // CONFIG_IDF_TARGET_ESP32S3
@@ -14,6 +14,18 @@
     
     Data format: 24-bit words (3 bytes per update)
     Bit mapping: [Reg2][Reg1][Reg0] where Reg0 is first in chain
+
+    Output is streamed continuously. A render task keeps the DMA buffers
+    full with fixed I2S_OUT_USEC_PER_PULSE samples. In passthrough mode the
+    samples repeat the current pin state. In stepping mode the task also
+    calls the pulse callback (stepper_pulse_func) once per step period, so
+    step/dir patterns are rendered ahead of time instead of being written
+    out one i2s_write() per bit change.
+
+    A pin write only reaches the chain when the task renders it, up to
+    I2S_SR_QUEUE_USEC later, so there is no static (ST_I2S_STATIC) mode
+    that holds a pulse from the timer ISR. Homing and probing stay in
+    stream mode on this target.
 */
 
 #include "Config.h"
@@ -21,6 +33,7 @@
 #ifdef CONFIG_IDF_TARGET_ESP32S3
 
 #include <stdint.h>
+#include "I2SOut.h"
 #include "driver/i2s.h"
 #include "driver/gpio.h"
 
@@ -43,9 +56,27 @@
 #endif
 
 // I2S configuration
-#define I2S_SAMPLE_RATE         80000   // 80kHz sample rate for smooth stepping
+// One I2S frame (16-bit left + 16-bit right word) carries one 24-bit output
+// sample and lasts I2S_OUT_USEC_PER_PULSE, so the chain is latched once per
+// sample. 250k frames/s x 32 bits gives an 8MHz bit clock, well inside the
+// 74HC595 shift clock limit at 3.3V.
+#define I2S_SAMPLE_RATE         (1000000 / I2S_OUT_USEC_PER_PULSE)
 #define I2S_DMA_BUF_COUNT       4       // Number of DMA buffers
-#define I2S_DMA_BUF_LEN         256     // DMA buffer length in samples
+#define I2S_DMA_BUF_LEN         128     // DMA buffer length in frames (512us per buffer)
+#define I2S_EVENT_QUEUE_LEN     8       // Driver events, read by the render task to count underruns
+
+// Headroom, in samples, for the data one pulse callback may push
+// (direction delay + step pulse). Longer requests are clamped.
+#define I2S_SR_SAMPLE_SAFE_COUNT 64
+
+// Time for data queued in the DMA buffers to reach the shift registers
+#define I2S_SR_QUEUE_USEC (I2S_DMA_BUF_COUNT * I2S_DMA_BUF_LEN * I2S_OUT_USEC_PER_PULSE)
+#define I2S_SR_QUEUE_MS ((I2S_SR_QUEUE_USEC + 999) / 1000)
+
+// Stream render task. It runs on the same core as the main loop so the
+// pulse callback preempts st_prep_buffer() the same way the timer ISR does.
+#define I2S_SR_TASK_PRIORITY    (configMAX_PRIORITIES - 2)
+#define I2S_SR_TASK_CORE        1
 
 // Stepper motor bit assignments in shift registers
 // Register 0 (first 8 bits - rightmost in chain)
@@ -80,25 +111,37 @@
 
 // I2S shift register control structure
 typedef struct {
-    uint32_t current_state;     // Current 24-bit output state
-    bool     initialized;       // Initialization flag
-    uint32_t step_count;       // Debug: count of steps sent
+    volatile uint32_t       current_state;   // Current 24-bit output state
+    bool                    initialized;     // Initialization flag
+    volatile i2s_out_pulser_status_t status;  // Stream mode (passthrough, stepping, waiting)
+    i2s_out_pulse_func_t    pulse_func;      // Called once per step period while stepping
+    volatile uint32_t       pulse_period;    // Step period in microseconds
+    int32_t                 remain_time;     // Microseconds left until the next pulse_func call
+    volatile uint32_t       underruns;       // DMA buffers sent before the render task refilled them
+    int64_t                 queue_end_time;  // esp_timer time the last sample handed to the DMA leaves the chain
 } i2s_shift_reg_t;
 
 // Function prototypes
 int i2s_shift_reg_init(void);
+int i2s_shift_reg_init(uint8_t ws_pin, uint8_t bck_pin, uint8_t data_pin, uint32_t init_val);
 int i2s_shift_reg_deinit(void);
 void i2s_shift_reg_write(uint8_t bit_num, bool value);
+void i2s_shift_reg_write_mask(uint32_t set_mask, uint32_t clear_mask);
 bool i2s_shift_reg_read(uint8_t bit_num);
 void i2s_shift_reg_set_state(uint32_t state);
 uint32_t i2s_shift_reg_get_state(void);
 void i2s_shift_reg_push_sample(uint32_t state);
-void i2s_shift_reg_step_pulse(uint8_t motor_num, bool direction);
 
-// Convenience macros for motor control
-#define I2S_STEP_X(dir) i2s_shift_reg_step_pulse(0, dir)
-#define I2S_STEP_Y(dir) i2s_shift_reg_step_pulse(1, dir)  
-#define I2S_STEP_Z(dir) i2s_shift_reg_step_pulse(2, dir)
-#define I2S_STEP_A(dir) i2s_shift_reg_step_pulse(3, dir)
+// Streaming (ST_I2S_STREAM) interface, see I2SOut.h for the semantics
+uint32_t i2s_shift_reg_stream_push(uint32_t usec);
+int i2s_shift_reg_set_stepping(void);
+int i2s_shift_reg_set_passthrough(void);
+int i2s_shift_reg_set_pulse_period(uint32_t usec);
+int i2s_shift_reg_set_pulse_callback(i2s_out_pulse_func_t func);
+i2s_out_pulser_status_t i2s_shift_reg_get_pulser_status(void);
+uint32_t i2s_shift_reg_get_underruns(void);
+uint32_t i2s_shift_reg_get_lead_usec(void);
+void i2s_shift_reg_delay(void);
+int i2s_shift_reg_reset(void);
 
 #endif // CONFIG_IDF_TARGET_ESP32S3
@@ -0,0 +1,115 @@
+/*
+  InputShaper.cpp - Input shaper impulse trains and shaped positions
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InputShaper.h"
+
+#include <cmath>
+#include <cstring>
+
+void shaper_impulses(ShaperType type, float frequency, float damping, ShaperImpulses& impulses) {
+    impulses.n            = 1;
+    impulses.amplitude[0] = 1.0;
+    impulses.time[0]      = 0.0;
+    if (type == ShaperType::None || frequency <= 0.0) {
+        return;
+    }
+    float df  = sqrt(1.0 - damping * damping);
+    float K   = exp(-damping * M_PI / df);
+    float t_d = 1.0 / (frequency * df) / 60.0;  // Damped period (min)
+    switch (type) {
+        case ShaperType::ZV:
+            impulses.n            = 2;
+            impulses.amplitude[1] = K;
+            break;
+        case ShaperType::ZVD:
+            impulses.n            = 3;
+            impulses.amplitude[1] = 2.0 * K;
+            impulses.amplitude[2] = K * K;
+            break;
+        case ShaperType::EI: {
+            const float v_tol     = 0.05;  // Residual vibration tolerance
+            impulses.n            = 3;
+            impulses.amplitude[0] = 0.25 * (1.0 + v_tol);
+            impulses.amplitude[1] = 0.5 * (1.0 - v_tol) * K;
+            impulses.amplitude[2] = impulses.amplitude[0] * K * K;
+            break;
+        }
+        default:
+            return;
+    }
+    float amplitude_sum = 0.0;
+    for (uint8_t i = 0; i < impulses.n; i++) {
+        amplitude_sum += impulses.amplitude[i];
+    }
+    for (uint8_t i = 0; i < impulses.n; i++) {
+        impulses.amplitude[i] /= amplitude_sum;
+        impulses.time[i] = 0.5 * t_d * i;
+    }
+}
+
+void ShaperHistory::reset(double time, const double* position, double spacing) {
+    _tail            = 0;
+    _count           = 1;
+    _spacing         = spacing;
+    _samples[0].time = time;
+    memcpy(_samples[0].position, position, sizeof(_samples[0].position));
+}
+
+void ShaperHistory::push(double time, const double* position) {
+    if (time <= newest_time() || (_count >= 2 && time - at(_count - 2).time < _spacing)) {
+        _count--;  // Replace the last sample
+    } else if (_count == SHAPER_HISTORY_SIZE) {
+        _tail = (_tail + 1) % SHAPER_HISTORY_SIZE;  // Too short a spacing. Lose the oldest.
+        _count--;
+    }
+    Sample& sample = at(_count++);
+    sample.time    = time;
+    memcpy(sample.position, position, sizeof(sample.position));
+}
+
+void ShaperHistory::discard_before(double time) {
+    while (_count >= 2 && at(1).time <= time) {
+        _tail = (_tail + 1) % SHAPER_HISTORY_SIZE;
+        _count--;
+    }
+}
+
+double ShaperHistory::position(uint8_t axis, double time) const {
+    // The newest samples are the most used, so search from the end
+    int i = _count - 1;
+    while (i >= 0 && at(i).time > time) {
+        i--;
+    }
+    if (i < 0) {
+        return at(0).position[axis];
+    }
+    if (i == _count - 1) {
+        return at(i).position[axis];
+    }
+    const Sample& a = at(i);
+    const Sample& b = at(i + 1);
+    return a.position[axis] + (b.position[axis] - a.position[axis]) * (time - a.time) / (b.time - a.time);
+}
+
+double ShaperHistory::shaped_position(uint8_t axis, double time, const ShaperImpulses& impulses) const {
+    double position = 0.0;
+    for (uint8_t i = 0; i < impulses.n; i++) {
+        position += impulses.amplitude[i] * this->position(axis, time - impulses.time[i]);
+    }
+    return position;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+/*
+  InputShaper.h - Input shaper impulse trains and shaped positions
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// An input shaper replaces each axis position p(t) of the planned motion with the weighted sum
+// of delayed copies of it, sum(A_i * p(t - t_i)). The impulses are timed and weighted so the
+// vibration each one excites at the resonance cancels out. The segment generator records the
+// planned (unshaped) motion in a ShaperHistory and cuts the step segments from the shaped
+// positions. See Stepper.cpp.
+//
+// Nothing here depends on the ESP32, so it builds on the host for the tests in test/.
+
+#include <cstdint>
+
+// Per-axis input shaper, $<axis>/Shaper/Type
+enum class ShaperType : int8_t {
+    None = 0,
+    ZV,   // Zero vibration, 2 impulses over half a period
+    ZVD,  // Zero vibration and derivative, 3 impulses over a period, more robust to frequency error
+    EI,   // Extra insensitive, 3 impulses over a period, most robust to frequency error
+};
+
+const int SHAPER_MAX_IMPULSES = 3;
+const int SHAPER_MAX_AXES     = 6;
+
+// Unshaped samples kept for the longest shaper. The spacing of the samples grows with the
+// shaper duration so they always fit.
+#ifndef SHAPER_HISTORY_SIZE
+#    define SHAPER_HISTORY_SIZE 64
+#endif
+
+// Impulse train of one shaper. The amplitudes add up to 1. A single impulse at 0 is no shaping.
+struct ShaperImpulses {
+    uint8_t n;
+    float   amplitude[SHAPER_MAX_IMPULSES];
+    float   time[SHAPER_MAX_IMPULSES];  // (min), from 0 up
+};
+
+// Builds the impulse train of a shaper for a resonance of frequency Hz and damping ratio
+// damping. Same shapers as Klipper's input_shaper.
+void shaper_impulses(ShaperType type, float frequency, float damping, ShaperImpulses& impulses);
+
+// Positions of the unshaped motion over time, as samples that are joined by straight lines.
+// The position holds at the first sample before it and at the last one after it.
+class ShaperHistory {
+public:
+    // Starts over with a single sample
+    void reset(double time, const double* position, double spacing);
+
+    // Adds a sample, no earlier than the last one. A sample closer than the spacing to the one
+    // before the last replaces the last one, which only moves the straight line it was on by
+    // less than the spacing, so the samples always fit in SHAPER_HISTORY_SIZE.
+    void push(double time, const double* position);
+
+    // Drops the samples that are no longer needed for positions at time or later
+    void discard_before(double time);
+
+    double        newest_time() const { return at(_count - 1).time; }
+    const double* newest_position() const { return at(_count - 1).position; }
+    uint8_t       size() const { return _count; }
+
+    double position(uint8_t axis, double time) const;
+
+    // Position of axis at time, shaped by impulses
+    double shaped_position(uint8_t axis, double time, const ShaperImpulses& impulses) const;
+
+private:
+    struct Sample {
+        double time;
+        double position[SHAPER_MAX_AXES];
+    };
+
+    const Sample& at(uint8_t i) const { return _samples[(_tail + i) % SHAPER_HISTORY_SIZE]; }
+    Sample&       at(uint8_t i) { return _samples[(_tail + i) % SHAPER_HISTORY_SIZE]; }
+
+    Sample  _samples[SHAPER_HISTORY_SIZE];
+    uint8_t _tail;
+    uint8_t _count;
+    double  _spacing;
+};
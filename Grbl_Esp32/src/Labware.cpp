@@ -0,0 +1,85 @@
+/*
+  Labware.cpp - Plate geometry of a labware slot
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Labware.h"
+
+#include <cstdlib>
+
+Error labware_parse(const char* fields, labware_t* lw) {
+    float value[10] = { 0.0 };
+    int   n_values  = 0;
+    char* s         = (char*)fields;
+    while (true) {
+        while (*s == ' ' || *s == ',') {
+            s++;
+        }
+        if (*s == '\0') {
+            break;
+        }
+        if (n_values == 10) {
+            return Error::InvalidValue;  // Too many fields
+        }
+        char* endptr;
+        value[n_values] = strtof(s, &endptr);
+        if (endptr == s) {
+            return Error::BadNumberFormat;
+        }
+        s = endptr;
+        n_values++;
+    }
+    if (n_values < 9) {
+        return Error::InvalidValue;
+    }
+    float rows = value[5];
+    float cols = value[6];
+    if (rows < 1 || rows > LABWARE_MAX_ROWS || rows != int(rows) || cols < 1 || cols > LABWARE_MAX_COLS || cols != int(cols) ||
+        value[9] < 0.0) {
+        return Error::InvalidValue;
+    }
+    lw->origin[0] = value[0];
+    lw->origin[1] = value[1];
+    lw->origin[2] = value[2];
+    lw->pitch[0]  = value[3];
+    lw->pitch[1]  = value[4];
+    lw->rows      = rows;
+    lw->cols      = cols;
+    lw->depth     = value[7];
+    lw->z_safe    = value[8];
+    lw->well_area = value[9];
+    return Error::Ok;
+}
+
+void LabwareWells::set(const labware_t& lw) {
+    _rows = lw.rows;
+    _cols = lw.cols;
+    for (int col = 0; col < _cols; col++) {
+        _col_x[col] = lw.origin[0] + col * lw.pitch[0];
+    }
+    for (int row = 0; row < _rows; row++) {
+        _row_y[row] = lw.origin[1] + row * lw.pitch[1];
+    }
+}
+
+bool LabwareWells::position(int32_t well, float* x, float* y) const {
+    if (well < 0 || well >= wells()) {
+        return false;
+    }
+    *x = _col_x[well % _cols];
+    *y = _row_y[well / _cols];
+    return true;
+}
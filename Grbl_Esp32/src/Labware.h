@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+  Labware.h - Plate geometry of a labware slot
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The definitions themselves are stored per slot by the Labware class in Settings.h. This is the
+// part that doesn't depend on the ESP32, so it builds on the host for the tests in test/.
+
+#include <cstdint>
+
+#include "Error.h"
+
+// Largest plate a labware slot holds, a 384 well plate
+const int LABWARE_MAX_ROWS = 16;
+const int LABWARE_MAX_COLS = 24;
+
+// A plate of rows x cols wells. Well index 0 is A1, and the index runs along the rows: A1, A2 ... B1.
+typedef struct {
+    float   origin[3];  // Machine position of the center of well A1, at the top of the plate (mm)
+    float   pitch[2];   // Signed X step from column to column and Y step from row to row (mm)
+    uint8_t rows;
+    uint8_t cols;
+    float   depth;      // Well depth below the top of the plate (mm)
+    float   z_safe;     // Machine Z that clears the plate (mm)
+    float   well_area;  // Well cross-section for Z-follow (mm^2), 0 if not known
+} labware_t;
+
+// Parses the fields of a $LW definition, "<x> <y> <z> <pitch x> <pitch y> <rows> <cols> <depth>
+// <z safe> [<well area>]", separated by spaces or commas, into lw.
+Error labware_parse(const char* fields, labware_t* lw);
+
+// Well positions of a plate, precomputed by column and row so the parser doesn't multiply out pitches
+class LabwareWells {
+public:
+    LabwareWells() : _rows(0), _cols(0) {}
+
+    void set(const labware_t& lw);
+
+    uint16_t wells() const { return _rows * _cols; }
+    // Machine X and Y of a well. Returns false if the plate has no such well.
+    bool position(int32_t well, float* x, float* y) const;
+
+private:
+    float   _col_x[LABWARE_MAX_COLS];
+    float   _row_y[LABWARE_MAX_ROWS];
+    uint8_t _rows;
+    uint8_t _cols;
+};
@@ -38,28 +38,52 @@
 #define MACHINE_NAME "Liquid Handling Robot (4-Axis)"
 
 // Enable I2S stepping
+// USE_I2S_OUT routes I2SO() pins to the shift registers; USE_I2S_STEPS
+// makes the DMA stream (ST_I2S_STREAM) the default stepper.
+#define USE_I2S_OUT
 #define USE_I2S_STEPS
 #define USE_I2S_OUT_STREAM
 
+// Short pipetting segments are dominated by per-tick ISR overhead, so
+// trace the step patterns ahead of time in st_prep_buffer()
+#define STEP_PATTERN_PRERENDER
+
+// Travel between wells is many short moves; a deep planner buffer keeps
+// enough distance queued to reach cruise speed. Defaults for
+// $Planner/Blocks and $Stepper/Segments.
+#define BLOCK_BUFFER_SIZE 64
+#define SEGMENT_BUFFER_SIZE 10
+
 // === AXIS CONFIGURATION ===
 #ifdef N_AXIS
 #undef N_AXIS
 #endif
 #define N_AXIS 4
 
-// Homing sequence: Z-axis first (safety), then X/Y together, then A-axis last
-#ifdef HOMING_CYCLE_0
-#undef HOMING_CYCLE_0
-#endif
-#ifdef HOMING_CYCLE_1  
-#undef HOMING_CYCLE_1
-#endif
-#ifdef HOMING_CYCLE_2
-#undef HOMING_CYCLE_2  
-#endif
-#define HOMING_CYCLE_0 bit(Z_AXIS)                // Home Z first (vertical safety)
-#define HOMING_CYCLE_1 bit(X_AXIS) | bit(Y_AXIS)  // Then home X and Y together
-#define HOMING_CYCLE_2 bit(A_AXIS)                // Finally home A axis (syringe)
+// The syringe runs its own motion queue ('@G1 A... F...' lines, see AsyncAxis.h) so it can
+// aspirate and dispense while X/Y/Z travel.
+#define ASYNC_AXIS A_AXIS
+
+// The syringe takes volumes in uL with $Syringe/Volumetric=On, and Z can follow the liquid
+// surface while it aspirates (M440), see Syringe.h.
+#define SYRINGE_AXIS A_AXIS
+
+// Plates on the deck, set with $LW and addressed from G-code by well index:
+// M460 P<slot> selects a plate, G0 W<well> moves over one of its wells (0 is A1, 1 is A2 ...).
+#define LABWARE_SLOTS 8
+
+// Obstacle heights over the deck on a grid of cells, set with $DM. With M480, G0 lifts Z only as
+// far as the cells under the path need, instead of to a fixed safe height.
+#define DECK_MAP_ROWS 16
+#define DECK_MAP_COLS 24
+
+// Homing sequence: Z-axis first (safety), then X/Y together with the A-axis. With
+// $Homing/Concurrent on, the cycles after Cycle0 run as one, so the syringe homes while the
+// gantry does.
+#define DEFAULT_HOMING_CYCLE_0 bit(Z_AXIS)                   // Home Z first (vertical safety)
+#define DEFAULT_HOMING_CYCLE_1 (bit(X_AXIS) | bit(Y_AXIS))  // Then home X and Y together
+#define DEFAULT_HOMING_CYCLE_2 bit(A_AXIS)                   // And the A axis (syringe)
+#define DEFAULT_HOMING_CONCURRENT 1                          // Cycle1 and Cycle2 at once
 
 // === I2S SHIFT REGISTER PINS ===
 #define I2S_OUT_BCK     GPIO_NUM_5   // Bit clock → 74HC595 SRCLK (pin 11)
@@ -139,11 +163,26 @@
 #define DEFAULT_Z_ACCELERATION 50.0    // mm/sec^2 (slower for safety)
 #define DEFAULT_A_ACCELERATION 50.0    // mm/sec^2 (syringe pump)
 
+// A jerk limit turns on S-curve ramps for the axis, 0 keeps trapezoids. With a jerk
+// limit the acceleration above is the peak of each ramp rather than its average, so
+// raise both together when tuning against tip sloshing.
+#define DEFAULT_X_JERK 0.0            // mm/sec^3 (to be tuned)
+#define DEFAULT_Y_JERK 0.0            // mm/sec^3 (to be tuned)
+
+// Input shapers for the gantry, to stop the tip ringing after XY moves. Find the
+// frequencies with $Shaper/Sweep=X and $Shaper/Sweep=Y, then pick ZV, ZVD or EI.
+#define DEFAULT_X_SHAPER_TYPE ShaperType::None
+#define DEFAULT_Y_SHAPER_TYPE ShaperType::None
+#define DEFAULT_X_SHAPER_FREQUENCY 40.0   // Hz (to be measured)
+#define DEFAULT_Y_SHAPER_FREQUENCY 40.0   // Hz (to be measured)
+
 #define DEFAULT_X_MAX_TRAVEL 200.0    // mm (to be measured)
 #define DEFAULT_Y_MAX_TRAVEL 200.0    // mm (to be measured)
 #define DEFAULT_Z_MAX_TRAVEL 100.0    // mm (to be measured)
 #define DEFAULT_A_MAX_TRAVEL 41.5     // mm (VERIFIED: 41.5mm after 0.5mm pull-off)
 
+#define DEFAULT_SYRINGE_UL_PER_MM 24.1  // uL/mm (to be calibrated, or use ENABLE_PIECEWISE_LINEAR_SYRINGE)
+
 // === HOMING SETTINGS ===
 #define DEFAULT_HOMING_ENABLE false  // DISABLED for motor testing
 #define DEFAULT_HOMING_DIR_MASK 0     // All axes home to negative direction initially
@@ -171,6 +210,7 @@
 #define DEFAULT_A_HOMING_MPOS 0.0
 
 // === COMMUNICATION ===
+#define ENABLE_USB_CDC  // Native USB next to the CH340 bridge, for fast streaming
 #define ENABLE_WIFI
 #define ENABLE_BLUETOOTH  // Can be disabled if not needed
 #define ENABLE_TELNET
@@ -64,8 +64,18 @@ bool mc_line(float* target, plan_line_data_t* pl_data) {
     // indicates to Grbl what is a backlash compensation motion, so that Grbl executes the move but
     // doesn't update the machine position values. Since the position values used by the g-code
     // parser and planner are separate from the system machine positions, this is doable.
+#ifdef ASYNC_AXIS
+    // The async axis moves in one queue at a time. Let the async queue finish first.
+    async_release_axis(target);
+    if (sys.abort) {
+        sys_pl_data_inflight = NULL;
+        return submitted_result;
+    }
+#endif
     // If the buffer is full: good! That means we are well ahead of the robot.
     // Remain in this loop until there is room in the buffer.
+    // NOTE: protocol_main_loop() holds a line back until the buffer has room for all of its blocks,
+    // so this mostly waits for lines that need more blocks than the buffer holds.
     do {
         protocol_execute_realtime();  // Check for any run-time commands
         if (sys.abort) {
@@ -103,6 +113,39 @@ void __attribute__((weak)) motors_to_cartesian(float* cartesian, float* motors,
 }
 
 void __attribute__((weak)) forward_kinematics(float* position) {}
+// CCW angle between position and target from the circle center, negative for a clockwise arc.
+// Only one atan2() trig computation required.
+static float mc_arc_angular_travel(float* target, float* position, float* offset, uint8_t axis_0, uint8_t axis_1, uint8_t is_clockwise_arc) {
+    float r_axis0        = -offset[axis_0];  // Radius vector from center to current location
+    float r_axis1        = -offset[axis_1];
+    float rt_axis0       = target[axis_0] - (position[axis_0] + offset[axis_0]);
+    float rt_axis1       = target[axis_1] - (position[axis_1] + offset[axis_1]);
+    float angular_travel = atan2(r_axis0 * rt_axis1 - r_axis1 * rt_axis0, r_axis0 * rt_axis0 + r_axis1 * rt_axis1);
+    if (is_clockwise_arc) {  // Correct atan2 output per direction
+        if (angular_travel >= -ARC_ANGULAR_TRAVEL_EPSILON) {
+            angular_travel -= 2 * M_PI;
+        }
+    } else {
+        if (angular_travel <= ARC_ANGULAR_TRAVEL_EPSILON) {
+            angular_travel += 2 * M_PI;
+        }
+    }
+    return angular_travel;
+}
+
+// NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
+// (2x) arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
+// is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
+// For the intended uses of Grbl, this value shouldn't exceed 2000 for the strictest of cases.
+static uint16_t mc_arc_segments(float angular_travel, float radius) {
+    return floor(fabs(0.5 * angular_travel * radius) / sqrt(arc_tolerance->get() * (2 * radius - arc_tolerance->get())));
+}
+
+uint16_t mc_arc_blocks(float* target, float* position, float* offset, float radius, uint8_t axis_0, uint8_t axis_1, uint8_t is_clockwise_arc) {
+    uint16_t segments = mc_arc_segments(mc_arc_angular_travel(target, position, offset, axis_0, axis_1, is_clockwise_arc), radius);
+    return segments ? segments : 1;
+}
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -123,8 +166,6 @@ void mc_arc(float*            target,
     float center_axis1 = position[axis_1] + offset[axis_1];
     float r_axis0      = -offset[axis_0];  // Radius vector from center to current location
     float r_axis1      = -offset[axis_1];
-    float rt_axis0     = target[axis_0] - center_axis0;
-    float rt_axis1     = target[axis_1] - center_axis1;
 
     float previous_position[MAX_N_AXIS] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
@@ -133,22 +174,8 @@ void mc_arc(float*            target,
     for (n = 0; n < n_axis; n++) {
         previous_position[n] = position[n];
     }
-    // CCW angle between position and target from circle center. Only one atan2() trig computation required.
-    float angular_travel = atan2(r_axis0 * rt_axis1 - r_axis1 * rt_axis0, r_axis0 * rt_axis0 + r_axis1 * rt_axis1);
-    if (is_clockwise_arc) {  // Correct atan2 output per direction
-        if (angular_travel >= -ARC_ANGULAR_TRAVEL_EPSILON) {
-            angular_travel -= 2 * M_PI;
-        }
-    } else {
-        if (angular_travel <= ARC_ANGULAR_TRAVEL_EPSILON) {
-            angular_travel += 2 * M_PI;
-        }
-    }
-    // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
-    // (2x) arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
-    // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
-    // For the intended uses of Grbl, this value shouldn't exceed 2000 for the strictest of cases.
-    uint16_t segments = floor(fabs(0.5 * angular_travel * radius) / sqrt(arc_tolerance->get() * (2 * radius - arc_tolerance->get())));
+    float    angular_travel = mc_arc_angular_travel(target, position, offset, axis_0, axis_1, is_clockwise_arc);
+    uint16_t segments       = mc_arc_segments(angular_travel, radius);
     if (segments) {
         // Multiply inverse feed_rate to compensate for the fact that this movement is approximated
         // by a number of discrete segments. The inverse feed_rate should be correct for the sum of
@@ -231,6 +258,231 @@ void mc_arc(float*            target,
     cartesian_to_motors(target, pl_data, previous_position);
 }
 
+#ifdef SYRINGE_AXIS
+// Point the travel of a dispense reaches blend mm short of the well, where the stroke starts.
+// Returns false if the travel is no longer than blend, so the stroke runs over all of it.
+static bool mc_dispense_approach(float* target, float* position, float blend, float* approach) {
+    auto  n_axis = number_axis->get();
+    float travel = 0.0;  // Length of the travel without the stroke
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (idx != SYRINGE_AXIS) {
+            float delta = target[idx] - position[idx];
+            travel += delta * delta;
+        }
+    }
+    travel = sqrt(travel);
+    if (travel <= blend) {
+        return false;
+    }
+    float fraction = (travel - blend) / travel;
+    memcpy(approach, position, MAX_N_AXIS * sizeof(float));
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (idx != SYRINGE_AXIS) {
+            approach[idx] += (target[idx] - position[idx]) * fraction;
+        }
+    }
+    return true;
+}
+
+// Execute a multi-dispense travel. position == current xyz, target == the well, with the syringe
+// axis already at the end of the stroke. The travel is split so the stroke runs over its last blend mm,
+// at rate mm/min (0 keeps the travel feed rate). The stroke bends the path only slightly, so the
+// junction planning carries the travel speed into it and the planner does not stop at the well.
+// Only the stroke rate and the turn towards the next well slow the motion down.
+void mc_dispense(float* target, plan_line_data_t* pl_data, float* position, float blend, float rate, bool deck_travel) {
+    float previous_position[MAX_N_AXIS];
+    memcpy(previous_position, position, sizeof(previous_position));
+
+    if (pl_data->motion.inverseTime) {
+        // Both blocks run at the rate the whole line would.
+        auto  n_axis = number_axis->get();
+        float length = 0.0;  // Length of the whole line
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            float delta = target[idx] - position[idx];
+            length += delta * delta;
+        }
+        pl_data->feed_rate *= sqrt(length);
+        pl_data->motion.inverseTime = 0;
+    }
+
+    float approach[MAX_N_AXIS];
+    if (mc_dispense_approach(target, position, blend, approach)) {
+        float original_feedrate = pl_data->feed_rate;  // Kinematics may alter the feedrate
+#    ifdef DECK_MAP_ROWS
+        if (deck_travel && (approach[X_AXIS] != position[X_AXIS] || approach[Y_AXIS] != position[Y_AXIS])) {
+            mc_deck_travel(approach, pl_data, previous_position);
+        } else
+#    endif
+            cartesian_to_motors(approach, pl_data, previous_position);
+        if (sys.abort) {
+            return;
+        }
+        pl_data->feed_rate = original_feedrate;
+        memcpy(previous_position, approach, sizeof(previous_position));
+    }
+    if (rate > 0.0) {
+        pl_data->feed_rate          = rate;
+        pl_data->motion.rapidMotion = 0;
+    }
+    cartesian_to_motors(target, pl_data, previous_position);
+}
+
+uint16_t mc_dispense_blocks(float* target, float* position, float blend, bool deck_travel) {
+    float approach[MAX_N_AXIS];
+    if (!mc_dispense_approach(target, position, blend, approach)) {
+        return 1;
+    }
+#    ifdef DECK_MAP_ROWS
+    if (deck_travel && (approach[X_AXIS] != position[X_AXIS] || approach[Y_AXIS] != position[Y_AXIS])) {
+        return mc_deck_travel_blocks(approach, position) + 1;
+    }
+#    endif
+    return 2;
+}
+#endif
+
+#ifdef DECK_MAP_ROWS
+// Advances a crossing of cell edges along one axis of the path, from fraction t of the path.
+// Returns the path fraction of the next crossing, or 2.0 (past the end) if the axis does not move.
+static float mc_deck_next_edge(float start, float delta, float origin, float cell, float t) {
+    if (delta == 0.0) {
+        return 2.0;
+    }
+    float step = delta > 0.0 ? 1.0 : -1.0;
+    float edge = floor((start + delta * t - origin) / cell * step) * step + step;
+    float next = (origin + edge * cell - start) / delta;
+    if (next <= t) {
+        next = (origin + (edge + step) * cell - start) / delta;  // Rounding left t short of its edge
+    }
+    return next;
+}
+
+// Polyline of a deck travel: the path fraction and the Z of each point before the target
+typedef struct {
+    int   count;
+    float t[DECK_TRAVEL_MAX_STRETCHES + 1];
+    float z[DECK_TRAVEL_MAX_STRETCHES + 1];
+} deck_profile_t;
+
+// The path is split where it crosses cell edges, into stretches that each must clear the height of
+// their cell plus $Deck/Clearance. The tip then follows the upper envelope of those heights, with
+// each one extended by ramps as steep as Z keeps pace with XY at the max rates. The start and end
+// heights take part too, so the tip leaves and arrives at them along ramps where it can. Only if it
+// starts or ends below the envelope does it rise or descend straight up or down.
+// The profile is sent as a polyline through the envelope at the stretch ends. Between those, the
+// envelope is the highest of straight lines, so the chords never drop below it, and the junction
+// planning blends the lift and the descent into the XY motion.
+static void mc_deck_profile(float* target, float* position, deck_profile_t* profile) {
+    const deck_map_t* map       = deck_map->get();
+    float             clearance = deck_clearance->get();
+    float             dx        = target[X_AXIS] - position[X_AXIS];
+    float             dy        = target[Y_AXIS] - position[Y_AXIS];
+    float             length    = sqrt(dx * dx + dy * dy);
+
+    // Stretch i runs from the end of stretch i - 1 (or the start) to path fraction stretch_end[i]
+    // and needs Z of at least stretch_z[i].
+    float stretch_end[DECK_TRAVEL_MAX_STRETCHES];
+    float stretch_z[DECK_TRAVEL_MAX_STRETCHES];
+    int   n_stretch = 0;
+    float t         = 0.0;
+    float tx        = mc_deck_next_edge(position[X_AXIS], dx, map->origin[X_AXIS], map->cell, t);
+    float ty        = mc_deck_next_edge(position[Y_AXIS], dy, map->origin[Y_AXIS], map->cell, t);
+    while (t < 1.0) {
+        float t_next = MIN(MIN(tx, ty), 1.0);
+        float t_mid  = 0.5 * (t + t_next);
+        float z      = deck_map->height(position[X_AXIS] + dx * t_mid, position[Y_AXIS] + dy * t_mid) + clearance;
+        if (n_stretch > 0 && (stretch_z[n_stretch - 1] == z || n_stretch == DECK_TRAVEL_MAX_STRETCHES)) {
+            stretch_z[n_stretch - 1] = MAX(stretch_z[n_stretch - 1], z);
+        } else {
+            stretch_z[n_stretch++] = z;
+        }
+        stretch_end[n_stretch - 1] = t_next;
+        if (t_next == tx) {
+            tx = mc_deck_next_edge(position[X_AXIS], dx, map->origin[X_AXIS], map->cell, t_next);
+        }
+        if (t_next == ty) {
+            ty = mc_deck_next_edge(position[Y_AXIS], dy, map->origin[Y_AXIS], map->cell, t_next);
+        }
+        t = t_next;
+    }
+
+    // Z climbs or drops this much per path fraction while XY travel at their max rates.
+    float xy_rate = MIN(axis_settings[X_AXIS]->max_rate->get(), axis_settings[Y_AXIS]->max_rate->get());
+    float slope   = length * axis_settings[Z_AXIS]->max_rate->get() / xy_rate;
+
+    // Envelope at the start of the path (point 0) and at the end of each stretch (point i + 1)
+    float point_t[DECK_TRAVEL_MAX_STRETCHES + 1];
+    float point_z[DECK_TRAVEL_MAX_STRETCHES + 1];
+    for (int i = 0; i <= n_stretch; i++) {
+        float ti = i == 0 ? 0.0 : stretch_end[i - 1];
+        float z  = MAX(position[Z_AXIS] - slope * ti, target[Z_AXIS] - slope * (1.0 - ti));
+        for (int j = 0; j < n_stretch; j++) {
+            float t_lo = j == 0 ? 0.0 : stretch_end[j - 1];
+            float gap  = ti < t_lo ? t_lo - ti : (ti > stretch_end[j] ? ti - stretch_end[j] : 0.0);
+            z          = MAX(z, stretch_z[j] - slope * gap);
+        }
+        point_t[i] = ti;
+        point_z[i] = z;
+    }
+
+    // Straight up to the envelope if below it, along the envelope, and straight down to the target
+    // if above it. Points on the line between their neighbours are left out.
+    float last_t   = 0.0;
+    float last_z   = position[Z_AXIS];
+    profile->count = 0;
+    for (int i = 0; i <= n_stretch; i++) {
+        if (i == 0 && point_z[i] <= position[Z_AXIS]) {
+            continue;
+        }
+        if (i == n_stretch && point_z[i] <= target[Z_AXIS]) {
+            break;
+        }
+        if (i > 0 && i < n_stretch) {
+            float span = point_t[i + 1] - last_t;
+            if (span <= 0.0 || fabsf(last_z + (point_z[i + 1] - last_z) * (point_t[i] - last_t) / span - point_z[i]) < DECK_TRAVEL_TOLERANCE) {
+                continue;
+            }
+        }
+        profile->t[profile->count] = point_t[i];
+        profile->z[profile->count] = point_z[i];
+        profile->count++;
+        last_t = point_t[i];
+        last_z = point_z[i];
+    }
+}
+
+void mc_deck_travel(float* target, plan_line_data_t* pl_data, float* position) {
+    deck_profile_t profile;
+    mc_deck_profile(target, position, &profile);
+
+    float previous_position[MAX_N_AXIS];
+    float point[MAX_N_AXIS];
+    auto  n_axis            = number_axis->get();
+    float original_feedrate = pl_data->feed_rate;  // Kinematics may alter the feedrate
+    memcpy(previous_position, position, sizeof(previous_position));
+    for (int i = 0; i < profile.count; i++) {
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            point[idx] = position[idx] + (target[idx] - position[idx]) * profile.t[i];
+        }
+        point[Z_AXIS] = profile.z[i];
+        limitsCheckSoft(point);
+        cartesian_to_motors(point, pl_data, previous_position);
+        if (sys.abort) {
+            return;
+        }
+        pl_data->feed_rate = original_feedrate;
+        memcpy(previous_position, point, sizeof(previous_position));
+    }
+    cartesian_to_motors(target, pl_data, previous_position);
+}
+
+uint16_t mc_deck_travel_blocks(float* target, float* position) {
+    deck_profile_t profile;
+    mc_deck_profile(target, position, &profile);
+    return profile.count + 1;
+}
+#endif
+
 // Execute dwell in seconds.
 bool mc_dwell(int32_t milliseconds) {
     if (milliseconds <= 0 || sys.state == State::CheckMode) {
@@ -240,6 +492,68 @@ bool mc_dwell(int32_t milliseconds) {
     return delay_msec(milliseconds, DwellMode::Dwell);
 }
 
+// Shakes one axis back and forth at rising frequencies, from freq_start to freq_end Hz, to find
+// its resonances for the input shaper. Each half period is a rest-to-rest move that accelerates at
+// the axis acceleration for a quarter period and decelerates for the next, so the excitation is at
+// the stated frequency only with the axis jerk limit off. The amplitude, a/(16*f^2), shrinks fast
+// with the frequency, so raise the axis acceleration for the sweep. The moves bypass the input
+// shaper, which would otherwise smooth out the excitation. Returns to the start position.
+Error mc_resonance_sweep(uint8_t axis, float freq_start, float freq_end, float freq_step) {
+    float accel         = axis_settings[axis]->acceleration->get();  // mm/sec^2
+    float steps_per_mm  = axis_settings[axis]->steps_per_mm->get();
+    float max_rate      = axis_settings[axis]->max_rate->get() / 60.0;  // mm/sec
+    float min_frequency = accel / (4.0 * max_rate);                     // Lower ones would cruise
+    if (freq_start < min_frequency) {
+        grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Sweep starts at %.1fHz, limited by the max rate", min_frequency);
+        freq_start = min_frequency;
+    }
+
+    float start[MAX_N_AXIS], target[MAX_N_AXIS];
+    memcpy(start, gc_state.position, sizeof(start));
+    memcpy(target, start, sizeof(target));
+    float direction = 1.0;
+    if (soft_limits->get()) {
+        target[axis] = start[axis] + accel / (16.0 * freq_start * freq_start);
+        if (limitsCheckTravel(target)) {
+            direction    = -1.0;
+            target[axis] = start[axis] - accel / (16.0 * freq_start * freq_start);
+            if (limitsCheckTravel(target)) {
+                return Error::TravelExceeded;
+            }
+        }
+    }
+
+    plan_line_data_t  plan_data;
+    plan_line_data_t* pl_data = &plan_data;
+    memset(pl_data, 0, sizeof(plan_line_data_t));
+    pl_data->motion.rapidMotion = 1;
+    pl_data->motion.noShaping   = 1;
+
+    for (float freq = freq_start; freq <= freq_end; freq += freq_step) {
+        protocol_buffer_synchronize();
+        if (sys.abort) {
+            return Error::Ok;
+        }
+        float mm = accel / (16.0 * freq * freq);
+        if (mm * steps_per_mm < RESONANCE_SWEEP_MIN_STEPS) {
+            grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Sweep stopped at %.1fHz, amplitude under %d steps", freq, RESONANCE_SWEEP_MIN_STEPS);
+            break;
+        }
+        grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Sweep %c %.1fHz %.3fmm", "XYZABC"[axis], freq, mm);
+        // An even number of half periods ends back at the start
+        int half_periods = 2 * MAX(1, lround(freq * RESONANCE_SWEEP_SECONDS));
+        for (int i = 0; i < half_periods; i++) {
+            target[axis] = start[axis] + ((i & 1) ? 0.0 : direction * mm);
+            mc_line(target, pl_data);
+            if (sys.abort) {
+                return Error::Ok;
+            }
+        }
+    }
+    protocol_buffer_synchronize();
+    return Error::Ok;
+}
+
 // return true if the mask has exactly one bit set,
 // so it refers to exactly one axis
 static bool mask_is_single_axis(uint8_t axis_mask) {
@@ -267,7 +581,9 @@ static bool axis_is_squared(uint8_t axis_mask) {
     return false;
 }
 
-#ifdef USE_I2S_STEPS
+// The ESP32-S3 I2S driver has no static mode, its pin writes only reach the shift registers
+// through rendered samples. Probe in stream mode there.
+#if defined(USE_I2S_STEPS) && !defined(CONFIG_IDF_TARGET_ESP32S3)
 #    define BACKUP_STEPPER(save_stepper)                                                                                                   \
         do {                                                                                                                               \
             if (save_stepper == ST_I2S_STREAM) {                                                                                           \
@@ -338,10 +654,24 @@ void mc_homing_cycle(uint8_t cycle_mask) {
     else
 #endif
     {
+        // With $Homing/Concurrent, the first cycle still homes on its own, so the axis that makes
+        // travel safe (Z up) is done before anything else moves. The cycles after it then home as
+        // one: their axes seek, locate and pull off together, each locking out on its own switch,
+        // and every phase pays the debounce delay once for all of them. Squared axes keep their
+        // own cycles, so the cycles collected before one are homed first to keep the order.
+        AxisMask concurrent_mask = 0;
         for (int cycle = 0; cycle < MAX_N_AXIS; cycle++) {
             auto homing_mask = homing_cycle[cycle]->get();
             if (homing_mask) {  // if there are some axes in this cycle
+                if (homing_concurrent->get() && !no_cycles_defined && !axis_is_squared(homing_mask)) {
+                    concurrent_mask |= homing_mask;
+                    continue;
+                }
                 no_cycles_defined = false;
+                if (concurrent_mask) {
+                    limits_go_home(concurrent_mask);
+                    concurrent_mask = 0;
+                }
                 if (!axis_is_squared(homing_mask)) {
                     limits_go_home(homing_mask);  // Homing cycle 0
                 } else {
@@ -357,6 +687,9 @@ void mc_homing_cycle(uint8_t cycle_mask) {
                 }
             }
         }
+        if (concurrent_mask) {
+            limits_go_home(concurrent_mask);
+        }
         if (no_cycles_defined) {
             report_status_message(Error::HomingNoCycles, CLIENT_ALL);
         }
@@ -376,6 +709,40 @@ void mc_homing_cycle(uint8_t cycle_mask) {
     limits_init();
 }
 
+#ifdef USE_I2S_STEPS
+// In I2S stream mode the position latched at a probe trigger includes the steps still queued for
+// the drivers, sys_probe_lead usecs of motion (see i2s_out_get_lead_usec()). Takes that distance
+// back along the probing line from start to target.
+// The speed over the lead is taken as the programmed feed, capped at the speed the line's
+// acceleration allows over the distance travelled so far. While the axis still accelerates the cap
+// is an upper bound, so the position can be taken back too far by up to lead x (cap - actual
+// speed). At the programmed feed the error is the render task's timing jitter, tens of usecs.
+static void mc_probe_lead_compensate(const float* start, const float* target, const plan_line_data_t* pl_data) {
+    if (sys_probe_lead == 0) {
+        return;  // Not probed in stream mode
+    }
+    auto  n_axis = number_axis->get();
+    float unit_vec[MAX_N_AXIS];
+    float travel = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        unit_vec[idx] = target[idx] - start[idx];
+        float delta   = sys_probe_position[idx] / axis_settings[idx]->steps_per_mm->get() - start[idx];
+        travel += delta * delta;
+    }
+    float length = convert_delta_vector_to_unit_vector(unit_vec);
+    if (length == 0.0) {
+        return;
+    }
+    travel     = sqrt(travel);
+    float rate = pl_data->motion.inverseTime ? pl_data->feed_rate * length : pl_data->feed_rate * 0.01 * sys.f_override;  // mm/min
+    rate       = MIN(rate, sqrt(2.0 * limit_acceleration_by_axis_maximum(unit_vec) * travel));
+    float lead = rate * sys_probe_lead / (60.0 * 1000000.0);  // mm
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        sys_probe_position[idx] -= lround(unit_vec[idx] * lead * axis_settings[idx]->steps_per_mm->get());
+    }
+}
+#endif
+
 // Perform tool length probe cycle. Requires probe switch.
 // NOTE: Upon probe failure, the program will be stopped and placed into ALARM state.
 GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t parser_flags) {
@@ -393,7 +760,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t par
         return GCUpdatePos::None;  // Return if system reset has been issued.
     }
 
-#ifdef USE_I2S_STEPS
+#if defined(USE_I2S_STEPS) && !defined(CONFIG_IDF_TARGET_ESP32S3)
     stepper_id_t save_stepper = current_stepper; /* remember the stepper */
 #endif
     // Switch stepper mode to the I2S static (realtime mode)
@@ -414,12 +781,26 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t par
     }
     // Setup and queue probing motion. Auto cycle-start should not start the cycle.
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Found");
+    float            start[MAX_N_AXIS];
+    plan_line_data_t probe_data = *pl_data;  // Kinematics may alter the feedrate
+    memcpy(start, gc_state.position, sizeof(start));
     limitsCheckSoft(target);
     cartesian_to_motors(target, pl_data, gc_state.position);
+#ifdef PROBE_EDGE_LATCH
+    // Start the motion, then arm the probe latch. It only sees edges from then on, so catch a
+    // trigger that came before. Armed in a cycle, a trigger always has a motion to cancel.
+    sys_rt_exec_state.bit.cycleStart = true;
+    protocol_execute_realtime();
+    sys_probe_state = Probe::Active;
+    if (sys.state == State::Cycle) {
+        probe_state_monitor();
+    }
+#else
     // Activate the probing state monitor in the stepper module.
     sys_probe_state = Probe::Active;
-    // Perform probing cycle. Wait here until probe is triggered or motion completes.
     sys_rt_exec_state.bit.cycleStart = true;
+#endif
+    // Perform probing cycle. Wait here until probe is triggered or motion completes.
     do {
         protocol_execute_realtime();
         if (sys.abort) {
@@ -435,12 +816,28 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t par
     // Set state variables and error out, if the probe failed and cycle with error is enabled.
     if (sys_probe_state == Probe::Active) {
         if (is_no_error) {
-            memcpy(sys_probe_position, sys_position, sizeof(sys_position));
+            st_get_realtime_position(sys_probe_position);
         } else {
             sys_rt_exec_alarm = ExecAlarm::ProbeFailContact;
         }
     } else {
         sys.probe_succeeded = true;  // Indicate to system the probing cycle completed successfully.
+#ifdef USE_I2S_STEPS
+        mc_probe_lead_compensate(start, target, &probe_data);
+#endif
+        // How far and how long the motion ran on past the trigger, to tune the probing feed rate.
+        int32_t stop_position[MAX_N_AXIS];
+        st_get_realtime_position(stop_position);
+        float overshoot = 0.0;
+        for (uint8_t idx = 0; idx < number_axis->get(); idx++) {
+            float delta = (stop_position[idx] - sys_probe_position[idx]) / axis_settings[idx]->steps_per_mm->get();
+            overshoot += delta * delta;
+        }
+        grbl_msg_sendf(CLIENT_SERIAL,
+                       MsgLevel::Debug,
+                       "Probe stopped %.3fmm, %dms past the trigger",
+                       sqrt(overshoot),
+                       int((esp_timer_get_time() - sys_probe_time) / 1000));
     }
     sys_probe_state = Probe::Off;  // Ensure probe state monitor is disabled.
     protocol_execute_realtime();   // Check and execute run-time commands
@@ -459,6 +856,87 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t par
     }
 }
 
+// Two-phase probe, G38.2/G38.3 with an R word. Probes at the feed rate, backs off along the probing
+// line to retract before the contact, and probes again at slow_rate, up to retract past the contact. The slow
+// touch is the accurate one, and the fast approach keeps the whole cycle short. With touches > 1
+// it backs off and touches slowly that many times and takes the average contact. Every touch
+// reports its PRB position, and the average of several slow touches one more.
+GCUpdatePos mc_probe_two_phase(float* target, plan_line_data_t* pl_data, uint8_t parser_flags, float retract, float slow_rate, uint8_t touches) {
+    // Unit vector along the probing line
+    auto  n_axis                = number_axis->get();
+    float direction[MAX_N_AXIS] = { 0.0 };
+    float length                = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        direction[idx] = target[idx] - gc_state.position[idx];
+        length += direction[idx] * direction[idx];
+    }
+    length = sqrt(length);
+    if (length == 0.0) {
+        return mc_probe_cycle(target, pl_data, parser_flags);  // No line to back off along
+    }
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        direction[idx] /= length;
+    }
+
+    GCUpdatePos result = mc_probe_cycle(target, pl_data, parser_flags);
+    if (!sys.probe_succeeded || sys.abort || sys.state == State::CheckMode) {
+        return result;
+    }
+
+    float fast_rate = pl_data->feed_rate;
+    if (slow_rate <= 0.0) {
+        slow_rate = fast_rate * PROBE_SLOW_FEED_FRACTION;
+    }
+    bool  is_probe_away           = bit_istrue(parser_flags, GCParserProbeIsAway);
+    float contact_sum[MAX_N_AXIS] = { 0.0 };
+    float contact[MAX_N_AXIS];
+    float point[MAX_N_AXIS];
+    for (uint8_t touch = 0; touch < touches; touch++) {
+        // Back off to retract before the contact at the fast feed rate, then touch again slowly. The
+        // motion stopped past the contact, by more than retract after a fast touch that overshot. If
+        // the probe is still triggered there, back off by retract more, up to the length of the line.
+        system_convert_array_steps_to_mpos(contact, sys_probe_position);
+        gc_sync_position();
+        for (float backoff = retract;; backoff += retract) {
+            for (uint8_t idx = 0; idx < n_axis; idx++) {
+                point[idx] = contact[idx] - direction[idx] * backoff;
+            }
+            pl_data->feed_rate = fast_rate;
+            limitsCheckSoft(point);
+            cartesian_to_motors(point, pl_data, gc_state.position);
+            memcpy(gc_state.position, point, sizeof(point));
+            protocol_buffer_synchronize();
+            if (sys.abort) {
+                return GCUpdatePos::None;
+            }
+            if (!(probe_get_state() ^ is_probe_away) || backoff >= length) {
+                break;  // Clear, or mc_probe_cycle() raises the alarm
+            }
+        }
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            point[idx] = contact[idx] + direction[idx] * retract;
+        }
+        pl_data->feed_rate = slow_rate;
+        result             = mc_probe_cycle(point, pl_data, parser_flags);
+        if (!sys.probe_succeeded || sys.abort) {
+            memcpy(target, point, sizeof(point));  // Where a slow touch without contact ended
+            return result;
+        }
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            contact_sum[idx] += sys_probe_position[idx];
+        }
+    }
+    if (touches > 1) {
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            sys_probe_position[idx] = lround(contact_sum[idx] / touches);
+        }
+#ifdef MESSAGE_PROBE_COORDINATES
+        report_probe_parameters(CLIENT_ALL);
+#endif
+    }
+    return result;
+}
+
 // Plans and executes the single special motion case for parking. Independent of main planner buffer.
 // NOTE: Uses the always free planner ring buffer head to store motion parameters for execution.
 void mc_parking_motion(float* parking_target, plan_line_data_t* pl_data) {
@@ -51,16 +51,57 @@ void mc_arc(float*            target,
             uint8_t           axis_1,
             uint8_t           axis_linear,
             uint8_t           is_clockwise_arc);
+// Number of planner blocks mc_arc() queues for the arc.
+uint16_t mc_arc_blocks(float* target, float* position, float* offset, float radius, uint8_t axis_0, uint8_t axis_1, uint8_t is_clockwise_arc);
 
 // Dwell for a specific number of seconds
 bool mc_dwell(int32_t milliseconds);
 
+// Length of the travel to a well the dispense stroke is blended into, when M450 has no R word
+const float DISPENSE_BLEND_LENGTH = 2.0;  // mm
+
+#ifdef SYRINGE_AXIS
+// Travel to a well with the syringe stroke that dispenses into it blended into the end of the travel.
+// With deck_travel, the travel before the stroke lifts over the deck as mc_deck_travel() does.
+void mc_dispense(float* target, plan_line_data_t* pl_data, float* position, float blend, float rate, bool deck_travel);
+// Number of planner blocks mc_dispense() queues for the travel.
+uint16_t mc_dispense_blocks(float* target, float* position, float blend, bool deck_travel);
+#endif
+
+#ifdef DECK_MAP_ROWS
+// Most stretches of constant obstacle height a deck travel tracks. Past this, the stretches at the
+// end of the path merge into one at their highest height.
+const int DECK_TRAVEL_MAX_STRETCHES = 32;
+// Distance a polyline point may be off the line through its neighbours and still be left out
+const float DECK_TRAVEL_TOLERANCE = 0.001;  // mm
+
+// Rapid XY travel that lifts Z only as high as the deck map needs along the path.
+void mc_deck_travel(float* target, plan_line_data_t* pl_data, float* position);
+// Number of planner blocks mc_deck_travel() queues for the travel.
+uint16_t mc_deck_travel_blocks(float* target, float* position);
+#endif
+
+// Time spent shaking at each frequency of a resonance sweep, and the smallest amplitude worth shaking
+const float RESONANCE_SWEEP_SECONDS   = 1.0;
+const int   RESONANCE_SWEEP_MIN_STEPS = 2;
+
+// Shake one axis at rising frequencies to find the resonances for its input shaper.
+Error mc_resonance_sweep(uint8_t axis, float freq_start, float freq_end, float freq_step);
+
 // Perform homing cycle to locate machine zero. Requires limit switches.
 void mc_homing_cycle(uint8_t cycle_mask);
 
 // Perform tool length probe cycle. Requires probe switch.
 GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t parser_flags);
 
+// Most slow touches a two-phase probe averages, and the slow feed rate as a fraction of the fast
+// one when none is given
+const int   PROBE_MAX_TOUCHES        = 10;
+const float PROBE_SLOW_FEED_FRACTION = 0.1;
+
+// Probe fast, back off and probe slowly, for liquid level detection in one command.
+GCUpdatePos mc_probe_two_phase(float* target, plan_line_data_t* pl_data, uint8_t parser_flags, float retract, float slow_rate, uint8_t touches);
+
 // Handles updating the override control state.
 void mc_override_ctrl_update(uint8_t override_state);
 
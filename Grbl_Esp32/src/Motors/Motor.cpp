@@ -37,6 +37,11 @@ namespace Motors {
 
     void Motor::debug_message() {}
 
+    void IRAM_ATTR Motor::set_disable(bool disable) {}
+    void IRAM_ATTR Motor::set_direction(bool) {}
+    void IRAM_ATTR Motor::step() {}
+    void IRAM_ATTR Motor::unstep() {}
+
     bool Motor::test() { return true; };  // true = OK
 
 }
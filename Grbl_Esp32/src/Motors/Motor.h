@@ -65,23 +65,35 @@ namespace Motors {
 
         // set_disable() disables or enables a motor.  It is used to
         // make a motor transition between idle and non-idle states.
-        virtual void set_disable(bool disable) {}
+        //
+        // set_disable(), set_direction(), step() and unstep() can be
+        // called from the stepper ISR, so implementations must be
+        // IRAM_ATTR.  The defaults are in Motor.cpp for that reason;
+        // inline bodies here would be emitted to flash.
+        virtual void set_disable(bool disable);
 
         // set_direction() sets the motor movement direction.  It is
         // invoked for every motion segment.
-        virtual void set_direction(bool) {}
+        virtual void set_direction(bool);
 
         // step() initiates a step operation on a motor.  It is called
         // from motors_step() for ever motor than needs to step now.
         // For ordinary step/direction motors, it sets the step pin
         // to the active state.
-        virtual void step() {}
+        virtual void step();
 
         // unstep() turns off the step pin, if applicable, for a motor.
         // It is called from motors_unstep() for all motors, since
         // motors_unstep() is used in many contexts where the previous
         // states of the step pins are unknown.
-        virtual void unstep() {}
+        virtual void unstep();
+
+        // i2s_bits() reports the I2S output expander bits used by the
+        // step and direction pins, so motors_step(), motors_unstep()
+        // and motors_direction() can update all motors with a single
+        // write of the expander word.  It returns false if the motor
+        // must be driven through step(), unstep() and set_direction().
+        virtual bool i2s_bits(uint32_t& step_bit, uint32_t& dir_bit, bool& step_invert, bool& dir_invert) { return false; }
 
         // test(), called from init(), checks to see if a motor is
         // responsive, returning true on failure.  Typical
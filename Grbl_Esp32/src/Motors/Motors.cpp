@@ -35,6 +35,8 @@
 #include "Motor.h"
 #include "../Grbl.h"
 
+#include <soc/soc_memory_layout.h>
+
 #include "NullMotor.h"
 #include "StandardStepper.h"
 #include "UnipolarMotor.h"
@@ -44,7 +46,64 @@
 #include "TrinamicUartDriver.h"
 
 Motors::Motor* myMotor[MAX_AXES][MAX_GANGED];  // number of axes (normal and ganged)
-void           init_motors() {
+
+// The motor methods the stepper ISR calls, resolved once per motor by motors_resolve_isr().
+// Calling through these instead of the virtual methods keeps the ISR from reading the vtables,
+// which are in flash.
+typedef void (*motor_fn_t)(Motors::Motor*);
+typedef void (*motor_bool_fn_t)(Motors::Motor*, bool);
+typedef struct {
+    motor_fn_t      step;
+    motor_fn_t      unstep;
+    motor_bool_fn_t set_direction;
+    motor_bool_fn_t set_disable;
+} motor_isr_t;
+static motor_isr_t motors_isr[MAX_AXES][MAX_GANGED];
+
+#ifdef USE_I2S_OUT
+// When the step and direction pins of every motor are on the I2S expander,
+// motors_step(), motors_unstep() and motors_direction() build one set/clear
+// mask for all axes and commit it with a single i2s_out_write_mask(), so one
+// step event is one shift register latch instead of one write per pin.
+typedef struct {
+    uint32_t step_set;    // bits to set to turn the step pin on
+    uint32_t step_clear;  // bits to clear to turn the step pin on
+    uint32_t dir_set;     // bits to set for direction true
+    uint32_t dir_clear;   // bits to clear for direction true
+} motor_i2s_bits_t;
+
+static bool             motors_i2s_batch = false;
+static motor_i2s_bits_t motors_i2s_bits[MAX_AXES][MAX_GANGED];
+static uint32_t         motors_i2s_unstep_set;  // the "on" bits of step are the "off" bits of unstep
+static uint32_t         motors_i2s_unstep_clear;
+
+static void motors_read_i2s_bits() {
+    auto n_axis             = number_axis->get();
+    motors_i2s_batch        = false;
+    motors_i2s_unstep_set   = 0;
+    motors_i2s_unstep_clear = 0;
+    memset(motors_i2s_bits, 0, sizeof(motors_i2s_bits));
+    for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+        for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+            uint32_t step_bit, dir_bit;
+            bool     step_invert, dir_invert;
+            if (!myMotor[axis][gang_index]->i2s_bits(step_bit, dir_bit, step_invert, dir_invert)) {
+                return;  // at least one motor needs to be driven pin by pin
+            }
+            motor_i2s_bits_t& bits = motors_i2s_bits[axis][gang_index];
+            bits.step_set          = step_invert ? 0 : step_bit;
+            bits.step_clear        = step_invert ? step_bit : 0;
+            bits.dir_set           = dir_invert ? 0 : dir_bit;
+            bits.dir_clear         = dir_invert ? dir_bit : 0;
+            motors_i2s_unstep_set |= bits.step_clear;
+            motors_i2s_unstep_clear |= bits.step_set;
+        }
+    }
+    motors_i2s_batch = true;
+}
+#endif
+
+void init_motors() {
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Init Motors");
 
     auto n_axis = number_axis->get();
@@ -409,9 +468,57 @@ void           init_motors() {
             myMotor[axis][gang_index]->init();
         }
     }
+#ifdef USE_I2S_OUT
+    motors_read_i2s_bits();
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "I2S batched step output:%s", motors_i2s_batch ? "On" : "Off");
+#endif
+    motors_resolve_isr();
+}
+
+void motors_resolve_isr() {
+    // GCC extension: the function a virtual method resolves to for this object
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+    for (uint8_t axis = X_AXIS; axis < MAX_AXES; axis++) {
+        for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+            Motors::Motor* m  = myMotor[axis][gang_index];
+            motor_isr_t&   fn = motors_isr[axis][gang_index];
+            if (m == NULL) {
+                fn = {};
+                continue;
+            }
+            fn.step          = (motor_fn_t)(m->*(&Motors::Motor::step));
+            fn.unstep        = (motor_fn_t)(m->*(&Motors::Motor::unstep));
+            fn.set_direction = (motor_bool_fn_t)(m->*(&Motors::Motor::set_direction));
+            fn.set_disable   = (motor_bool_fn_t)(m->*(&Motors::Motor::set_disable));
+        }
+    }
+#pragma GCC diagnostic pop
+}
+
+bool motors_isr_in_iram() {
+    auto n_axis = number_axis->get();
+    for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+        for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+            const motor_isr_t& fn = motors_isr[axis][gang_index];
+            if (fn.set_disable == NULL || !esp_ptr_in_iram((const void*)fn.set_disable)) {
+                return false;
+            }
+#ifdef USE_I2S_OUT
+            if (motors_i2s_batch) {
+                continue;  // Steps and directions go out as one I2S mask
+            }
+#endif
+            if (!esp_ptr_in_iram((const void*)fn.step) || !esp_ptr_in_iram((const void*)fn.unstep) ||
+                !esp_ptr_in_iram((const void*)fn.set_direction)) {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
-void motors_set_disable(bool disable, uint8_t mask) {
+void IRAM_ATTR motors_set_disable(bool disable, uint8_t mask) {
     static bool    prev_disable = true;
     static uint8_t prev_mask    = 0;
 
@@ -422,16 +529,16 @@ void motors_set_disable(bool disable, uint8_t mask) {
     prev_disable = disable;
     prev_mask    = mask;
 
-    if (step_enable_invert->get()) {
+    if (st_config.step_enable_invert) {
         disable = !disable;  // Apply pin invert.
     }
 
     // now loop through all the motors to see if they can individually disable
-    auto n_axis = number_axis->get();
+    auto n_axis = st_config.n_axis;
     for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
         for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
             if (bitnum_istrue(mask, axis)) {
-                myMotor[axis][gang_index]->set_disable(disable);
+                motors_isr[axis][gang_index].set_disable(myMotor[axis][gang_index], disable);
             }
         }
     }
@@ -441,7 +548,7 @@ void motors_set_disable(bool disable, uint8_t mask) {
 
     // Add an optional delay for stepper drivers. that need time
     // Some need time after the enable before they can step.
-    auto wait_disable_change = enable_delay_microseconds->get();
+    auto wait_disable_change = st_config.enable_delay_microseconds;
     if (wait_disable_change != 0) {
         auto disable_start_time = esp_timer_get_time() + wait_disable_change;
 
@@ -453,12 +560,17 @@ void motors_set_disable(bool disable, uint8_t mask) {
 
 void motors_read_settings() {
     //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Read Settings");
+    st_read_settings();
     auto n_axis = number_axis->get();
     for (uint8_t gang_index = 0; gang_index < 2; gang_index++) {
         for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
             myMotor[axis][gang_index]->read_settings();
         }
     }
+#ifdef USE_I2S_OUT
+    motors_read_i2s_bits();
+    st_isr_attach();  // Pin by pin stepping may have to leave IRAM
+#endif
 }
 
 // use this to tell all the motors what the current homing mode is
@@ -477,8 +589,8 @@ uint8_t motors_set_homing_mode(uint8_t homing_mask, bool isHoming) {
     return can_home;
 }
 
-bool motors_direction(uint8_t dir_mask) {
-    auto n_axis = number_axis->get();
+bool IRAM_ATTR motors_direction(uint8_t dir_mask) {
+    auto n_axis = st_config.n_axis;
     //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "motors_set_direction_pins:0x%02X", onMask);
 
     // Set the direction pins, but optimize for the common
@@ -487,10 +599,29 @@ bool motors_direction(uint8_t dir_mask) {
     if (dir_mask != previous_dir) {
         previous_dir = dir_mask;
 
+#ifdef USE_I2S_OUT
+        if (motors_i2s_batch) {
+            uint32_t set = 0, clear = 0;
+            for (int axis = X_AXIS; axis < n_axis; axis++) {
+                for (int gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+                    const motor_i2s_bits_t& bits = motors_i2s_bits[axis][gang_index];
+                    if (bitnum_istrue(dir_mask, axis)) {
+                        set |= bits.dir_set;
+                        clear |= bits.dir_clear;
+                    } else {
+                        set |= bits.dir_clear;
+                        clear |= bits.dir_set;
+                    }
+                }
+            }
+            i2s_out_write_mask(set, clear);
+            return true;
+        }
+#endif
         for (int axis = X_AXIS; axis < n_axis; axis++) {
             bool thisDir = bitnum_istrue(dir_mask, axis);
-            myMotor[axis][0]->set_direction(thisDir);
-            myMotor[axis][1]->set_direction(thisDir);
+            motors_isr[axis][0].set_direction(myMotor[axis][0], thisDir);
+            motors_isr[axis][1].set_direction(myMotor[axis][1], thisDir);
         }
 
         return true;
@@ -499,27 +630,52 @@ bool motors_direction(uint8_t dir_mask) {
     }
 }
 
-void motors_step(uint8_t step_mask) {
-    auto n_axis = number_axis->get();
+void IRAM_ATTR motors_step(uint8_t step_mask) {
+    auto n_axis = st_config.n_axis;
     //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "motors_set_direction_pins:0x%02X", onMask);
 
+#ifdef USE_I2S_OUT
+    if (motors_i2s_batch) {
+        uint32_t set = 0, clear = 0;
+        for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+            if (bitnum_istrue(step_mask, axis)) {
+                if ((ganged_mode == SquaringMode::Dual) || (ganged_mode == SquaringMode::A)) {
+                    set |= motors_i2s_bits[axis][0].step_set;
+                    clear |= motors_i2s_bits[axis][0].step_clear;
+                }
+                if ((ganged_mode == SquaringMode::Dual) || (ganged_mode == SquaringMode::B)) {
+                    set |= motors_i2s_bits[axis][1].step_set;
+                    clear |= motors_i2s_bits[axis][1].step_clear;
+                }
+            }
+        }
+        i2s_out_write_mask(set, clear);
+        return;
+    }
+#endif
     // Turn on step pulses for motors that are supposed to step now
     for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
         if (bitnum_istrue(step_mask, axis)) {
             if ((ganged_mode == SquaringMode::Dual) || (ganged_mode == SquaringMode::A)) {
-                myMotor[axis][0]->step();
+                motors_isr[axis][0].step(myMotor[axis][0]);
             }
             if ((ganged_mode == SquaringMode::Dual) || (ganged_mode == SquaringMode::B)) {
-                myMotor[axis][1]->step();
+                motors_isr[axis][1].step(myMotor[axis][1]);
             }
         }
     }
 }
 // Turn all stepper pins off
-void motors_unstep() {
-    auto n_axis = number_axis->get();
+void IRAM_ATTR motors_unstep() {
+#ifdef USE_I2S_OUT
+    if (motors_i2s_batch) {
+        i2s_out_write_mask(motors_i2s_unstep_set, motors_i2s_unstep_clear);
+        return;
+    }
+#endif
+    auto n_axis = st_config.n_axis;
     for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
-        myMotor[axis][0]->unstep();
-        myMotor[axis][1]->unstep();
+        motors_isr[axis][0].unstep(myMotor[axis][0]);
+        motors_isr[axis][1].unstep(myMotor[axis][1]);
     }
 }
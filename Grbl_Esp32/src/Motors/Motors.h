@@ -37,6 +37,11 @@ uint8_t get_next_trinamic_driver_index();
 void    readSgTask(void* pvParameters);
 void    motors_read_settings();
 
+// Resolves the motor methods that the stepper ISR calls. Called by init_motors().
+void motors_resolve_isr();
+// True if every motor method that the stepper ISR calls is in IRAM
+bool motors_isr_in_iram();
+
 // The return value is a bitmask of axes that can home
 uint8_t motors_set_homing_mode(uint8_t homing_mask, bool isHoming);
 void    motors_set_disable(bool disable, uint8_t mask = B11111111);  // default is all axes
@@ -7,5 +7,9 @@ namespace Motors {
     public:
         Nullmotor(uint8_t axis_index);
         bool set_homing_mode(bool isHoming) { return false; }
+        bool i2s_bits(uint32_t& step_bit, uint32_t& dir_bit, bool& step_invert, bool& dir_invert) override {
+            step_bit = dir_bit = 0;  // No pins, nothing to batch
+            return true;
+        }
     };
 }
@@ -99,13 +99,15 @@ namespace Motors {
     void RcServo::set_location() {
         uint32_t servo_pulse_len;
         float    servo_pos, mpos, offset;
+        int32_t  steps[MAX_N_AXIS];
 
         if (_disabled)
             return;
 
         read_settings();
 
-        mpos = system_convert_axis_steps_to_mpos(sys_position, _axis_index);  // get the axis machine position in mm
+        st_get_realtime_position(steps);
+        mpos = system_convert_axis_steps_to_mpos(steps, _axis_index);  // get the axis machine position in mm
         // TBD working in MPos
         offset    = 0;  // gc_state.coord_system[axis_index] + gc_state.coord_offset[axis_index];  // get the current axis work offset
         servo_pos = mpos - offset;  // determine the current work position
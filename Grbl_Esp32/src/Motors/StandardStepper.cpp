@@ -106,7 +106,7 @@ namespace Motors {
                        reportAxisLimitsMsg(_axis_index));
     }
 
-    void StandardStepper::step() {
+    void IRAM_ATTR StandardStepper::step() {
 #ifdef USE_RMT_STEPS
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
         // ESP32-S3 has different RMT register structure - disable RMT for now
@@ -120,15 +120,31 @@ namespace Motors {
 #endif  // USE_RMT_STEPS
     }
 
-    void StandardStepper::unstep() {
+    void IRAM_ATTR StandardStepper::unstep() {
 #ifndef USE_RMT_STEPS
         digitalWrite(_step_pin, _invert_step_pin);
 #endif  // USE_RMT_STEPS
     }
 
-    void StandardStepper::set_direction(bool dir) { digitalWrite(_dir_pin, dir ^ _invert_dir_pin); }
+    bool StandardStepper::i2s_bits(uint32_t& step_bit, uint32_t& dir_bit, bool& step_invert, bool& dir_invert) {
+#if defined(USE_I2S_OUT) && !defined(USE_RMT_STEPS)
+        auto on_i2s = [](uint8_t pin) { return pin >= I2S_OUT_PIN_BASE && pin != UNDEFINED_PIN; };
+        if (!on_i2s(_step_pin) || (_dir_pin != UNDEFINED_PIN && !on_i2s(_dir_pin))) {
+            return false;
+        }
+        step_bit    = 1UL << (_step_pin - I2S_OUT_PIN_BASE);
+        dir_bit     = (_dir_pin == UNDEFINED_PIN) ? 0 : 1UL << (_dir_pin - I2S_OUT_PIN_BASE);
+        step_invert = _invert_step_pin;
+        dir_invert  = _invert_dir_pin;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void IRAM_ATTR StandardStepper::set_direction(bool dir) { digitalWrite(_dir_pin, dir ^ _invert_dir_pin); }
 
-    void StandardStepper::set_disable(bool disable) {
+    void IRAM_ATTR StandardStepper::set_disable(bool disable) {
         digitalWrite(_disable_pin, disable);
     }
 }
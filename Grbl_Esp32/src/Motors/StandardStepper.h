@@ -16,6 +16,7 @@ namespace Motors {
         void step() override;
         void unstep() override;
         void read_settings() override;
+        bool i2s_bits(uint32_t& step_bit, uint32_t& dir_bit, bool& step_invert, bool& dir_invert) override;
 
         void init_step_dir_pins();
 
@@ -29,7 +29,7 @@ namespace Motors {
                        reportAxisLimitsMsg(_axis_index));
     }
 
-    void UnipolarMotor::set_disable(bool disable) {
+    void IRAM_ATTR UnipolarMotor::set_disable(bool disable) {
         if (disable) {
             digitalWrite(_pin_phase0, 0);
             digitalWrite(_pin_phase1, 0);
@@ -39,9 +39,9 @@ namespace Motors {
         _enabled = !disable;
     }
 
-    void UnipolarMotor::set_direction(bool dir) { _dir = dir; }
+    void IRAM_ATTR UnipolarMotor::set_direction(bool dir) { _dir = dir; }
 
-    void UnipolarMotor::step() {
+    void IRAM_ATTR UnipolarMotor::step() {
         uint8_t _phase[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };  // temporary phase values...all start as off
         uint8_t phase_max;
 
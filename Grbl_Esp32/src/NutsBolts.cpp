@@ -174,6 +174,25 @@ float limit_acceleration_by_axis_maximum(float* unit_vec) {
     return limit_value * SEC_PER_MIN_SQ;
 }
 
+// Same as limit_acceleration_by_axis_maximum() for the $<axis>/Jerk settings, except that axes
+// without a jerk limit (0) don't constrain the line. Returns 0 if none of the moving axes has one.
+float limit_jerk_by_axis_maximum(float* unit_vec) {
+    uint8_t idx;
+    float   limit_value = SOME_LARGE_VALUE;
+    auto    n_axis      = number_axis->get();
+    for (idx = 0; idx < n_axis; idx++) {
+        float jerk = axis_settings[idx]->jerk->get();
+        if (unit_vec[idx] != 0 && jerk > 0) {  // Avoid divide by zero.
+            limit_value = MIN(limit_value, fabs(jerk / unit_vec[idx]));
+        }
+    }
+    if (limit_value == SOME_LARGE_VALUE) {
+        return 0.0;
+    }
+    // mm/sec^3 to mm/min^3
+    return limit_value * SEC_PER_MIN_CU;
+}
+
 float limit_rate_by_axis_maximum(float* unit_vec) {
     uint8_t idx;
     float   limit_value = SOME_LARGE_VALUE;
@@ -1,6 +1,8 @@
 #include "Grbl.h"
 #include "I2SOut.h"
 
+#include <hal/gpio_ll.h>
+
 String pinName(uint8_t pin) {
     if (pin == UNDEFINED_PIN) {
         return "None";
@@ -17,12 +19,14 @@ String pinName(uint8_t pin) {
 // the weak aliases in the library to apply, because of
 // the UNDEFINED_PIN check.  That UNDEFINED_PIN behavior
 // cleans up other code by eliminating ifdefs and checks.
+// digitalWrite() and digitalRead() go straight to the GPIO registers, because the stepper
+// ISR calls them and the library versions are in flash.
 void IRAM_ATTR digitalWrite(uint8_t pin, uint8_t val) {
     if (pin == UNDEFINED_PIN) {
         return;
     }
     if (pin < I2S_OUT_PIN_BASE) {
-        __digitalWrite(pin, val);
+        gpio_ll_set_level(&GPIO, (gpio_num_t)pin, val);
         return;
     }
 #ifdef USE_I2S_OUT
@@ -46,7 +50,7 @@ int IRAM_ATTR digitalRead(uint8_t pin) {
         return 0;
     }
     if (pin < I2S_OUT_PIN_BASE) {
-        return __digitalRead(pin);
+        return gpio_ll_get_level(&GPIO, (gpio_num_t)pin);
     }
 #ifdef USE_I2S_OUT
     return i2s_out_read(pin - I2S_OUT_PIN_BASE);
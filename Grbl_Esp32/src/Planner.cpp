@@ -26,7 +26,8 @@
 #include "Grbl.h"
 #include <stdlib.h>  // PSoc Required for labs
 
-static plan_block_t block_buffer[BLOCK_BUFFER_SIZE];  // A ring buffer for motion instructions
+static plan_block_t* block_buffer;                    // A ring buffer for motion instructions
+static uint8_t       block_buffer_size;               // Number of blocks in block_buffer
 static uint8_t      block_buffer_tail;                // Index of the block to process now
 static uint8_t      block_buffer_head;                // Index of the next block to be pushed
 static uint8_t      next_buffer_head;                 // Index of the next buffer head
@@ -45,7 +46,7 @@ static planner_t pl;
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
 uint8_t plan_next_block_index(uint8_t block_index) {
     block_index++;
-    if (block_index == BLOCK_BUFFER_SIZE) {
+    if (block_index == block_buffer_size) {
         block_index = 0;
     }
     return block_index;
@@ -54,7 +55,7 @@ uint8_t plan_next_block_index(uint8_t block_index) {
 // Returns the index of the previous block in the ring buffer
 static uint8_t plan_prev_block_index(uint8_t block_index) {
     if (block_index == 0) {
-        block_index = BLOCK_BUFFER_SIZE;
+        block_index = block_buffer_size;
     }
     block_index--;
     return block_index;
@@ -124,8 +125,13 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   to compute an optimal plan, so select carefully. The Arduino 328p memory is already maxed out, but future
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
+  With a deep buffer, the reverse pass for a new block stops after max_blocks blocks. The blocks
+  before that were planned for a stop closer to them, so their entry speeds can only be lower than
+  optimal, never unsafe. A full replan (max_blocks = buffer size) is needed when the speed limits
+  of buffered blocks change, as with overrides.
+
 */
-static void planner_recalculate() {
+static void planner_recalculate(uint8_t max_blocks) {
     // Initialize block index to the last block in the planner buffer.
     uint8_t block_index = plan_prev_block_index(block_buffer_head);
     // Bail. Can't do anything with one only one plan-able block.
@@ -148,6 +154,12 @@ static void planner_recalculate() {
         }
     } else {  // Three or more plan-able blocks
         while (block_index != block_buffer_planned) {
+            if (--max_blocks == 0) {
+                // Leave the older blocks as they are and forward plan from here, since the
+                // blocks behind are unchanged and already consistent.
+                block_buffer_planned = block_index;
+                break;
+            }
             next        = current;
             current     = &block_buffer[block_index];
             block_index = plan_prev_block_index(block_index);
@@ -195,9 +207,40 @@ static void planner_recalculate() {
     }
 }
 
+// Allocates the block buffer in internal RAM, sized by $Planner/Blocks. Falls back to the
+// compiled in BLOCK_BUFFER_SIZE if there is not enough memory.
+void plan_init() {
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    block_buffer_size   = planner_blocks->get();
+    block_buffer        = (plan_block_t*)heap_caps_calloc(block_buffer_size, sizeof(plan_block_t), caps);
+    if (block_buffer == NULL) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot allocate %d planner blocks", block_buffer_size);
+        block_buffer_size = BLOCK_BUFFER_SIZE;
+        block_buffer      = (plan_block_t*)heap_caps_calloc(block_buffer_size, sizeof(plan_block_t), caps);
+        if (block_buffer == NULL) {
+            // Nothing can move without a planner. Stop the boot here rather than run on no buffer.
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot allocate the planner. Halted");
+            while (true) {
+                vTaskDelay(portMAX_DELAY);
+            }
+        }
+    }
+    grbl_msg_sendf(CLIENT_SERIAL,
+                   MsgLevel::Info,
+                   "Planner %d blocks, %d bytes",
+                   block_buffer_size,
+                   block_buffer_size * sizeof(plan_block_t));
+}
+
+uint8_t plan_get_block_buffer_size() {
+    return block_buffer_size;
+}
+
 void plan_reset() {
+    st_prep_lock();
     memset(&pl, 0, sizeof(planner_t));  // Clear planner struct
     plan_reset_buffer();
+    st_prep_unlock();
 }
 
 void plan_reset_buffer() {
@@ -281,6 +324,7 @@ static void plan_compute_profile_parameters(plan_block_t* block, float nominal_s
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters() {
+    st_prep_lock();
     uint8_t       block_index = block_buffer_tail;
     plan_block_t* block;
     float         nominal_speed;
@@ -293,9 +337,26 @@ void plan_update_velocity_profile_parameters() {
         block_index        = plan_next_block_index(block_index);
     }
     pl.previous_nominal_speed = prev_nominal_speed;  // Update prev nominal speed for next incoming block.
+    st_prep_unlock();
+}
+
+// The segment generator shapes every ramp of a jerk-limited block as an S-curve that takes
+// the same time and distance as the planner's constant acceleration ramp, so entry and exit
+// speeds are planned exactly as for a trapezoid. An S-curve ramp peaks at up to twice its
+// average acceleration, and it can keep within the jerk limit only if it changes speed by at
+// least 4*a^2/jerk. Size the average acceleration so the peak stays within the axis limit and
+// a move that starts and ends at rest, which changes speed by min(nominal, sqrt(a*mm)) per
+// ramp, stays within the jerk limit.
+static float plan_jerk_limit_acceleration(plan_block_t* block) {
+    float acceleration = 0.5 * block->acceleration;
+    acceleration       = MIN(acceleration, sqrt(0.25 * block->jerk * MAX(block->programmed_rate, MINIMUM_FEED_RATE)));
+    acceleration       = MIN(acceleration, pow(0.25 * block->jerk * sqrt(block->millimeters), 2.0 / 3.0));
+    return acceleration;
 }
 
 uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+    // The segment prep task reads the blocks and runs st_update_plan_block_parameters().
+    st_prep_lock();
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
     plan_block_t* block = &block_buffer[block_buffer_head];
     memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
@@ -313,7 +374,7 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     uint8_t idx;
     // Copy position data based on type of motion being planned.
     if (block->motion.systemMotion) {
-        memcpy(position_steps, sys_position, sizeof(sys_position));
+        st_get_realtime_position(position_steps);
     } else {
         memcpy(position_steps, pl.position, sizeof(pl.position));
     }
@@ -334,6 +395,7 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     }
     // Bail if this is a zero-length block. Highly unlikely to occur.
     if (block->step_event_count == 0) {
+        st_prep_unlock();
         return PLAN_EMPTY_BLOCK;
     }
 
@@ -353,6 +415,10 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
             block->programmed_rate *= block->millimeters;
         }
     }
+    block->jerk = limit_jerk_by_axis_maximum(unit_vec);
+    if (block->jerk > 0.0) {
+        block->acceleration = plan_jerk_limit_acceleration(block);
+    }
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
     if ((block_buffer_head == block_buffer_tail) || (block->motion.systemMotion)) {
         // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
@@ -417,8 +483,10 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         block_buffer_head = next_buffer_head;
         next_buffer_head  = plan_next_block_index(block_buffer_head);
         // Finish up by recalculating the plan with the new block.
-        planner_recalculate();
+        planner_recalculate(PLANNER_MAX_REPLAN_BLOCKS);
     }
+    st_prep_unlock();
+    st_prep_wake();  // Let the segment prep task pick up the new block
     return PLAN_OK;
 }
 
@@ -426,17 +494,40 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
 void plan_sync_position() {
     // TODO: For motor configurations not in the same coordinate frame as the machine position,
     // this function needs to be updated to accomodate the difference.
+    int32_t steps[MAX_N_AXIS];
+    st_get_realtime_position(steps);
     uint8_t idx;
     auto    n_axis = number_axis->get();
     for (idx = 0; idx < n_axis; idx++) {
-        pl.position[idx] = sys_position[idx];
+        pl.position[idx] = steps[idx];
+    }
+}
+
+int32_t plan_get_axis_position(uint8_t axis) {
+    return pl.position[axis];
+}
+
+void plan_set_axis_position(uint8_t axis, int32_t steps) {
+    pl.position[axis] = steps;
+}
+
+bool plan_axis_queued(uint8_t axis) {
+    bool queued = false;
+    st_prep_lock();  // The segment prep discards blocks from the tail
+    for (uint8_t index = block_buffer_tail; index != block_buffer_head; index = plan_next_block_index(index)) {
+        if (block_buffer[index].steps[axis]) {
+            queued = true;
+            break;
+        }
     }
+    st_prep_unlock();
+    return queued;
 }
 
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available() {
     if (block_buffer_head >= block_buffer_tail) {
-        return (BLOCK_BUFFER_SIZE - 1) - (block_buffer_head - block_buffer_tail);
+        return (block_buffer_size - 1) - (block_buffer_head - block_buffer_tail);
     } else {
         return block_buffer_tail - block_buffer_head - 1;
     }
@@ -448,7 +539,7 @@ uint8_t plan_get_block_buffer_count() {
     if (block_buffer_head >= block_buffer_tail) {
         return block_buffer_head - block_buffer_tail;
     } else {
-        return BLOCK_BUFFER_SIZE - (block_buffer_tail - block_buffer_head);
+        return block_buffer_size - (block_buffer_tail - block_buffer_head);
     }
 }
 
@@ -456,7 +547,9 @@ uint8_t plan_get_block_buffer_count() {
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize() {
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
+    st_prep_lock();
     st_update_plan_block_parameters();
     block_buffer_planned = block_buffer_tail;
-    planner_recalculate();
+    planner_recalculate(block_buffer_size);
+    st_prep_unlock();
 }
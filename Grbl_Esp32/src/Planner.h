@@ -24,7 +24,8 @@
   along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-// The number of linear motions that can be in the plan at any give time
+// The number of linear motions that can be in the plan at any give time. This is the
+// default of the $Planner/Blocks setting, which sizes the buffer at boot.
 #ifndef BLOCK_BUFFER_SIZE
 #    ifdef USE_LINE_NUMBERS
 #        define BLOCK_BUFFER_SIZE 15
@@ -33,6 +34,18 @@
 #    endif
 #endif
 
+// Upper limit for $Planner/Blocks. Block indexes are uint8_t.
+#ifndef MAX_BLOCK_BUFFER_SIZE
+#    define MAX_BLOCK_BUFFER_SIZE 128
+#endif
+
+// The most blocks the reverse pass of planner_recalculate() walks back per new block. Blocks
+// further back keep their previous, lower but safe, entry speeds. Bounds the planning time with
+// a deep planner buffer; that far back a block rarely gains speed from the newest one anyway.
+#ifndef PLANNER_MAX_REPLAN_BLOCKS
+#    define PLANNER_MAX_REPLAN_BLOCKS 32
+#endif
+
 // Returned status message from planner.
 const int PLAN_OK          = true;
 const int PLAN_EMPTY_BLOCK = false;
@@ -43,6 +56,7 @@ struct PlMotion {
     uint8_t systemMotion : 1;    // Single motion. Circumvents planner state. Used by home/park.
     uint8_t noFeedOverride : 1;  // Motion does not honor feed override.
     uint8_t inverseTime : 1;     // Interprets feed rate value as inverse time when set.
+    uint8_t noShaping : 1;       // Motion is not input shaped. Used by the resonance sweep.
 };
 
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
@@ -68,6 +82,8 @@ typedef struct {
     float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
     //   neighboring nominal speeds with overrides in (mm/min)^2
     float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+    // For a jerk-limited block this is the average acceleration of each ramp. See plan_jerk_limit_acceleration().
+    float jerk;  // Axis-limit adjusted line jerk in (mm/min^3). 0 for a trapezoid profile. Does not change.
     float millimeters;   // The remaining distance for this block to be executed in (mm).
     // NOTE: This value may be altered by stepper algorithm during execution.
 
@@ -94,6 +110,9 @@ typedef struct {
     bool         is_jog;         // true if this was generated due to a jog command
 } plan_line_data_t;
 
+// Allocate the block buffer, sized by $Planner/Blocks. Called once at boot.
+void plan_init();
+
 // Initialize and reset the motion plan subsystem
 void plan_reset();         // Reset all
 void plan_reset_buffer();  // Reset buffer only.
@@ -128,12 +147,22 @@ void plan_update_velocity_profile_parameters();
 // Reset the planner position vector (in steps)
 void plan_sync_position();
 
+// Get or set the planner position of one axis (in steps). The next block starts from there.
+int32_t plan_get_axis_position(uint8_t axis);
+void    plan_set_axis_position(uint8_t axis, int32_t steps);
+
+// Returns true if a block in the planner buffer moves axis.
+bool plan_axis_queued(uint8_t axis);
+
 // Reinitialize plan with a partially completed block
 void plan_cycle_reinitialize();
 
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available();
 
+// Returns the number of blocks the planner buffer was allocated with.
+uint8_t plan_get_block_buffer_size();
+
 // Returns the number of active blocks are in the planner buffer.
 // NOTE: Deprecated. Not used unless classic status reports are enabled in config.h
 uint8_t plan_get_block_buffer_count();
@@ -26,6 +26,17 @@
 // Inverts the probe pin state depending on user settings and probing cycle mode.
 static bool is_probe_away;
 
+#ifdef PROBE_EDGE_LATCH
+// Probe pin change interrupt. Both edges come here, and probe_state_monitor() sorts out which
+// one triggers the probe in the current cycle. Edges outside the motion of a probe cycle are ignored;
+// the pin level is checked again when the motion starts or resumes from a hold.
+static void IRAM_ATTR isr_probe() {
+    if (sys_probe_state == Probe::Active && sys.state == State::Cycle) {
+        probe_state_monitor();
+    }
+}
+#endif
+
 // Probe pin initialization routine.
 void probe_init() {
     static bool show_init_msg = true;  // used to show message only once.
@@ -36,6 +47,9 @@ void probe_init() {
 #else
         pinMode(PROBE_PIN, INPUT_PULLUP);  // Enable internal pull-up resistors. Normal high operation.
 #endif
+#ifdef PROBE_EDGE_LATCH
+        attachInterrupt(PROBE_PIN, isr_probe, CHANGE);
+#endif
 
         if (show_init_msg) {
             grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Probe on pin %s", pinName(PROBE_PIN).c_str());
@@ -49,17 +63,22 @@ void set_probe_direction(bool is_away) {
 }
 
 // Returns the probe pin state. Triggered = true. Called by gcode parser and probe state monitor.
-bool probe_get_state() {
-    return (PROBE_PIN == UNDEFINED_PIN) ? false : digitalRead(PROBE_PIN) ^ probe_invert->get();
+bool IRAM_ATTR probe_get_state() {
+    return (PROBE_PIN == UNDEFINED_PIN) ? false : digitalRead(PROBE_PIN) ^ st_config.probe_invert;
 }
 
-// Monitors probe pin state and records the system position when detected. Called by the
-// stepper ISR per ISR tick.
+// Monitors probe pin state and records the system position and time when detected. Called by
+// the probe pin interrupt with PROBE_EDGE_LATCH, otherwise by the stepper ISR per ISR tick.
 // NOTE: This function must be extremely efficient as to not bog down the stepper ISR.
-void probe_state_monitor() {
+void IRAM_ATTR probe_state_monitor() {
     if (probe_get_state() ^ is_probe_away) {
         sys_probe_state = Probe::Off;
-        memcpy(sys_probe_position, sys_position, sizeof(sys_position));
+        st_get_realtime_position(sys_probe_position);
+        sys_probe_time = esp_timer_get_time();
+#ifdef USE_I2S_STEPS
+        // Steps counted so far are still queued for the drivers in stream mode
+        sys_probe_lead = (current_stepper == ST_I2S_STREAM) ? i2s_out_get_lead_usec() : 0;
+#endif
         sys_rt_exec_state.bit.motionCancel = true;
     }
 }
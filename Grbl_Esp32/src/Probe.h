@@ -38,6 +38,6 @@ void set_probe_direction(bool is_away);
 // Returns probe pin state. Triggered = true. Called by gcode parser and probe state monitor.
 bool probe_get_state();
 
-// Monitors probe pin state and records the system position when detected. Called by the
-// stepper ISR per ISR tick.
+// Monitors probe pin state and records the system position and time when detected. Called by
+// the probe pin interrupt with PROBE_EDGE_LATCH, otherwise by the stepper ISR per ISR tick.
 void probe_state_monitor();
@@ -55,12 +55,21 @@ void settings_restore(uint8_t restore_flag) {
                 }
             }
         }
+        st_read_settings();  // setDefault() does not run the checkers
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Settings reset done");
     }
     if (restore_flag & SettingsRestore::Parameters) {
         for (auto idx = CoordIndex::Begin; idx < CoordIndex::End; ++idx) {
             coords[idx]->setDefault();
         }
+#ifdef LABWARE_SLOTS
+        for (int slot = 0; slot < LABWARE_SLOTS; slot++) {
+            labware[slot]->setDefault();
+        }
+#endif
+#ifdef DECK_MAP_ROWS
+        deck_map->setDefault();
+#endif
     }
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Position offsets reset done");
 }
@@ -220,6 +229,123 @@ Error report_ngc(const char* value, WebUI::AuthenticationLevel auth_level, WebUI
     report_ngc_parameters(out->client());
     return Error::Ok;
 }
+#ifdef LABWARE_SLOTS
+static void report_labware(uint8_t slot, WebUI::ESPResponseStream* out) {
+    const labware_t* lw = labware[slot]->get();
+    grbl_sendf(out->client(),
+               "[%s:%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%.3f,%.3f,%.3f]\r\n",
+               labware[slot]->getName(),
+               lw->origin[X_AXIS],
+               lw->origin[Y_AXIS],
+               lw->origin[Z_AXIS],
+               lw->pitch[X_AXIS],
+               lw->pitch[Y_AXIS],
+               lw->rows,
+               lw->cols,
+               lw->depth,
+               lw->z_safe,
+               lw->well_area);
+}
+// $LW lists the labware slots, $LW=<slot> shows one, and
+// $LW=<slot> <x> <y> <z> <pitch x> <pitch y> <rows> <cols> <depth> <z safe> [<well area>] sets it.
+// x, y and z are the machine position of the top of well A1.
+Error labware_table(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (value == NULL) {
+        for (uint8_t slot = 0; slot < LABWARE_SLOTS; slot++) {
+            report_labware(slot, out);
+        }
+        return Error::Ok;
+    }
+    char* s;
+    long  slot = strtol(value, &s, 10);
+    if (s == value || slot < 0 || slot >= LABWARE_SLOTS) {
+        return Error::InvalidValue;
+    }
+    while (*s == ' ' || *s == ',') {
+        s++;
+    }
+    if (*s == '\0') {
+        report_labware(slot, out);
+        return Error::Ok;
+    }
+    labware_t lw;
+    Error     err = labware_parse(s, &lw);
+    if (err != Error::Ok) {
+        return err;
+    }
+    labware[slot]->set(&lw);
+    return Error::Ok;
+}
+// $LW/Bench times the well visit ordering on 96- and 384-well plates.
+Error well_order_bench(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    well_order_benchmark(out->client());
+    return Error::Ok;
+}
+#endif
+#ifdef DECK_MAP_ROWS
+// $DM lists the deck map, $DM=O <x> <y> <cell> places its grid, and $DM=<row> <h0> <h1> ... sets
+// the obstacle heights of a row, one machine Z per column.
+Error deck_map_table(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    const deck_map_t* map = deck_map->get();
+    if (value == NULL) {
+        grbl_sendf(out->client(), "[DM:%.3f,%.3f,%.3f]\r\n", map->origin[X_AXIS], map->origin[Y_AXIS], map->cell);
+        for (int row = 0; row < DECK_MAP_ROWS; row++) {
+            grbl_sendf(out->client(), "[DM%d:", row);
+            for (int col = 0; col < DECK_MAP_COLS; col++) {
+                grbl_sendf(out->client(), col ? ",%.3f" : "%.3f", map->height[row][col]);
+            }
+            grbl_send(out->client(), "]\r\n");
+        }
+        return Error::Ok;
+    }
+    deck_map_t dm;
+    memcpy(&dm, map, sizeof(dm));
+    char* s;
+    long  row    = -1;
+    int   n_max  = DECK_MAP_COLS;
+    float fields[MAX(DECK_MAP_COLS, 3)];
+    if (toupper(*value) == 'O') {
+        s     = (char*)value + 1;
+        n_max = 3;
+    } else {
+        row = strtol(value, &s, 10);
+        if (s == value || row < 0 || row >= DECK_MAP_ROWS) {
+            return Error::InvalidValue;
+        }
+    }
+    int n_fields = 0;
+    while (n_fields < n_max) {
+        while (*s == ' ' || *s == ',') {
+            s++;
+        }
+        if (*s == '\0') {
+            break;
+        }
+        char* endptr;
+        fields[n_fields] = strtof(s, &endptr);
+        if (endptr == s) {
+            return Error::BadNumberFormat;
+        }
+        s = endptr;
+        n_fields++;
+    }
+    if (n_fields != n_max) {
+        return Error::InvalidValue;
+    }
+    if (row < 0) {
+        if (fields[2] <= 0.0) {
+            return Error::InvalidValue;
+        }
+        dm.origin[X_AXIS] = fields[0];
+        dm.origin[Y_AXIS] = fields[1];
+        dm.cell           = fields[2];
+    } else {
+        memcpy(dm.height[row], fields, sizeof(dm.height[row]));
+    }
+    deck_map->set(&dm);
+    return Error::Ok;
+}
+#endif
 Error home(int cycle) {
     if (homing_enable->get() == false) {
         return Error::SettingDisabled;
@@ -228,7 +354,8 @@ Error home(int cycle) {
         return Error::CheckDoor;  // Block if safety door is ajar.
     }
     sys.state = State::Homing;  // Set system state variable
-#ifdef USE_I2S_STEPS
+    // I2S homes in static mode, except on the ESP32-S3 which has none and homes in stream mode.
+#if defined(USE_I2S_STEPS) && !defined(CONFIG_IDF_TARGET_ESP32S3)
     stepper_id_t save_stepper = current_stepper;
     if (save_stepper == ST_I2S_STREAM) {
         stepper_switch(ST_I2S_STATIC);
@@ -273,6 +400,37 @@ Error home_b(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ES
 Error home_c(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
     return home(bit(C_AXIS));
 }
+// $Shaper/Sweep=<axis> [<start Hz> [<end Hz> [<step Hz>]]], e.g. $Shaper/Sweep=X 10 80
+Error shaper_sweep(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (sys.state != State::Idle) {
+        return sys.state == State::Alarm ? Error::SystemGcLock : Error::IdleError;
+    }
+    if (value == NULL) {
+        return Error::InvalidValue;
+    }
+    auto axisNames = String("XYZABC");
+    int  axis      = axisNames.indexOf(toupper(*value));
+    if (axis < 0 || axis >= number_axis->get()) {
+        return Error::InvalidValue;
+    }
+    float freq[] = { 5.0, 100.0, 1.0 };  // Start, end, step
+    char* s      = (char*)value + 1;
+    for (int i = 0; i < 3; i++) {
+        while (*s == ' ' || *s == ',') {
+            s++;
+        }
+        if (*s == '\0') {
+            break;
+        }
+        char* endptr;
+        freq[i] = strtof(s, &endptr);
+        if (endptr == s || freq[i] <= 0.0) {
+            return Error::BadNumberFormat;
+        }
+        s = endptr;
+    }
+    return mc_resonance_sweep(axis, freq[0], freq[1], freq[2]);
+}
 Error sleep_grbl(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
     sys_rt_exec_state.bit.sleep = true;
     return Error::Ok;
@@ -314,6 +472,81 @@ Error restore_settings(const char* value, WebUI::AuthenticationLevel auth_level,
     return Error::Ok;
 }
 
+// Prints one log2 histogram of st_isr_stats as "upper bound in usec:count" pairs
+static void report_isr_histogram(uint8_t client, const char* name, const uint32_t* hist, float units_per_usec) {
+    char line[256];
+    int  len = snprintf(line, sizeof(line), "[MSG: %s histogram (us):", name);
+    for (int bin = 0; bin < ST_ISR_HIST_BINS && len < (int)sizeof(line); bin++) {
+        if (hist[bin]) {
+            if (bin == ST_ISR_HIST_BINS - 1) {
+                len += snprintf(line + len, sizeof(line) - len, " >=%.2f:%u", (1 << bin) / units_per_usec, hist[bin]);
+            } else {
+                len += snprintf(line + len, sizeof(line) - len, " <%.2f:%u", (2 << bin) / units_per_usec, hist[bin]);
+            }
+        }
+    }
+    grbl_sendf(client, "%s]\r\n", line);
+}
+
+// $CB times moving bytes from the client reader core to the protocol loop, through the client
+// receive buffer and through the locked InputBuffer it replaced.
+Error client_buffer_bench(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    client_buffer_benchmark(out->client());
+    return Error::Ok;
+}
+
+#ifdef ENABLE_USB_CDC
+// $UB measures the native USB link. See UsbClient.h.
+Error usb_bench(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return usb_client_bench(value, out->client());
+}
+#endif
+
+// Reports and clears the stepper timer ISR latency and execution time statistics
+Error report_stepper_jitter(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    st_isr_stats_t stats = st_isr_stats;
+    st_isr_stats_reset();
+
+    float cycles_per_usec = ESP.getCpuFreqMHz();
+    if (current_stepper == ST_I2S_STREAM) {
+        // No timer ISR, so no alarm latency. The render task runs ahead of the DMA and only
+        // falls behind if the output runs dry.
+        grbl_sendf(out->client(), "[MSG: Stepper I2S stream Ticks: %u DMA underruns: %u]\r\n", stats.ticks, st_isr_underruns(stats));
+        if (stats.ticks != 0) {
+            grbl_sendf(out->client(),
+                       "[MSG: Execution (us) Min: %.2f Mean: %.2f Max: %.2f]\r\n",
+                       stats.exec_min / cycles_per_usec,
+                       (float)stats.exec_sum / stats.ticks / cycles_per_usec,
+                       stats.exec_max / cycles_per_usec);
+            report_isr_histogram(out->client(), "Execution", stats.exec_hist, cycles_per_usec);
+        }
+        return Error::Ok;
+    }
+    grbl_sendf(out->client(),
+               "[MSG: Stepper ISR Ticks: %u Busy: %u Late(>%dus): %u IRAM: %s]\r\n",
+               stats.ticks,
+               stats.busy,
+               ST_ISR_LATE_USEC,
+               stats.late,
+               st_isr_in_iram ? "Yes" : "No");
+    if (stats.ticks == 0) {
+        return Error::Ok;
+    }
+    grbl_sendf(out->client(),
+               "[MSG: Latency (us) Min: %.2f Mean: %.2f Max: %.2f]\r\n",
+               (float)stats.latency_min / ticksPerMicrosecond,
+               (float)stats.latency_sum / stats.ticks / ticksPerMicrosecond,
+               (float)stats.latency_max / ticksPerMicrosecond);
+    grbl_sendf(out->client(),
+               "[MSG: Execution (us) Min: %.2f Mean: %.2f Max: %.2f]\r\n",
+               stats.exec_min / cycles_per_usec,
+               (float)stats.exec_sum / stats.ticks / cycles_per_usec,
+               stats.exec_max / cycles_per_usec);
+    report_isr_histogram(out->client(), "Latency", stats.latency_hist, ticksPerMicrosecond);
+    report_isr_histogram(out->client(), "Execution", stats.exec_hist, cycles_per_usec);
+    return Error::Ok;
+}
+
 Error showState(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
     grbl_sendf(out->client(), "State 0x%x\r\n", sys.state);
     return Error::Ok;
@@ -445,7 +678,19 @@ void make_grbl_commands() {
     new GrblCommand("X", "Alarm/Disable", disable_alarm_lock, anyState);
     new GrblCommand("NVX", "Settings/Erase", Setting::eraseNVS, idleOrAlarm, WA);
     new GrblCommand("V", "Settings/Stats", Setting::report_nvs_stats, idleOrAlarm);
+    new GrblCommand("SJ", "Stepper/Jitter", report_stepper_jitter, anyState);
+    new GrblCommand("CB", "Client/Bench", client_buffer_bench, idleOrAlarm);
+#ifdef ENABLE_USB_CDC
+    new GrblCommand("UB", "USB/Bench", usb_bench, idleOrAlarm);
+#endif
     new GrblCommand("#", "GCode/Offsets", report_ngc, idleOrAlarm);
+#ifdef LABWARE_SLOTS
+    new GrblCommand("LW", "Labware", labware_table, idleOrAlarm);
+    new GrblCommand("LWB", "Labware/Bench", well_order_bench, idleOrAlarm);
+#endif
+#ifdef DECK_MAP_ROWS
+    new GrblCommand("DM", "Deck/Map", deck_map_table, idleOrAlarm);
+#endif
     new GrblCommand("H", "Home", home_all, idleOrAlarm);
     new GrblCommand("MD", "Motor/Disable", motor_disable, idleOrAlarm);
 
@@ -458,6 +703,7 @@ void make_grbl_commands() {
     new GrblCommand("HC", "Home/C", home_c, idleOrAlarm);
 #endif
     new GrblCommand("SLP", "System/Sleep", sleep_grbl, idleOrAlarm);
+    new GrblCommand("SW", "Shaper/Sweep", shaper_sweep, idleOrAlarm);
     new GrblCommand("I", "Build/Info", get_report_build_info, idleOrAlarm);
     new GrblCommand("N", "GCode/StartupLines", report_startup_lines, idleOrAlarm);
     new GrblCommand("RST", "Settings/Restore", restore_settings, idleOrAlarm, WA);
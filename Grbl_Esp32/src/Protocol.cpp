@@ -33,16 +33,34 @@ static uint8_t char_counter         = 0;
 static uint8_t comment_char_counter = 0;
 
 typedef struct {
-    char buffer[LINE_BUFFER_SIZE];
-    int  len;
-    int  line_number;
+    char      buffer[LINE_BUFFER_SIZE];
+    int       len;
+    int       line_number;
+    bool      pending;  // buffer holds a complete line that waits for room in the planner
+    gc_wait_t wait;     // Room in the motion queues the line waits for, once deferred
 } client_line_t;
 client_line_t client_lines[CLIENT_COUNT];
 
+#ifdef LABWARE_SLOTS
+// Source of the M471 line whose visit set protocol_main_loop() runs. It gets its status after the last well.
+static bool      visit_running = false;
+static uint8_t   visit_client;
+static bool      visit_from_sd;
+static gc_wait_t visit_wait;  // Room the next well waits for, once deferred
+#endif
+
+#ifdef ENABLE_SD_CARD
+// Job line that waits for room in the motion queues
+static char      sd_line[255];
+static gc_wait_t sd_wait;
+#endif
+
 static void empty_line(uint8_t client) {
     client_line_t* cl = &client_lines[client];
     cl->len           = 0;
     cl->buffer[0]     = '\0';
+    cl->pending       = false;
+    cl->wait          = {};
 }
 static void empty_lines() {
     for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
@@ -74,7 +92,7 @@ Error add_char_to_line(char c, uint8_t client) {
     return Error::Ok;
 }
 
-Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level) {
+Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level, gc_wait_t* wait) {
     Error result = Error::Ok;
     // Empty or comment line. For syncing purposes.
     if (line[0] == 0) {
@@ -88,7 +106,7 @@ Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_l
     if (sys.state == State::Alarm || sys.state == State::Jog) {
         return Error::SystemGcLock;
     }
-    return gc_execute_line(line, client);
+    return gc_execute_line(line, client, wait);
 }
 
 bool can_park() {
@@ -99,12 +117,119 @@ bool can_park() {
         homing_enable->get() && !spindle->inLaserMode();
 }
 
+// Reads the client until its line buffer holds a complete line, or until its input runs out.
+// Returns true if the line is complete. It stays pending until empty_line().
+static bool protocol_read_line(uint8_t client) {
+    client_line_t* cl = &client_lines[client];
+    int            c;
+    while (!cl->pending && (c = client_read(client)) != -1) {
+        switch (add_char_to_line(c, client)) {
+            case Error::Eol:
+                cl->pending = true;
+                break;
+            case Error::Overflow:
+                report_status_message(Error::Overflow, client);
+                empty_line(client);
+                break;
+            default:
+                break;
+        }
+    }
+    return cl->pending;
+}
+
+// True if a g-code line has to wait, because the planner has no room for its motion or because
+// the wells of a visit set still run, which no other g-code line may come between.
+static bool protocol_gcode_must_wait() {
+#ifdef LABWARE_SLOTS
+    if (gc_visits_pending()) {
+        return true;
+    }
+#endif
+    return plan_check_full_buffer();
+}
+
+// True if the line is motion that the motion queues have no room for. Running it now would block
+// the main loop inside mc_line() or a buffer sync until they have, with every other client stuck
+// behind it. G-code finds out the room it needs when it runs, and is deferred then; see
+// gc_execute_line(). Until that room is there, the line is not run again. System commands run at
+// once, except jogs, which are motion too.
+static bool protocol_line_must_wait(const client_line_t* cl) {
+    const char* line = cl->buffer;
+    if (line[0] == '\0' || line[0] == '[') {
+        return false;
+    }
+    if (line[0] == '$' && !(toupper(line[1]) == 'J' && line[2] == '=')) {
+        return false;
+    }
+    return protocol_gcode_must_wait() || (cl->wait.deferred && !protocol_wait_over(&cl->wait));
+}
+
+// Reports the status of a line that ran, and empties the line buffer of a client line. An M471
+// that started a visit set gets its status from protocol_visit_next(), after the last well.
+static void protocol_line_done(Error status, uint8_t client, bool from_sd) {
+#ifdef LABWARE_SLOTS
+    if (status == Error::Ok && gc_visits_pending() && !visit_running) {
+        visit_running = true;
+        visit_client  = client;
+        visit_from_sd = from_sd;
+        return;
+    }
+#endif
+    report_status_message(status, client);
+    if (!from_sd) {
+        empty_line(client);
+    }
+}
+
+#ifdef LABWARE_SLOTS
+// Runs the next well of a visit set, like a job line, if the motion queues have room for it.
+// Returns true if a well ran, and sets waiting if one waits for room. The set stops at the first
+// well that fails, and the M471 gets its status. A set started outside this loop, by a startup
+// line or a macro, had its status at once, so only a failing well of it is reported, to every client.
+static bool protocol_visit_next(bool* waiting) {
+    if (!gc_visits_pending()) {
+        return false;
+    }
+    if (plan_check_full_buffer() || (visit_wait.deferred && !protocol_wait_over(&visit_wait))) {
+        *waiting = true;
+        return false;
+    }
+    uint8_t client = visit_running ? visit_client : CLIENT_ALL;
+    Error   status = gc_visit_next(client, &visit_wait);
+    if (status == Error::LineDeferred) {
+        *waiting = true;
+        return false;
+    }
+    visit_wait = {};
+    if (status != Error::Ok) {
+        gc_visits_clear();
+    }
+    if (!gc_visits_pending()) {
+        if (visit_running) {
+            visit_running = false;
+            protocol_line_done(status, visit_client, visit_from_sd);
+        } else if (status != Error::Ok) {
+            report_status_message(status, CLIENT_ALL);
+        }
+    }
+    return true;
+}
+#endif
+
 /*
   GRBL PRIMARY LOOP:
 */
 void protocol_main_loop() {
     client_reset_read_buffer(CLIENT_ALL);
     empty_lines();
+#ifdef LABWARE_SLOTS
+    visit_running = false;
+    visit_wait    = {};
+#endif
+#ifdef ENABLE_SD_CARD
+    sd_wait = {};
+#endif
     //uint8_t client = CLIENT_SERIAL; // default client
     // Perform some machine checks to make sure everything is good to go.
 #ifdef CHECK_LIMITS_AT_INIT
@@ -135,59 +260,79 @@ void protocol_main_loop() {
     // Primary loop! Upon a system abort, this exits back to main() to reset the system.
     // This is also where Grbl idles while waiting for something to do.
     // ---------------------------------------------------------------------------------
-    int c;
     for (;;) {
+        bool executed = false;  // A line was executed in this pass
+        bool waiting  = false;  // A line waits for room in the motion queues
 #ifdef ENABLE_SD_CARD
-        if (SD_ready_next) {
-            char fileLine[255];
-            if (readFileLine(fileLine, 255)) {
-                SD_ready_next = false;
-                report_status_message(execute_line(fileLine, SD_client, SD_auth_level), SD_client);
+        // A job line waits while the planner is full, or while the motion queues have not the room
+        // it needs. Nothing else is queued behind it.
+        if (!SD_ready_next) {
+            sd_wait = {};  // A stopped job drops the line it had waiting
+        } else if (protocol_gcode_must_wait() || (sd_wait.deferred && !protocol_wait_over(&sd_wait))) {
+            waiting = true;
+        } else if (sd_wait.deferred || readFileLine(sd_line, sizeof(sd_line))) {
+            Error status = execute_line(sd_line, SD_client, SD_auth_level, &sd_wait);
+            if (status == Error::LineDeferred) {
+                waiting = true;
             } else {
-                char temp[50];
-                sd_get_current_filename(temp);
-                grbl_notifyf("SD print done", "%s print is successful", temp);
-                closeFile();  // close file and clear SD ready/running flags
+                SD_ready_next = false;
+                sd_wait       = {};
+                protocol_line_done(status, SD_client, true);
+                executed = true;
             }
+        } else {
+            char temp[50];
+            sd_get_current_filename(temp);
+            grbl_notifyf("SD print done", "%s print is successful", temp);
+            closeFile();  // close file and clear SD ready/running flags
         }
 #endif
         // Receive one line of incoming serial data, as the data becomes available.
         // Filtering, if necessary, is done later in gc_execute_line(), so the
         // filtering is the same with serial and file input.
-        uint8_t client = CLIENT_SERIAL;
-        char*   line;
-        for (client = 0; client < CLIENT_COUNT; client++) {
-            while ((c = client_read(client)) != -1) {
-                Error res = add_char_to_line(c, client);
-                switch (res) {
-                    case Error::Ok:
-                        break;
-                    case Error::Eol:
-                        protocol_execute_realtime();  // Runtime command check point.
-                        if (sys.abort) {
-                            return;  // Bail to calling function upon system abort
-                        }
-                        line = client_lines[client].buffer;
+        // Each client gets at most one line per pass, so a client streaming a job does not
+        // keep the others waiting. A line that would have to wait for room in the planner
+        // stays pending in its client's line buffer, and the client is not read further
+        // until the line has run, which keeps its lines in order.
+        for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+            client_line_t* cl = &client_lines[client];
+            if (!protocol_read_line(client)) {
+                continue;
+            }
+            if (protocol_line_must_wait(cl)) {
+                waiting = true;
+                continue;
+            }
+            protocol_execute_realtime();  // Runtime command check point.
+            if (sys.abort) {
+                return;  // Bail to calling function upon system abort
+            }
 #ifdef REPORT_ECHO_RAW_LINE_RECEIVED
-                        report_echo_line_received(line, client);
+            if (!cl->wait.deferred) {
+                report_echo_line_received(cl->buffer, client);
+            }
 #endif
-                        // auth_level can be upgraded by supplying a password on the command line
-                        report_status_message(execute_line(line, client, WebUI::AuthenticationLevel::LEVEL_GUEST), client);
-                        empty_line(client);
-                        break;
-                    case Error::Overflow:
-                        report_status_message(Error::Overflow, client);
-                        empty_line(client);
-                        break;
-                    default:
-                        break;
-                }
-            }  // while serial read
-        }      // for clients
-        // If there are no more characters in the serial read buffer to be processed and executed,
-        // this indicates that g-code streaming has either filled the planner buffer or has
-        // completed. In either case, auto-cycle start, if enabled, any queued moves.
-        protocol_auto_cycle_start();
+            // auth_level can be upgraded by supplying a password on the command line
+            Error status = execute_line(cl->buffer, client, WebUI::AuthenticationLevel::LEVEL_GUEST, &cl->wait);
+            if (status == Error::LineDeferred) {
+                waiting = true;
+                continue;
+            }
+            protocol_line_done(status, client, false);
+            executed = true;
+        }  // for clients
+#ifdef LABWARE_SLOTS
+        // An M471 visits one well per pass, so the other clients are served between the wells.
+        if (protocol_visit_next(&waiting)) {
+            executed = true;
+        }
+#endif
+        // If no line ran in this pass, g-code streaming has either filled the planner buffer
+        // or has completed. In either case, auto-cycle start, if enabled, any queued moves. So
+        // does a line that waits for the motion queues to make room for it.
+        if (!executed || waiting || plan_check_full_buffer()) {
+            protocol_auto_cycle_start();
+        }
         protocol_execute_realtime();  // Runtime command check point.
         if (sys.abort) {
             return;  // Bail to main() program loop to reset system.
@@ -202,6 +347,30 @@ void protocol_main_loop() {
     return; /* Never reached */
 }
 
+// True if there is queued motion to execute, in the planner or the async axis queue.
+static bool protocol_motion_queued() {
+#ifdef ASYNC_AXIS
+    if (async_busy()) {
+        return true;
+    }
+#endif
+    return plan_get_current_block() != NULL;
+}
+
+bool protocol_wait_over(const gc_wait_t* wait) {
+    if (wait->drain && (protocol_motion_queued() || sys.state == State::Cycle)) {
+        return false;
+    }
+#ifdef ASYNC_AXIS
+    if ((wait->async_room && !async_ready()) || (wait->async_idle && async_busy())) {
+        return false;
+    }
+#endif
+    // A line that needs more blocks than the planner holds waits for an empty planner, and then
+    // for the rest of its blocks in mc_line().
+    return plan_get_block_buffer_available() >= MIN(wait->planner_blocks, plan_get_block_buffer_size() - 1);
+}
+
 // Block until all buffered steps are executed or in a cycle state. Works with feed hold
 // during a synchronize call, if it should happen. Also, waits for clean cycle end.
 void protocol_buffer_synchronize() {
@@ -212,17 +381,18 @@ void protocol_buffer_synchronize() {
         if (sys.abort) {
             return;  // Check for system abort
         }
-    } while (plan_get_current_block() || (sys.state == State::Cycle));
+    } while (protocol_motion_queued() || (sys.state == State::Cycle));
 }
 
 // Auto-cycle start triggers when there is a motion ready to execute and if the main program is not
 // actively parsing commands.
 // NOTE: This function is called from the main loop, buffer sync, and mc_line() only and executes
 // when one of these conditions exist respectively: There are no more blocks sent (i.e. streaming
-// is finished, single commands), a command that needs to wait for the motions in the buffer to
-// execute calls a buffer sync, or the planner buffer is full and ready to go.
+// is finished, single commands) or a line waits for room in the planner, a command that needs to
+// wait for the motions in the buffer to execute calls a buffer sync, or the planner buffer is full
+// and ready to go.
 void protocol_auto_cycle_start() {
-    if (plan_get_current_block() != NULL) {       // Check if there are any blocks in the buffer.
+    if (protocol_motion_queued()) {               // Check if there is any motion queued.
         sys_rt_exec_state.bit.cycleStart = true;  // If so, execute them!
     }
 }
@@ -291,9 +461,11 @@ void protocol_exec_rt_system() {
                 // If in CYCLE or JOG states, immediately initiate a motion HOLD.
                 if (sys.state == State::Cycle || sys.state == State::Jog) {
                     if (!(sys.suspend.bit.motionCancel || sys.suspend.bit.jogCancel)) {  // Block, if already holding.
+                        st_prep_lock();                     // The prep task must see the recompute and the hold together.
                         st_update_plan_block_parameters();  // Notify stepper module to recompute for hold deceleration.
                         sys.step_control             = {};
                         sys.step_control.executeHold = true;  // Initiate suspend state with active flag.
+                        st_prep_unlock();
                         if (sys.state == State::Jog) {        // Jog cancelled upon any hold event, except for sleeping.
                             if (!rt_exec_state.bit.sleep) {
                                 sys.suspend.bit.jogCancel = true;
@@ -339,11 +511,13 @@ void protocol_exec_rt_system() {
 #ifdef PARKING_ENABLE
                                 // Set hold and reset appropriate control flags to restart parking sequence.
                                 if (sys.step_control.executeSysMotion) {
+                                    st_prep_lock();
                                     st_update_plan_block_parameters();  // Notify stepper module to recompute for hold deceleration.
                                     sys.step_control                  = {};
                                     sys.step_control.executeHold      = true;
                                     sys.step_control.executeSysMotion = true;
                                     sys.suspend.bit.holdComplete      = false;
+                                    st_prep_unlock();
                                 }  // else NO_MOTION is active.
 #endif
                                 sys.suspend.bit.retractComplete = false;
@@ -396,11 +570,17 @@ void protocol_exec_rt_system() {
                     } else {
                         // Start cycle only if queued motions exist in planner buffer and the motion is not canceled.
                         sys.step_control = {};  // Restore step control to normal operation
-                        if (plan_get_current_block() && !sys.suspend.bit.motionCancel) {
+                        if (protocol_motion_queued() && !sys.suspend.bit.motionCancel) {
                             sys.suspend.value = 0;  // Break suspend state.
                             sys.state         = State::Cycle;
                             st_prep_buffer();  // Initialize step segment buffer before beginning cycle.
                             st_wake_up();
+#ifdef PROBE_EDGE_LATCH
+                            // The probe latch ignores edges outside a cycle. Catch a trigger that came during the hold.
+                            if (sys_probe_state == Probe::Active) {
+                                probe_state_monitor();
+                            }
+#endif
                         } else {                    // Otherwise, do nothing. Set and resume IDLE state.
                             sys.suspend.value = 0;  // Break suspend state.
                             sys.state         = State::Idle;
@@ -416,6 +596,7 @@ void protocol_exec_rt_system() {
             // NOTE: Bresenham algorithm variables are still maintained through both the planner and stepper
             // cycle reinitializations. The stepper path should continue exactly as if nothing has happened.
             // NOTE: cycle_stop is set by the stepper subsystem when a cycle or feed hold completes.
+            st_prep_lock();
             if ((sys.state == State::Hold || sys.state == State::SafetyDoor || sys.state == State::Sleep) && !(sys.soft_limit) &&
                 !(sys.suspend.bit.jogCancel)) {
                 // Hold complete. Set to indicate ready to resume.  Remain in HOLD or DOOR states until user
@@ -446,6 +627,7 @@ void protocol_exec_rt_system() {
                 }
             }
             cycle_stop = false;
+            st_prep_unlock();
         }
     }
     // Execute overrides.
@@ -453,8 +635,10 @@ void protocol_exec_rt_system() {
         sys.f_override         = sys_rt_f_override;
         sys.r_override         = sys_rt_r_override;
         sys.report_ovr_counter = 0;  // Set to report change immediately
+        st_prep_lock();
         plan_update_velocity_profile_parameters();
         plan_cycle_reinitialize();
+        st_prep_unlock();
     }
 
     // NOTE: Unlike motion overrides, spindle overrides do not require a planner reinitialization.
@@ -48,5 +48,12 @@ void protocol_auto_cycle_start();
 // Block until all buffered steps are executed
 void protocol_buffer_synchronize();
 
+// True if the motion queues have the room a deferred g-code line waits for. See gc_execute_line().
+bool protocol_wait_over(const gc_wait_t* wait);
+
+// Executes a line of a client, a system command or g-code. With wait, g-code may be deferred as
+// gc_execute_line() does.
+Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level, gc_wait_t* wait = NULL);
+
 // Executes the auto cycle feature, if enabled.
 void protocol_auto_cycle_start();
@@ -343,7 +343,7 @@ void report_ngc_parameters(uint8_t client) {
 // Print current gcode parser mode state
 void report_gcode_modes(uint8_t client) {
     char        temp[20];
-    char        modes_rpt[75];
+    char        modes_rpt[128];
     const char* mode = "";
     strcpy(modes_rpt, "[GC:");
 
@@ -487,6 +487,29 @@ void report_gcode_modes(uint8_t client) {
     }
 #endif
 
+#ifdef SYRINGE_AXIS
+    if (gc_state.modal.z_follow == ZFollow::Enable) {
+        snprintf(temp, sizeof(temp), " M440 Q%.1f", gc_state.z_follow_area);
+        strcat(modes_rpt, temp);
+    }
+    if (gc_state.modal.dispense == Dispense::Enable) {
+        snprintf(temp, sizeof(temp), " M450 Q%.1f", gc_state.dispense_volume);
+        strcat(modes_rpt, temp);
+    }
+#endif
+#ifdef LABWARE_SLOTS
+    sprintf(temp, " M460 P%d", gc_state.labware);
+    strcat(modes_rpt, temp);
+    if (gc_state.modal.visits == VisitSet::Collect) {
+        strcat(modes_rpt, " M470");
+    }
+#endif
+#ifdef DECK_MAP_ROWS
+    if (gc_state.modal.deck_travel == DeckTravel::Enable) {
+        strcat(modes_rpt, " M480");
+    }
+#endif
+
     sprintf(temp, " T%d", gc_state.tool);
     strcat(modes_rpt, temp);
     sprintf(temp, report_inches->get() ? " F%.1f" : " F%.0f", gc_state.feed_rate);
@@ -554,6 +577,8 @@ void report_build_info(const char* line, uint8_t client) {
 #endif
     // NOTE: Compiled values, like override increments/max/min values, may be added at some point later.
     // These will likely have a comma delimiter to separate them.
+    // Planner blocks and the receive buffer size of this client, for character-counting senders
+    grbl_sendf(client, ",%d,%d", plan_get_block_buffer_size() - 1, client < CLIENT_COUNT ? client_get_rx_buffer_size(client) : 0);
     grbl_send(client, "]\r\n");
     report_machine_type(client);
 #if defined(ENABLE_WIFI)
@@ -601,19 +626,8 @@ void report_realtime_status(uint8_t client) {
 #ifdef REPORT_FIELD_BUFFER_STATE
     if (bit_istrue(status_mask->get(), RtStatus::Buffer)) {
         int bufsize = DEFAULTBUFFERSIZE;
-#    if defined(ENABLE_WIFI) && defined(ENABLE_TELNET)
-        if (client == CLIENT_TELNET) {
-            bufsize = WebUI::telnet_server.get_rx_buffer_available();
-        }
-#    endif  //ENABLE_WIFI && ENABLE_TELNET
-#    if defined(ENABLE_BLUETOOTH)
-        if (client == CLIENT_BT) {
-            //TODO FIXME
-            bufsize = 512 - WebUI::SerialBT.available();
-        }
-#    endif  //ENABLE_BLUETOOTH
-        if (client == CLIENT_SERIAL) {
-            bufsize = client_get_rx_buffer_available(CLIENT_SERIAL);
+        if (client < CLIENT_COUNT) {
+            bufsize = client_get_rx_buffer_available(client);
         }
         sprintf(temp, "|Bf:%d,%d", plan_get_block_buffer_available(), bufsize);
         strcat(status, temp);
@@ -784,10 +798,12 @@ void report_realtime_status(uint8_t client) {
 }
 
 void report_realtime_steps() {
+    int32_t steps[MAX_N_AXIS];
+    st_get_realtime_position(steps);
     uint8_t idx;
     auto    n_axis = number_axis->get();
     for (idx = 0; idx < n_axis; idx++) {
-        grbl_sendf(CLIENT_ALL, "%ld\n", sys_position[idx]);  // OK to send to all ... debug stuff
+        grbl_sendf(CLIENT_ALL, "%ld\n", steps[idx]);  // OK to send to all ... debug stuff
     }
 }
 
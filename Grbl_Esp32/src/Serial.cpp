@@ -50,7 +50,9 @@
   read all clients as fast as possible. The realtime commands are acted upon and the other charcters are
   placed into a client_buffer[client].
 
-  The main protocol loop reads from client_buffer[]
+  The main protocol loop reads from client_buffer[]. Each buffer has this task as its only
+  writer and the protocol loop as its only reader, so the two never lock each other out
+  (see ClientBuffer.h).
 
 
 */
@@ -63,21 +65,16 @@
 // testing is complete.
 #define REVERT_TO_ARDUINO_SERIAL
 
-portMUX_TYPE myMutex = portMUX_INITIALIZER_UNLOCKED;
+#if defined(REVERT_TO_ARDUINO_SERIAL) && !(defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2)
+#    define CLIENT_SERIAL_POLLED  // Arduino cores before 2.0 have no receive callback
+#endif
+
+// How long the client reader task sleeps when no source needs polling (ticks)
+const TickType_t CLIENT_RX_IDLE_TICKS = 10 / portTICK_RATE_MS;
 
 static TaskHandle_t clientCheckTaskHandle = 0;
 
-WebUI::InputBuffer client_buffer[CLIENT_COUNT];  // create a buffer for each client
-
-// Returns the number of bytes available in a client buffer.
-uint8_t client_get_rx_buffer_available(uint8_t client) {
-#ifdef REVERT_TO_ARDUINO_SERIAL
-    return 128 - Serial.available();
-#else
-    return 128 - Uart0.available();
-#endif
-    //    return client_buffer[client].availableforwrite();
-}
+ClientBuffer client_buffer[CLIENT_COUNT];  // create a buffer for each client
 
 void heapCheckTask(void* pvParameters) {
     static uint32_t heapSize = 0;
@@ -106,13 +103,35 @@ void client_init() {
     Serial.begin(BAUD_RATE, SERIAL_8N1, 44, 43, false);  // RX=GPIO44, TX=GPIO43 for CH340 bridge
     client_reset_read_buffer(CLIENT_ALL);
     Serial.write("\r\n");  // create some white space after ESP32 boot info
+#    ifndef CLIENT_SERIAL_POLLED
+    Serial.onReceive(client_rx_notify);
+#    endif
 #else
     Uart0.setPins(43, 44);  // Tx 43, Rx 44 - CH340 USB-to-UART bridge pins
     Uart0.begin(BAUD_RATE, Uart::Data::Bits8, Uart::Stop::Bits1, Uart::Parity::None);
+    Uart0.onReceive(client_rx_notify);
 
     client_reset_read_buffer(CLIENT_ALL);
     Uart0.write("\r\n");  // create some white space after ESP32 boot info
 #endif
+#ifdef ENABLE_USB_CDC
+    usb_client_init();
+#endif
+}
+
+// Allocates the client receive buffers, sized by $Client/RxBuffer, and starts reading the clients.
+// Falls back to the compiled in RX_BUFFER_SIZE if there is not enough memory.
+void client_rx_init() {
+    uint32_t size = client_rx_buffer_size->get();
+    for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+        if (!client_buffer[client].begin(size)) {
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot allocate %d byte client buffers", size);
+            size = RX_BUFFER_SIZE;
+            client_buffer[client].begin(size);
+        }
+    }
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Client buffers %d bytes", client_buffer[CLIENT_COUNT - 1].capacity());
+
     clientCheckTaskHandle = 0;
     // create a task to check for incoming data
     // For a 4096-word stack, uxTaskGetStackHighWaterMark reports 244 words available
@@ -128,72 +147,176 @@ void client_init() {
     );
 }
 
-static uint8_t getClientChar(uint8_t* data) {
-    int res;
+// Bytes moved from a source in one read. Each source gets one chunk per turn, so a busy stream
+// cannot hold up the others for long.
+const size_t CLIENT_CHUNK = 64;
+
+// Ordinary bytes read while the client buffer had no room for them, in arrival order. Reading goes
+// on while the buffer is full, so the realtime commands behind them still act at once. Reading
+// only stops once this is full too, which a sender that keeps to client_get_rx_buffer_available()
+// never gets to. Only the reader task touches them.
+static uint8_t           client_held[CLIENT_COUNT][CLIENT_CHUNK];
+static size_t            client_held_len[CLIENT_COUNT];
+static std::atomic<bool> client_held_drop[CLIENT_COUNT];  // Set by client_reset_read_buffer()
+
+// Moves up to len bytes that a client has sent into data. Returns the number of bytes moved.
+static size_t client_source_read(uint8_t client, uint8_t* data, size_t len) {
+    size_t n = 0;
+    int    res;
+    switch (client) {
+        case CLIENT_SERIAL:
 #ifdef REVERT_TO_ARDUINO_SERIAL
-    if (client_buffer[CLIENT_SERIAL].availableforwrite() && (res = Serial.read()) != -1) {
+            n = MIN(len, size_t(Serial.available()));
+            return n ? Serial.readBytes(data, n) : 0;
 #else
-    if (client_buffer[CLIENT_SERIAL].availableforwrite() && (res = Uart0.read()) != -1) {
+            n = MIN(len, size_t(Uart0.available()));
+            return n ? Uart0.readBytes(data, n, 0) : 0;
 #endif
-        *data = res;
-        return CLIENT_SERIAL;
-    }
-    if (WebUI::inputBuffer.available()) {
-        *data = WebUI::inputBuffer.read();
-        return CLIENT_INPUT;
-    }
-    //currently is wifi or BT but better to prepare both can be live
 #ifdef ENABLE_BLUETOOTH
-    if (WebUI::SerialBT.hasClient()) {
-        if ((res = WebUI::SerialBT.read()) != -1) {
-            *data = res;
-            return CLIENT_BT;
-        }
-    }
+        case CLIENT_BT:
+            //currently is wifi or BT but better to prepare both can be live
+            if (WebUI::SerialBT.hasClient()) {
+                n = MIN(len, size_t(WebUI::SerialBT.available()));
+                return n ? WebUI::SerialBT.readBytes(data, n) : 0;
+            }
+            return 0;
 #endif
 #if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
-    if (WebUI::Serial2Socket.available()) {
-        *data = WebUI::Serial2Socket.read();
-        return CLIENT_WEBUI;
+        case CLIENT_WEBUI:
+            while (n < len && (res = WebUI::Serial2Socket.read()) != -1) {
+                data[n++] = res;
+            }
+            return n;
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_TELNET)
+        case CLIENT_TELNET:
+            while (n < len && (res = WebUI::telnet_server.read()) != -1) {
+                data[n++] = res;
+            }
+            return n;
+#endif
+#ifdef ENABLE_USB_CDC
+        case CLIENT_USB:
+            return usb_client_read(data, len);
+#endif
+        case CLIENT_INPUT:
+            while (n < len && (res = WebUI::inputBuffer.read()) != -1) {
+                data[n++] = res;
+            }
+            return n;
+        default:
+            return 0;
     }
+}
+
+// Bytes a client has sent that the reader task has not moved into its buffer yet.
+static size_t client_source_available(uint8_t client) {
+    switch (client) {
+        case CLIENT_SERIAL:
+#ifdef REVERT_TO_ARDUINO_SERIAL
+            return Serial.available();
+#else
+            return Uart0.available();
+#endif
+#ifdef ENABLE_BLUETOOTH
+        case CLIENT_BT:
+            return WebUI::SerialBT.hasClient() ? WebUI::SerialBT.available() : 0;
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
+        case CLIENT_WEBUI:
+            return WebUI::Serial2Socket.available();
 #endif
 #if defined(ENABLE_WIFI) && defined(ENABLE_TELNET)
-    if (WebUI::telnet_server.available()) {
-        *data = WebUI::telnet_server.read();
-        return CLIENT_TELNET;
+        case CLIENT_TELNET:
+            return WebUI::telnet_server.available();
+#endif
+#ifdef ENABLE_USB_CDC
+        case CLIENT_USB:
+            return usb_client_available();
+#endif
+        case CLIENT_INPUT:
+            return WebUI::inputBuffer.available();
+        default:
+            return 0;
     }
+}
+
+// The free room of a client buffer, less what is on its way into it. A character-counting
+// sender that never sends more than this cannot overrun any buffer on the way.
+int client_get_rx_buffer_available(uint8_t client) {
+    int available = int(client_buffer[client].availableForWrite()) - int(client_held_len[client]) - int(client_source_available(client));
+    return MAX(available, 0);
+}
+
+uint32_t client_get_rx_buffer_size(uint8_t client) {
+    return client_buffer[client].capacity();
+}
+
+// Moves the held back bytes of a client into its buffer, as far as there is room.
+static void client_release(uint8_t client) {
+    size_t held = client_held_len[client];
+    size_t n    = client_buffer[client].write(client_held[client], held);
+    memmove(client_held[client], client_held[client] + n, held - n);
+    client_held_len[client] = held - n;
+}
+
+// Acts on the realtime characters in data and queues the rest for the protocol loop, behind the
+// bytes held back before. What does not fit in the client buffer is held back.
+static void client_accept(uint8_t client, uint8_t* data, size_t len) {
+    size_t kept = 0;
+    for (size_t i = 0; i < len; i++) {
+        // Pick off realtime command characters directly from the serial stream. These characters are
+        // not passed into the main buffer, but these set system state flag bits for realtime execution.
+        if (is_realtime_command(data[i])) {
+            execute_realtime_command(static_cast<Cmd>(data[i]), client);
+        } else {
+#if defined(ENABLE_SD_CARD)
+            if (get_sd_state(false) < SDState::Busy) {
+#endif  //ENABLE_SD_CARD
+                data[kept++] = data[i];
+#if defined(ENABLE_SD_CARD)
+            } else {
+                if (data[i] == '\r' || data[i] == '\n') {
+                    grbl_sendf(client, "error %d\r\n", Error::AnotherInterfaceBusy);
+                    grbl_msg_sendf(client, MsgLevel::Info, "SD card job running");
+                }
+            }
+#endif  //ENABLE_SD_CARD
+        }
+    }
+    memcpy(client_held[client] + client_held_len[client], data, kept);  // Reads never take more than the free hold room
+    client_held_len[client] += kept;
+    client_release(client);
+}
+
+// True while a source cannot notify the reader task, so the task has to look at it every tick.
+static bool client_rx_polled() {
+#ifdef CLIENT_SERIAL_POLLED
+    return true;
+#elif defined(ENABLE_WIFI)
+    return WebUI::wifi_config.Is_WiFi_on();  // Telnet and the web server are serviced from the task
+#else
+    return false;
 #endif
-    return CLIENT_ALL;
+}
+
+void client_rx_notify() {
+    if (clientCheckTaskHandle) {
+        xTaskNotifyGive(clientCheckTaskHandle);
+    }
 }
 
 // this task runs and checks for data on all interfaces
 // REaltime stuff is acted upon, then characters are added to the appropriate buffer
+//
+// The task sleeps until a source notifies it through client_rx_notify(), so a command is picked
+// up as soon as its bytes arrive. Sources without a receive event, and buffers the protocol loop
+// has not made room in yet, are looked at again on the next tick.
 void clientCheckTask(void* pvParameters) {
-    uint8_t            data = 0;
-    uint8_t            client;  // who sent the data
+    uint8_t            data[CLIENT_CHUNK];
     static UBaseType_t uxHighWaterMark = 0;
     while (true) {  // run continuously
-        while ((client = getClientChar(&data)) != CLIENT_ALL) {
-            // Pick off realtime command characters directly from the serial stream. These characters are
-            // not passed into the main buffer, but these set system state flag bits for realtime execution.
-            if (is_realtime_command(data)) {
-                execute_realtime_command(static_cast<Cmd>(data), client);
-            } else {
-#if defined(ENABLE_SD_CARD)
-                if (get_sd_state(false) < SDState::Busy) {
-#endif  //ENABLE_SD_CARD                vPortEnterCritical(&myMutex);
-                client_buffer[client].write(data);
-                vPortExitCritical(&myMutex);
-#if defined(ENABLE_SD_CARD)
-                } else {
-                    if (data == '\r' || data == '\n') {
-                        grbl_sendf(client, "error %d\r\n", Error::AnotherInterfaceBusy);
-                        grbl_msg_sendf(client, MsgLevel::Info, "SD card job running");
-                    }
-                }
-#endif  //ENABLE_SD_CARD
-            }
-        }  // if something available
+        // Service the network first, so what telnet and the web server take in moves on at once.
         WebUI::COMMANDS::handle();
 #ifdef ENABLE_WIFI
         WebUI::wifi_config.handle();
@@ -204,7 +327,30 @@ void clientCheckTask(void* pvParameters) {
 #if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
         WebUI::Serial2Socket.handle_flush();
 #endif
-        vTaskDelay(1 / portTICK_RATE_MS);  // Yield to other tasks
+        bool moved;
+        bool full = false;
+        do {
+            moved = false;
+            for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+                if (client_held_drop[client].exchange(false)) {
+                    client_held_len[client] = 0;
+                }
+                client_release(client);
+                if (client_held_len[client]) {
+                    full = true;  // Release the rest once the protocol loop has made room
+                }
+                size_t room = CLIENT_CHUNK - client_held_len[client];
+                if (room == 0) {
+                    continue;
+                }
+                size_t n = client_source_read(client, data, room);
+                if (n) {
+                    client_accept(client, data, n);
+                    moved = true;
+                }
+            }
+        } while (moved);
+        ulTaskNotifyTake(pdTRUE, (full || client_rx_polled()) ? 1 : CLIENT_RX_IDLE_TICKS);  // Yield to other tasks
 
         static UBaseType_t uxHighWaterMark = 0;
 #ifdef DEBUG_TASK_STACK
@@ -216,17 +362,15 @@ void clientCheckTask(void* pvParameters) {
 void client_reset_read_buffer(uint8_t client) {
     for (uint8_t client_num = 0; client_num < CLIENT_COUNT; client_num++) {
         if (client == client_num || client == CLIENT_ALL) {
-            client_buffer[client_num].begin();
+            client_held_drop[client_num] = true;
+            client_buffer[client_num].clear();
         }
     }
 }
 
 // Fetches the first byte in the client read buffer. Called by protocol loop.
 int client_read(uint8_t client) {
-    vPortEnterCritical(&myMutex);
-    int data = client_buffer[client].read();
-    vPortExitCritical(&myMutex);
-    return data;
+    return client_buffer[client].read();
 }
 
 // checks to see if a character is a realtime character
@@ -364,6 +508,11 @@ void client_write(uint8_t client, const char* text) {
     if (client == CLIENT_TELNET || client == CLIENT_ALL) {
         WebUI::telnet_server.write((const uint8_t*)text, strlen(text));
     }
+#endif
+#ifdef ENABLE_USB_CDC
+    if (client == CLIENT_USB || client == CLIENT_ALL) {
+        usb_client_write(text);
+    }
 #endif
     if (client == CLIENT_SERIAL || client == CLIENT_ALL) {
 #ifdef REVERT_TO_ARDUINO_SERIAL
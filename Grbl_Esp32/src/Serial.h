@@ -22,8 +22,12 @@
 
 #include "stdint.h"
 
+// Size of the receive buffer of each client, the default of $Client/RxBuffer. A power of two.
 #ifndef RX_BUFFER_SIZE
-#    define RX_BUFFER_SIZE 256
+#    define RX_BUFFER_SIZE 4096
+#endif
+#ifndef MAX_RX_BUFFER_SIZE
+#    define MAX_RX_BUFFER_SIZE 32768
 #endif
 #ifndef TX_BUFFER_SIZE
 #    ifdef USE_LINE_NUMBERS
@@ -36,6 +40,9 @@
 // a task to read for incoming data from serial port
 void clientCheckTask(void* pvParameters);
 
+// Wakes the client reader task. Sources call it when they receive data.
+void client_rx_notify();
+
 void client_write(uint8_t client, const char* text);
 
 // Fetches the first byte in the serial read buffer. Called by main program.
@@ -45,10 +52,14 @@ int client_read(uint8_t client);
 uint8_t check_action_command(uint8_t data);
 
 void client_init();
+void client_rx_init();  // After settings_init()
 void client_reset_read_buffer(uint8_t client);
 
-// Returns the number of bytes available in the RX serial buffer.
-uint8_t client_get_rx_buffer_available(uint8_t client);
+// Returns the number of bytes a client can send without overrunning its receive buffer.
+int client_get_rx_buffer_available(uint8_t client);
+
+// Size of the receive buffer of a client, a power of two
+uint32_t client_get_rx_buffer_size(uint8_t client);
 
 void execute_realtime_command(Cmd command, uint8_t client);
 bool is_realtime_command(uint8_t data);
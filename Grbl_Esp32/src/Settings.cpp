@@ -753,3 +753,78 @@ void Coordinates::set(float value[MAX_N_AXIS]) {
 #endif
     nvs_set_blob(Setting::_handle, _name, _currentValue, sizeof(_currentValue));
 }
+
+#ifdef LABWARE_SLOTS
+Labware* labware[LABWARE_SLOTS];
+
+bool Labware::load() {
+    size_t len = sizeof(_currentValue);
+    if (nvs_get_blob(Setting::_handle, _name, &_currentValue, &len) != ESP_OK || len != sizeof(_currentValue)) {
+        return false;
+    }
+    if (_currentValue.rows > LABWARE_MAX_ROWS || _currentValue.cols > LABWARE_MAX_COLS) {
+        return false;
+    }
+    _wells.set(_currentValue);
+    return true;
+}
+
+void Labware::setDefault() {
+    labware_t empty = {};
+    set(&empty);
+}
+
+void Labware::set(labware_t* value) {
+    memcpy(&_currentValue, value, sizeof(_currentValue));
+    _wells.set(_currentValue);
+#    ifdef FORCE_BUFFER_SYNC_DURING_NVS_WRITE
+    protocol_buffer_synchronize();
+#    endif
+    nvs_set_blob(Setting::_handle, _name, &_currentValue, sizeof(_currentValue));
+}
+#endif
+
+#ifdef DECK_MAP_ROWS
+DeckMap* deck_map;
+
+bool DeckMap::load() {
+    size_t len = sizeof(_currentValue);
+    if (nvs_get_blob(Setting::_handle, _name, &_currentValue, &len) != ESP_OK || len != sizeof(_currentValue)) {
+        return false;
+    }
+    precompute();
+    return true;
+}
+
+void DeckMap::setDefault() {
+    deck_map_t empty = {};
+    set(&empty);
+}
+
+void DeckMap::set(deck_map_t* value) {
+    memcpy(&_currentValue, value, sizeof(_currentValue));
+    precompute();
+#    ifdef FORCE_BUFFER_SYNC_DURING_NVS_WRITE
+    protocol_buffer_synchronize();
+#    endif
+    nvs_set_blob(Setting::_handle, _name, &_currentValue, sizeof(_currentValue));
+}
+
+void DeckMap::precompute() {
+    _max_height = _currentValue.height[0][0];
+    for (int row = 0; row < DECK_MAP_ROWS; row++) {
+        for (int col = 0; col < DECK_MAP_COLS; col++) {
+            _max_height = MAX(_max_height, _currentValue.height[row][col]);
+        }
+    }
+}
+
+float DeckMap::height(float x, float y) {
+    int col = floor((x - _currentValue.origin[X_AXIS]) / _currentValue.cell);
+    int row = floor((y - _currentValue.origin[Y_AXIS]) / _currentValue.cell);
+    if (col < 0 || col >= DECK_MAP_COLS || row < 0 || row >= DECK_MAP_ROWS) {
+        return _max_height;
+    }
+    return _currentValue.height[row][col];
+}
+#endif
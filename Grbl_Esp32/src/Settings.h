@@ -4,6 +4,7 @@
 #include <map>
 #include <nvs.h>
 #include "WebUI/ESPResponse.h"
+#include "Labware.h"
 
 // Initialize the configuration subsystem
 void settings_init();
@@ -252,6 +253,69 @@ public:
 
 extern Coordinates* coords[CoordIndex::End];
 
+#ifdef LABWARE_SLOTS
+// Labware definitions are stored like the coordinate systems, one NVS blob per slot.
+class Labware {
+private:
+    labware_t    _currentValue;
+    const char*  _name;
+    LabwareWells _wells;
+
+public:
+    Labware(const char* name) : _name(name) {}
+
+    const char* getName() { return _name; }
+    bool        load();
+    void        setDefault();
+    // Return a pointer to the definition
+    const labware_t* get() { return &_currentValue; }
+    void             set(labware_t* value);
+
+    uint16_t wells() { return _wells.wells(); }
+    // Machine X and Y of a well. Returns false if the plate has no such well.
+    bool wellPosition(int32_t well, float* x, float* y) { return _wells.position(well, x, y); }
+};
+
+extern Labware* labware[LABWARE_SLOTS];
+#endif
+
+#ifdef DECK_MAP_ROWS
+// Obstacle heights over the deck, on a grid of DECK_MAP_ROWS x DECK_MAP_COLS square cells.
+// Rows run along Y and columns along X. Deck travel (M480) lifts Z only as far as the cells
+// under the XY path need.
+typedef struct {
+    float origin[2];                             // Machine X and Y of the low corner of cell (0, 0) (mm)
+    float cell;                                  // Cell size (mm), 0 while the map is unset
+    float height[DECK_MAP_ROWS][DECK_MAP_COLS];  // Machine Z of the top of the highest obstacle in each cell
+} deck_map_t;
+
+// The deck map is stored in one NVS blob, like the labware definitions.
+class DeckMap {
+private:
+    deck_map_t  _currentValue;
+    const char* _name;
+    float       _max_height;  // Highest cell. Everything off the map is taken to be this high.
+
+    void precompute();
+
+public:
+    DeckMap(const char* name) : _name(name) {}
+
+    const char* getName() { return _name; }
+    bool        load();
+    void        setDefault();
+    // Return a pointer to the map
+    const deck_map_t* get() { return &_currentValue; }
+    void              set(deck_map_t* value);
+
+    bool valid() { return _currentValue.cell > 0.0; }
+    // Machine Z of the obstacles at machine X and Y
+    float height(float x, float y);
+};
+
+extern DeckMap* deck_map;
+#endif
+
 class FloatSetting : public Setting {
 private:
     float _defaultValue;
@@ -435,6 +499,10 @@ public:
     FloatSetting* steps_per_mm;
     FloatSetting* max_rate;
     FloatSetting* acceleration;
+    FloatSetting* jerk;
+    EnumSetting*  shaper_type;
+    FloatSetting* shaper_frequency;
+    FloatSetting* shaper_damping;
     FloatSetting* max_travel;
     FloatSetting* run_current;
     FloatSetting* hold_current;
@@ -12,6 +12,9 @@ IntSetting* pulse_microseconds;
 IntSetting* stepper_idle_lock_time;
 IntSetting* direction_delay_microseconds;
 IntSetting* enable_delay_microseconds;
+IntSetting* stepper_segments;
+IntSetting* planner_blocks;
+IntSetting* client_rx_buffer_size;
 
 AxisMaskSetting* step_invert_mask;
 AxisMaskSetting* dir_invert_mask;
@@ -29,6 +32,7 @@ FlagSetting* soft_limits;
 FlagSetting* hard_limits;
 // TODO Settings - need to call limits_init;
 FlagSetting* homing_enable;
+FlagSetting* homing_concurrent;
 // TODO Settings - also need to clear, but not set, soft_limits
 FlagSetting* laser_mode;
 // TODO Settings - also need to call my_spindle->init;
@@ -62,6 +66,15 @@ EnumSetting* spindle_type;
 
 EnumSetting* message_level;
 
+#ifdef SYRINGE_AXIS
+FlagSetting*  syringe_volumetric;
+FloatSetting* syringe_ul_per_mm;
+#endif
+
+#ifdef DECK_MAP_ROWS
+FloatSetting* deck_clearance;
+#endif
+
 enum_opt_t spindleTypes = {
     // clang-format off
     { "NONE", int8_t(SpindleType::NONE) },
@@ -77,6 +90,15 @@ enum_opt_t spindleTypes = {
     // clang-format on
 };
 
+enum_opt_t shaperTypes = {
+    // clang-format off
+    { "NONE", int8_t(ShaperType::None) },
+    { "ZV", int8_t(ShaperType::ZV) },
+    { "ZVD", int8_t(ShaperType::ZVD) },
+    { "EI", int8_t(ShaperType::EI) },
+    // clang-format on
+};
+
 enum_opt_t messageLevels = {
     // clang-format off
     { "None", int8_t(MsgLevel::None) },
@@ -107,6 +129,10 @@ typedef struct {
     float       steps_per_mm;
     float       max_rate;
     float       acceleration;
+    float       jerk;
+    ShaperType  shaper_type;
+    float       shaper_frequency;
+    float       shaper_damping;
     float       max_travel;
     float       home_mpos;
     float       run_current;
@@ -118,6 +144,10 @@ axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_X_STEPS_PER_MM,
                                       DEFAULT_X_MAX_RATE,
                                       DEFAULT_X_ACCELERATION,
+                                      DEFAULT_X_JERK,
+                                      DEFAULT_X_SHAPER_TYPE,
+                                      DEFAULT_X_SHAPER_FREQUENCY,
+                                      DEFAULT_X_SHAPER_DAMPING,
                                       DEFAULT_X_MAX_TRAVEL,
                                       DEFAULT_X_HOMING_MPOS,
                                       DEFAULT_X_CURRENT,
@@ -128,6 +158,10 @@ axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_Y_STEPS_PER_MM,
                                       DEFAULT_Y_MAX_RATE,
                                       DEFAULT_Y_ACCELERATION,
+                                      DEFAULT_Y_JERK,
+                                      DEFAULT_Y_SHAPER_TYPE,
+                                      DEFAULT_Y_SHAPER_FREQUENCY,
+                                      DEFAULT_Y_SHAPER_DAMPING,
                                       DEFAULT_Y_MAX_TRAVEL,
                                       DEFAULT_Y_HOMING_MPOS,
                                       DEFAULT_Y_CURRENT,
@@ -138,6 +172,10 @@ axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_Z_STEPS_PER_MM,
                                       DEFAULT_Z_MAX_RATE,
                                       DEFAULT_Z_ACCELERATION,
+                                      DEFAULT_Z_JERK,
+                                      DEFAULT_Z_SHAPER_TYPE,
+                                      DEFAULT_Z_SHAPER_FREQUENCY,
+                                      DEFAULT_Z_SHAPER_DAMPING,
                                       DEFAULT_Z_MAX_TRAVEL,
                                       DEFAULT_Z_HOMING_MPOS,
                                       DEFAULT_Z_CURRENT,
@@ -148,6 +186,10 @@ axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_A_STEPS_PER_MM,
                                       DEFAULT_A_MAX_RATE,
                                       DEFAULT_A_ACCELERATION,
+                                      DEFAULT_A_JERK,
+                                      DEFAULT_A_SHAPER_TYPE,
+                                      DEFAULT_A_SHAPER_FREQUENCY,
+                                      DEFAULT_A_SHAPER_DAMPING,
                                       DEFAULT_A_MAX_TRAVEL,
                                       DEFAULT_A_HOMING_MPOS,
                                       DEFAULT_A_CURRENT,
@@ -158,6 +200,10 @@ axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_B_STEPS_PER_MM,
                                       DEFAULT_B_MAX_RATE,
                                       DEFAULT_B_ACCELERATION,
+                                      DEFAULT_B_JERK,
+                                      DEFAULT_B_SHAPER_TYPE,
+                                      DEFAULT_B_SHAPER_FREQUENCY,
+                                      DEFAULT_B_SHAPER_DAMPING,
                                       DEFAULT_B_MAX_TRAVEL,
                                       DEFAULT_B_HOMING_MPOS,
                                       DEFAULT_B_CURRENT,
@@ -168,6 +214,10 @@ axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_C_STEPS_PER_MM,
                                       DEFAULT_C_MAX_RATE,
                                       DEFAULT_C_ACCELERATION,
+                                      DEFAULT_C_JERK,
+                                      DEFAULT_C_SHAPER_TYPE,
+                                      DEFAULT_C_SHAPER_FREQUENCY,
+                                      DEFAULT_C_SHAPER_DAMPING,
                                       DEFAULT_C_MAX_TRAVEL,
                                       DEFAULT_C_HOMING_MPOS,
                                       DEFAULT_C_CURRENT,
@@ -253,6 +303,24 @@ void make_settings() {
     make_coordinate(CoordIndex::G28, "G28");
     make_coordinate(CoordIndex::G30, "G30");
 
+#ifdef LABWARE_SLOTS
+    // Labware definitions LW0, LW1 ...
+    for (int slot = 0; slot < LABWARE_SLOTS; slot++) {
+        char* name = (char*)malloc(8);
+        snprintf(name, 8, "LW%d", slot);
+        labware[slot] = new Labware(name);
+        if (!labware[slot]->load()) {
+            labware[slot]->setDefault();
+        }
+    }
+#endif
+#ifdef DECK_MAP_ROWS
+    deck_map = new DeckMap("DeckMap");
+    if (!deck_map->load()) {
+        deck_map->setDefault();
+    }
+#endif
+
     verbose_errors = new FlagSetting(EXTENDED, WG, NULL, "Errors/Verbose", DEFAULT_VERBOSE_ERRORS);
 
     // number_axis = new IntSetting(EXTENDED, WG, NULL, "NumberAxis", N_AXIS, 0, 6, NULL, true);
@@ -314,6 +382,33 @@ void make_settings() {
         axis_settings[axis]->home_mpos = setting;
     }
 
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            EXTENDED, WG, NULL, makename(def->name, "Shaper/Damping"), def->shaper_damping, 0.0, 0.5);  // Damping ratio
+        setting->setAxis(axis);
+        axis_settings[axis]->shaper_damping = setting;
+    }
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            EXTENDED, WG, NULL, makename(def->name, "Shaper/Frequency"), def->shaper_frequency, 1.0, 500.0);  // Hz
+        setting->setAxis(axis);
+        axis_settings[axis]->shaper_frequency = setting;
+    }
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new EnumSetting(
+            NULL, EXTENDED, WG, NULL, makename(def->name, "Shaper/Type"), static_cast<int8_t>(def->shaper_type), &shaperTypes, NULL);
+        setting->setAxis(axis);
+        axis_settings[axis]->shaper_type = setting;
+    }
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(EXTENDED, WG, NULL, makename(def->name, "Jerk"), def->jerk, 0.0, 10000000.0);  // mm/sec^3
+        setting->setAxis(axis);
+        axis_settings[axis]->jerk = setting;
+    }
     for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
         def = &axis_defaults[axis];
         auto setting =
@@ -377,6 +472,7 @@ void make_settings() {
     homing_seek_rate    = new FloatSetting(GRBL, WG, "25", "Homing/Seek", DEFAULT_HOMING_SEEK_RATE, 0, 10000);
     homing_feed_rate    = new FloatSetting(GRBL, WG, "24", "Homing/Feed", DEFAULT_HOMING_FEED_RATE, 0, 10000);
     homing_squared_axes = new AxisMaskSetting(EXTENDED, WG, NULL, "Homing/Squared", DEFAULT_HOMING_SQUARED_AXES);
+    homing_concurrent   = new FlagSetting(EXTENDED, WG, NULL, "Homing/Concurrent", DEFAULT_HOMING_CONCURRENT);
 
     // TODO Settings - need to call st_generate_step_invert_masks()
     homing_dir_mask = new AxisMaskSetting(GRBL, WG, "23", "Homing/DirInvert", DEFAULT_HOMING_DIR_MASK);
@@ -394,15 +490,30 @@ void make_settings() {
     junction_deviation = new FloatSetting(GRBL, WG, "11", "GCode/JunctionDeviation", DEFAULT_JUNCTION_DEVIATION, 0, 10);
     status_mask        = new IntSetting(GRBL, WG, "10", "Report/Status", DEFAULT_STATUS_REPORT_MASK, 0, 3);
 
-    probe_invert                 = new FlagSetting(GRBL, WG, "6", "Probe/Invert", DEFAULT_INVERT_PROBE_PIN);
+    probe_invert                 = new FlagSetting(GRBL, WG, "6", "Probe/Invert", DEFAULT_INVERT_PROBE_PIN, postMotorSetting);
     limit_invert                 = new FlagSetting(GRBL, WG, "5", "Limits/Invert", DEFAULT_INVERT_LIMIT_PINS);
-    step_enable_invert           = new FlagSetting(GRBL, WG, "4", "Stepper/EnableInvert", DEFAULT_INVERT_ST_ENABLE);
+    step_enable_invert           = new FlagSetting(GRBL, WG, "4", "Stepper/EnableInvert", DEFAULT_INVERT_ST_ENABLE, postMotorSetting);
     dir_invert_mask              = new AxisMaskSetting(GRBL, WG, "3", "Stepper/DirInvert", DEFAULT_DIRECTION_INVERT_MASK, postMotorSetting);
     step_invert_mask             = new AxisMaskSetting(GRBL, WG, "2", "Stepper/StepInvert", DEFAULT_STEPPING_INVERT_MASK, postMotorSetting);
-    stepper_idle_lock_time       = new IntSetting(GRBL, WG, "1", "Stepper/IdleTime", DEFAULT_STEPPER_IDLE_LOCK_TIME, 0, 255);
-    pulse_microseconds           = new IntSetting(GRBL, WG, "0", "Stepper/Pulse", DEFAULT_STEP_PULSE_MICROSECONDS, 3, 1000);
-    direction_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Direction/Delay", STEP_PULSE_DELAY, 0, 1000);
-    enable_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Enable/Delay", DEFAULT_STEP_ENABLE_DELAY, 0, 1000);  // microseconds
+    stepper_idle_lock_time       = new IntSetting(GRBL, WG, "1", "Stepper/IdleTime", DEFAULT_STEPPER_IDLE_LOCK_TIME, 0, 255, postMotorSetting);
+    pulse_microseconds           = new IntSetting(GRBL, WG, "0", "Stepper/Pulse", DEFAULT_STEP_PULSE_MICROSECONDS, 3, 1000, postMotorSetting);
+    direction_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Direction/Delay", STEP_PULSE_DELAY, 0, 1000, postMotorSetting);
+    enable_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Enable/Delay", DEFAULT_STEP_ENABLE_DELAY, 0, 1000, postMotorSetting);  // microseconds
+
+    // The motion and client buffers are allocated at boot, so these take effect after a restart
+    stepper_segments      = new IntSetting(EXTENDED, WG, NULL, "Stepper/Segments", SEGMENT_BUFFER_SIZE, 3, MAX_SEGMENT_BUFFER_SIZE);
+    planner_blocks        = new IntSetting(EXTENDED, WG, NULL, "Planner/Blocks", BLOCK_BUFFER_SIZE, 4, MAX_BLOCK_BUFFER_SIZE);
+    client_rx_buffer_size = new IntSetting(EXTENDED, WG, NULL, "Client/RxBuffer", RX_BUFFER_SIZE, 256, MAX_RX_BUFFER_SIZE);
+
+#ifdef SYRINGE_AXIS
+    // uL/mm is unused with ENABLE_PIECEWISE_LINEAR_SYRINGE, which takes the calibration table instead
+    syringe_volumetric = new FlagSetting(EXTENDED, WG, NULL, "Syringe/Volumetric", DEFAULT_SYRINGE_VOLUMETRIC);
+    syringe_ul_per_mm  = new FloatSetting(EXTENDED, WG, NULL, "Syringe/UlPerMm", DEFAULT_SYRINGE_UL_PER_MM, 0.001, 100000.0);
+#endif
+
+#ifdef DECK_MAP_ROWS
+    deck_clearance = new FloatSetting(EXTENDED, WG, NULL, "Deck/Clearance", DEFAULT_DECK_CLEARANCE, 0.0, 100.0);
+#endif
 
     stallguard_debug_mask = new AxisMaskSetting(EXTENDED, WG, NULL, "Report/StallGuard", 0, postMotorSetting);
 
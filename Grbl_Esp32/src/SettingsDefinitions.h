@@ -20,6 +20,9 @@ extern IntSetting* pulse_microseconds;
 extern IntSetting* stepper_idle_lock_time;
 extern IntSetting* direction_delay_microseconds;
 extern IntSetting* enable_delay_microseconds;
+extern IntSetting* stepper_segments;
+extern IntSetting* planner_blocks;
+extern IntSetting* client_rx_buffer_size;
 
 extern AxisMaskSetting* step_invert_mask;
 extern AxisMaskSetting* dir_invert_mask;
@@ -34,6 +37,7 @@ extern FlagSetting* report_inches;
 extern FlagSetting* soft_limits;
 extern FlagSetting* hard_limits;
 extern FlagSetting* homing_enable;
+extern FlagSetting* homing_concurrent;
 extern FlagSetting* laser_mode;
 extern IntSetting*  laser_full_power;
 
@@ -70,3 +74,12 @@ extern StringSetting* user_macro2;
 extern StringSetting* user_macro3;
 
 extern EnumSetting* message_level;
+
+#ifdef SYRINGE_AXIS
+extern FlagSetting*  syringe_volumetric;
+extern FloatSetting* syringe_ul_per_mm;
+#endif
+
+#ifdef DECK_MAP_ROWS
+extern FloatSetting* deck_clearance;
+#endif
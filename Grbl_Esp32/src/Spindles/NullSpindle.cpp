@@ -30,7 +30,7 @@ namespace Spindles {
         use_delays    = false;
         config_message();
     }
-    uint32_t Null::set_rpm(uint32_t rpm) {
+    uint32_t IRAM_ATTR Null::set_rpm(uint32_t rpm) {
         sys.spindle_speed = rpm;
         return rpm;
     }
@@ -96,6 +96,7 @@ namespace Spindles {
         }
 
         spindle->init();
+        st_isr_attach();  // The stepper ISR calls set_rpm()
     }
 
     // ========================= Spindle ==================================
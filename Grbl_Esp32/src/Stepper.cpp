@@ -26,10 +26,12 @@
 #include "Grbl.h"
 
 #include <atomic>
+#include <esp_cpu.h>
+#include <soc/soc_memory_layout.h>
 
 // Stores the planner block Bresenham algorithm execution data for the segments in the segment
 // buffer. Normally, this buffer is partially in-use, but, for the worst case scenario, it will
-// never exceed the number of accessible stepper buffer segments (SEGMENT_BUFFER_SIZE-1).
+// never exceed the number of accessible stepper buffer segments (segment_buffer_size-1).
 // NOTE: This data is copied from the prepped planner blocks so that the planner blocks may be
 // discarded when entirely consumed and completed by the segment buffer. Also, AMASS alters this
 // data for its own use.
@@ -39,7 +41,7 @@ typedef struct {
     uint8_t  direction_bits;
     uint8_t  is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
 } st_block_t;
-static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE - 1];
+static st_block_t* st_block_buffer;
 
 // Primary stepper segment ring buffer. Contains small, short line segments for the stepper
 // algorithm to execute, which are "checked-out" incrementally from the first block in the
@@ -51,8 +53,23 @@ typedef struct {
     uint8_t  st_block_index;  // Stepper block data index. Uses this information to execute this segment.
     uint8_t  amass_level;     // AMASS level for the ISR to execute this segment
     uint16_t spindle_rpm;     // TODO get rid of this.
+#ifdef STEP_PATTERN_PRERENDER
+    uint8_t  prerendered;          // Step masks are in segment_pattern[], otherwise traced by the ISR
+    uint32_t counter[MAX_N_AXIS];  // Bresenham counters at the start of the segment, for the ISR trace
+#endif
+#ifdef ASYNC_AXIS
+    uint16_t async_steps;  // Async axis steps, spread evenly over the n_step ISR ticks
+    uint8_t  async_dir;    // Async axis direction bit of this segment
+#endif
 } segment_t;
-static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
+static segment_t* segment_buffer;
+static uint8_t    segment_buffer_size;  // Set by $Stepper/Segments at boot
+
+#ifdef STEP_PATTERN_PRERENDER
+// Pre-rendered step masks for each segment in the segment buffer, one per ISR tick. The tick
+// period is constant within a segment (isrPeriod), so only the masks need to be stored.
+static uint8_t (*segment_pattern)[STEP_PATTERN_MAX_TICKS];
+#endif
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
 typedef struct {
@@ -68,9 +85,16 @@ typedef struct {
     uint32_t steps[MAX_N_AXIS];
 
     uint16_t    step_count;        // Steps remaining in line segment motion
+    uint16_t    seg_steps[MAX_N_AXIS];  // Steps taken per axis in this segment, not yet in sys_position
     uint8_t     exec_block_index;  // Tracks the current st_block index. Change indicates new block.
     st_block_t* exec_block;        // Pointer to the block data for the segment being executed
     segment_t*  exec_segment;      // Pointer to the segment being executed
+#ifdef STEP_PATTERN_PRERENDER
+    const uint8_t* step_pattern;  // Next pre-rendered step mask, NULL if the segment is traced here
+#endif
+#ifdef ASYNC_AXIS
+    uint32_t async_counter;  // Spreads the async axis steps of the segment over its ticks
+#endif
 } stepper_t;
 static stepper_t st;
 
@@ -82,11 +106,22 @@ static uint8_t          segment_next_head;
 // Used to avoid ISR nesting of the "Stepper Driver Interrupt". Should never occur though.
 static std::atomic<bool> busy;
 
-// Pointers for the step segment being prepped from the planner buffer. Accessed only by the
-// main program. Pointers may be planning segments or planner blocks ahead of what being executed.
+// Bumped before and after st.seg_steps[] is folded into sys_position, so it is odd while
+// the fold is in progress. Lets st_get_realtime_position() read a consistent position.
+static std::atomic<uint32_t> position_seq;
+// Keeps the fold from being preempted. A probe latch interrupt on the core of the fold would
+// otherwise spin on position_seq forever.
+static portMUX_TYPE position_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Pointers for the step segment being prepped from the planner buffer. Accessed only with the
+// prep lock held. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t* pl_block;       // Pointer to the planner block being prepped
 static st_block_t*   st_prep_block;  // Pointer to the stepper block data being prepped
 
+// Segment prep task and the lock it shares with the planner and the main loop
+static TaskHandle_t      st_prep_task_handle = NULL;
+static SemaphoreHandle_t st_prep_mutex       = NULL;
+
 // esp32 work around for disable in main loop
 uint64_t stepper_idle_counter;  // used to count down until time to disable stepper drivers
 bool     stepper_idle;
@@ -97,6 +132,10 @@ typedef struct {
     uint8_t  st_block_index;  // Index of stepper common data block being prepped
     PrepFlag recalculate_flag;
 
+#ifdef STEP_PATTERN_PRERENDER
+    uint32_t counter[MAX_N_AXIS];  // Bresenham counters of the block being prepped
+#endif
+
     float dt_remainder;
     float steps_remaining;
     float step_per_mm;
@@ -107,6 +146,9 @@ typedef struct {
     float   last_steps_remaining;
     float   last_step_per_mm;
     float   last_dt_remainder;
+#    ifdef STEP_PATTERN_PRERENDER
+    uint32_t last_counter[MAX_N_AXIS];
+#    endif
 #endif
 
     uint8_t ramp_type;    // Current segment ramp state
@@ -118,13 +160,57 @@ typedef struct {
     float accelerate_until;  // Acceleration ramp end measured from end of block (mm)
     float decelerate_after;  // Deceleration ramp start measured from end of block (mm)
 
-    float inv_rate;  // Used by PWM laser mode to speed up segment calculations.
+    // Jerk-limited ramps. See st_ramp_begin().
+    float jerk;  // Jerk limit of the velocity profile (mm/min^3). 0 for constant acceleration ramps.
+    struct {
+        bool  active;     // The fields below describe the ramp being executed
+        float v0;         // Ramp start speed (mm/min)
+        float v1;         // Ramp end speed (mm/min)
+        float jerk;       // Signed jerk of the first phase (mm/min^3)
+        float jerk_time;  // Duration of each constant jerk phase (min)
+        float accel;      // Acceleration between the jerk phases (mm/min^2)
+        float duration;   // Ramp duration (min)
+        float mm_total;   // Ramp distance (mm)
+        float mm_start;   // Ramp start measured from end of block (mm)
+        float time;       // Time into the ramp (min)
+    } ramp;
+
+    uint8_t is_pwm_rate_adjusted;  // The prepped block requires constant laser power/rate
+    float   inv_rate;              // Used by PWM laser mode to speed up segment calculations.
     //uint16_t current_spindle_pwm;  // todo remove
     float current_spindle_rpm;
 
 } st_prep_t;
 static st_prep_t prep;
 
+/* Input shaping. With a shaper on any axis, the segment generator runs the planned velocity
+   profile into a history of unshaped axis positions rather than straight into step segments.
+   The segments are then cut, DT_SEGMENT at a time, from each axis' unshaped position convolved
+   with the impulses of that axis' own shaper. Ramps, junctions and feed holds are all shaped
+   alike, however short they are. The shaped motion lags the profile by up to the shaper
+   duration, and corners are rounded over that time, as with any input shaper. The axis steps
+   of a shaped segment don't keep to the ratios of a planner block, so each one gets stepper
+   block data of its own.
+     Whether to shape is decided each time a motion starts from rest. Motions that bypass the
+   shaper, the resonance sweep and the system motions, start once the shaped motion before
+   them has stopped. Positions here are relative to the last st_reset().
+*/
+typedef struct {
+    bool           active;                        // Motions are shaped
+    bool           stopped;                       // The unshaped profile is at rest
+    bool           held;                          // The unshaped profile stopped at the end of a feed hold
+    ShaperImpulses axis[MAX_N_AXIS];              // Impulses of each axis' shaper
+    float          duration;                      // Time of the last impulse of the longest shaper (min)
+    ShaperHistory  history;                       // Unshaped axis positions (steps) over time (min)
+    double         block_start[SHAPER_MAX_AXES];  // Unshaped position at the start of the prepped block (steps)
+    double         time;                          // End of the last shaped segment (min)
+    float          dt_carry;                      // Time of shaped segments too short for a step (min)
+    int32_t        position[MAX_N_AXIS];          // Position at the end of the last shaped segment (steps)
+    float          speed;                         // Speed of the last shaped segment (mm/min)
+} st_shaper_t;
+static st_shaper_t st_shaper;
+static_assert(MAX_N_AXIS <= SHAPER_MAX_AXES, "ShaperHistory holds fewer axes than MAX_N_AXIS");
+
 const char* stepper_names[] = {
     "Timed Steps",
     "RMT Steps",
@@ -134,6 +220,17 @@ const char* stepper_names[] = {
 
 stepper_id_t current_stepper = DEFAULT_STEPPER;
 
+DRAM_ATTR stepper_config_t st_config;
+DRAM_ATTR st_isr_stats_t   st_isr_stats;
+
+bool st_isr_in_iram = false;
+
+// spindle->set_rpm(), resolved by st_isr_attach(), so the ISR does not read the vtable in flash
+typedef uint32_t (*spindle_set_rpm_t)(Spindles::Spindle*, uint32_t);
+static spindle_set_rpm_t st_spindle_set_rpm;
+
+static intr_handle_t st_timer_intr = NULL;
+
 /* "The Stepper Driver Interrupt" - This timer interrupt is the workhorse of Grbl. Grbl employs
    the venerable Bresenham line algorithm to manage and exactly synchronize multi-axis moves.
    Unlike the popular DDA algorithm, the Bresenham algorithm is not susceptible to numerical
@@ -190,12 +287,69 @@ stepper_id_t current_stepper = DEFAULT_STEPPER;
 
 */
 
-static void stepper_pulse_func();
+static void IRAM_ATTR stepper_pulse_func();
+static void st_prep_buffer_locked();
+static void st_shaper_reset();
+
+// The ISR counts the steps of the running segment in st.seg_steps[] and adds them to the
+// int32 sys_position[] only when the segment completes (or the steppers are reset). The
+// direction is fixed within a segment, so the per step work is a single increment.
+// st_get_realtime_position() adds the in-flight counts for probing and status reports.
+static inline void IRAM_ATTR st_fold_position() {
+    portENTER_CRITICAL_SAFE(&position_mux);
+    position_seq++;
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        if (st.dir_outbits & bit(axis)) {
+            sys_position[axis] -= st.seg_steps[axis];
+        } else {
+            sys_position[axis] += st.seg_steps[axis];
+        }
+        st.seg_steps[axis] = 0;
+    }
+    position_seq++;
+    portEXIT_CRITICAL_SAFE(&position_mux);
+}
+
+static inline int IRAM_ATTR st_isr_hist_bin(uint32_t value) {
+    int bin = 31 - __builtin_clz(value | 1);
+    return bin < ST_ISR_HIST_BINS ? bin : ST_ISR_HIST_BINS - 1;
+}
+
+static inline void IRAM_ATTR st_isr_record(uint32_t latency, uint32_t exec) {
+    st_isr_stats.ticks++;
+    if (latency > ST_ISR_LATE_USEC * ticksPerMicrosecond) {
+        st_isr_stats.late++;
+    }
+    st_isr_stats.latency_min = MIN(st_isr_stats.latency_min, latency);
+    st_isr_stats.latency_max = MAX(st_isr_stats.latency_max, latency);
+    st_isr_stats.latency_sum += latency;
+    st_isr_stats.latency_hist[st_isr_hist_bin(latency)]++;
+    st_isr_stats.exec_min = MIN(st_isr_stats.exec_min, exec);
+    st_isr_stats.exec_max = MAX(st_isr_stats.exec_max, exec);
+    st_isr_stats.exec_sum += exec;
+    st_isr_stats.exec_hist[st_isr_hist_bin(exec)]++;
+}
+
+void st_isr_stats_reset() {
+    st_isr_stats_t stats = {};
+    stats.latency_min    = UINT32_MAX;
+    stats.exec_min       = UINT32_MAX;
+#ifdef USE_I2S_STEPS
+    stats.underrun_base = i2s_out_get_underruns();
+#endif
+    st_isr_stats = stats;
+}
+
+uint32_t st_isr_underruns(const st_isr_stats_t& stats) {
+#ifdef USE_I2S_STEPS
+    return i2s_out_get_underruns() - stats.underrun_base;
+#else
+    return 0;
+#endif
+}
 
-// TODO: Replace direct updating of the int32 position counters in the ISR somehow. Perhaps use smaller
-// int8 variables and update position counters only when a segment completes. This can get complicated
-// with probing and homing cycles that require true real-time positions.
 void IRAM_ATTR onStepperDriverTimer(void* para) {
+    uint32_t entry = esp_cpu_get_ccount();
     // Timer ISR, normally takes a step.
     //
     // When handling an interrupt within an interrupt serivce routine (ISR), the interrupt status bit
@@ -208,34 +362,54 @@ void IRAM_ATTR onStepperDriverTimer(void* para) {
     TIMERG0.int_clr_timers.t0 = 1;
 #endif
 
+    // The timer reloads to zero at the alarm, so its count is the time since the alarm.
+    // Only sample it here; the stats are updated after the step is out.
+    uint32_t latency = timer_group_get_counter_value_in_isr(STEP_TIMER_GROUP, STEP_TIMER_INDEX);
+
     bool expected = false;
     if (busy.compare_exchange_strong(expected, true)) {
         stepper_pulse_func();
 
 #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(ESP32S3)
-        // ESP32-S3: Use timer API instead of direct register access
-        timer_enable_intr(STEP_TIMER_GROUP, STEP_TIMER_INDEX);
+        // ESP32-S3: Use the ISR-safe timer API instead of direct register access
+        timer_group_enable_alarm_in_isr(STEP_TIMER_GROUP, STEP_TIMER_INDEX);
 #else
         // ESP32 classic timer register structure
         TIMERG0.hw_timer[STEP_TIMER_INDEX].config.alarm_en = TIMER_ALARM_EN;
 #endif
 
         busy.store(false);
+        st_isr_record(latency, esp_cpu_get_ccount() - entry);
+    } else {
+        st_isr_stats.busy++;
     }
 }
 
+#ifdef USE_I2S_STEPS
+// Pulse callback for ST_I2S_STREAM. The I2S render task calls it ahead of the DMA, so
+// there is no alarm latency to measure, only the execution time.
+static void IRAM_ATTR stepper_pulse_stream() {
+    uint32_t entry = esp_cpu_get_ccount();
+    stepper_pulse_func();
+    st_isr_record(0, esp_cpu_get_ccount() - entry);
+}
+#endif
+
 /**
  * This phase of the ISR should ONLY create the pulses for the steppers.
  * This prevents jitter caused by the interval between the start of the
  * interrupt and the start of the pulses. DON'T add any logic ahead of the
  * call to this method that might cause variation in the timing. The aim
  * is to keep pulse timing as regular as possible.
+ *
+ * NOTE: Everything called from here must be IRAM_ATTR. scripts/check_isr_iram.py checks
+ * this at build time.
  */
-static void stepper_pulse_func() {
-    auto n_axis = number_axis->get();
+static void IRAM_ATTR stepper_pulse_func() {
+    auto n_axis = st_config.n_axis;
 
     if (motors_direction(st.dir_outbits)) {
-        auto wait_direction = direction_delay_microseconds->get();
+        auto wait_direction = st_config.direction_delay_microseconds;
         if (wait_direction > 0) {
             // Stepper drivers need some time between changing direction and doing a pulse.
             switch (current_stepper) {
@@ -280,55 +454,92 @@ static void stepper_pulse_func() {
             // Initialize step segment timing per step and load number of steps to execute.
             Stepper_Timer_WritePeriod(st.exec_segment->isrPeriod);
             st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
+#ifdef ASYNC_AXIS
+            st.async_counter = st.exec_segment->n_step >> 1;
+#endif
             // If the new segment starts a new planner block, initialize stepper variables and counters.
             // NOTE: When the segment data index changes, this indicates a new planner block.
             if (st.exec_block_index != st.exec_segment->st_block_index) {
                 st.exec_block_index = st.exec_segment->st_block_index;
                 st.exec_block       = &st_block_buffer[st.exec_block_index];
+#ifndef STEP_PATTERN_PRERENDER
                 // Initialize Bresenham line and distance counters
                 for (int axis = 0; axis < n_axis; axis++) {
                     st.counter[axis] = (st.exec_block->step_event_count >> 1);
                 }
+#endif
             }
             st.dir_outbits = st.exec_block->direction_bits;
+#ifdef ASYNC_AXIS
+            // Async axis steps come with their own direction. Blocks with them don't move the axis.
+            if (st.exec_segment->async_steps) {
+                st.dir_outbits = (st.dir_outbits & ~bit(ASYNC_AXIS)) | st.exec_segment->async_dir;
+            }
+#endif
+#ifdef STEP_PATTERN_PRERENDER
+            if (st.exec_segment->prerendered) {
+                st.step_pattern = segment_pattern[segment_buffer_tail];
+            } else {
+                // Too long to pre-render. Trace it here, from where st_prep_buffer() left off.
+                st.step_pattern = NULL;
+                memcpy(st.counter, st.exec_segment->counter, sizeof(st.counter));
+            }
+#endif
             // Adjust Bresenham axis increment counters according to AMASS level.
             for (int axis = 0; axis < n_axis; axis++) {
                 st.steps[axis] = st.exec_block->steps[axis] >> st.exec_segment->amass_level;
             }
             // Set real-time spindle output as segment is loaded, just prior to the first step.
-            spindle->set_rpm(st.exec_segment->spindle_rpm);
+            st_spindle_set_rpm(spindle, st.exec_segment->spindle_rpm);
         } else {
             // Segment buffer empty. Shutdown.
             st_go_idle();
             if (sys.state != State::Jog) {  // added to prevent ... jog after probing crash
                 // Ensure pwm is set properly upon completion of rate-controlled motion.
                 if (st.exec_block != NULL && st.exec_block->is_pwm_rate_adjusted) {
-                    spindle->set_rpm(0);
+                    st_spindle_set_rpm(spindle, 0);
                 }
             }
             cycle_stop = true;
             return;  // Nothing to do but exit.
         }
     }
+#ifndef PROBE_EDGE_LATCH
     // Check probing state.
     if (sys_probe_state == Probe::Active) {
         probe_state_monitor();
     }
+#endif
     // Reset step out bits.
     st.step_outbits = 0;
 
-    for (int axis = 0; axis < n_axis; axis++) {
-        // Execute step displacement profile by Bresenham line algorithm
-        st.counter[axis] += st.steps[axis];
-        if (st.counter[axis] > st.exec_block->step_event_count) {
-            st.step_outbits |= bit(axis);
-            st.counter[axis] -= st.exec_block->step_event_count;
-            if (st.exec_block->direction_bits & bit(axis)) {
-                sys_position[axis]--;
-            } else {
-                sys_position[axis]++;
+#ifdef STEP_PATTERN_PRERENDER
+    if (st.step_pattern != NULL) {
+        // Output the pre-rendered step mask and account for the steps it takes.
+        st.step_outbits = *st.step_pattern++;
+        for (uint8_t bits = st.step_outbits; bits; bits &= bits - 1) {
+            st.seg_steps[__builtin_ctz(bits)]++;
+        }
+    } else
+#endif
+    {
+        for (int axis = 0; axis < n_axis; axis++) {
+            // Execute step displacement profile by Bresenham line algorithm
+            st.counter[axis] += st.steps[axis];
+            if (st.counter[axis] > st.exec_block->step_event_count) {
+                st.step_outbits |= bit(axis);
+                st.counter[axis] -= st.exec_block->step_event_count;
+                st.seg_steps[axis]++;
             }
         }
+#ifdef ASYNC_AXIS
+        st.async_counter += st.exec_segment->async_steps;
+        if (st.async_counter >= st.exec_segment->n_step) {
+            st.step_outbits |= bit(ASYNC_AXIS);
+            st.async_counter -= st.exec_segment->n_step;
+            st.seg_steps[ASYNC_AXIS]++;
+        }
+#endif
     }
 
     // During a homing cycle, lock out and prevent desired axes from moving.
@@ -337,23 +548,25 @@ static void stepper_pulse_func() {
     }
     st.step_count--;  // Decrement step events count
     if (st.step_count == 0) {
-        // Segment is complete. Discard current segment and advance segment indexing.
+        // Segment is complete. Account for its steps, discard it and advance segment indexing.
+        st_fold_position();
         st.exec_segment = NULL;
-        if (++segment_buffer_tail == SEGMENT_BUFFER_SIZE) {
+        if (++segment_buffer_tail == segment_buffer_size) {
             segment_buffer_tail = 0;
         }
+        st_prep_wake();  // A segment is free, refill it
     }
 
     switch (current_stepper) {
         case ST_I2S_STREAM:
             // Generate the number of pulses needed to span pulse_microseconds
-            i2s_out_push_sample(pulse_microseconds->get());
+            i2s_out_push_sample(st_config.pulse_microseconds);
             motors_unstep();
             break;
         case ST_I2S_STATIC:
         case ST_TIMED:
             // wait for step pulse time to complete...some time expired during code above
-            while (esp_timer_get_time() - step_pulse_start_time < pulse_microseconds->get()) {
+            while (esp_timer_get_time() - step_pulse_start_time < st_config.pulse_microseconds) {
                 NOP();  // spin here until time to turn off step
             }
             motors_unstep();
@@ -363,18 +576,147 @@ static void stepper_pulse_func() {
     }
 }
 
+// Refreshes the stepper ISR copy of the step timing settings. Called at init and from
+// motors_read_settings() whenever one of those settings is changed.
+void st_read_settings() {
+    st_config.n_axis                       = number_axis->get();
+    st_config.pulse_microseconds           = pulse_microseconds->get();
+    st_config.direction_delay_microseconds = direction_delay_microseconds->get();
+    st_config.enable_delay_microseconds    = enable_delay_microseconds->get();
+    st_config.idle_lock_time               = stepper_idle_lock_time->get();
+    st_config.step_enable_invert           = step_enable_invert->get();
+    st_config.probe_invert                 = probe_invert->get();
+}
+
+// Number of stepper blocks for n_segments segments. With ASYNC_AXIS, the last one stays all
+// zero for the segments that only step the async axis.
+static uint8_t st_block_count(uint8_t n_segments) {
+#ifdef ASYNC_AXIS
+    return n_segments;
+#else
+    return n_segments - 1;
+#endif
+}
+
+// Allocates the segment ring and the data that goes with it, sized by $Stepper/Segments.
+// The stepper ISR reads all of it, so it must be in internal RAM.
+static bool st_alloc_buffers(uint8_t n_segments) {
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    segment_buffer      = (segment_t*)heap_caps_calloc(n_segments, sizeof(segment_t), caps);
+    st_block_buffer     = (st_block_t*)heap_caps_calloc(st_block_count(n_segments), sizeof(st_block_t), caps);
+    bool ok             = segment_buffer && st_block_buffer;
+#ifdef STEP_PATTERN_PRERENDER
+    segment_pattern = (uint8_t(*)[STEP_PATTERN_MAX_TICKS])heap_caps_calloc(n_segments, STEP_PATTERN_MAX_TICKS, caps);
+    ok              = ok && segment_pattern;
+#endif
+    if (ok) {
+        segment_buffer_size = n_segments;
+        return true;
+    }
+    heap_caps_free(segment_buffer);
+    heap_caps_free(st_block_buffer);
+#ifdef STEP_PATTERN_PRERENDER
+    heap_caps_free(segment_pattern);
+#endif
+    return false;
+}
+
+void st_prep_lock() {
+    if (st_prep_mutex != NULL) {
+        xSemaphoreTakeRecursive(st_prep_mutex, portMAX_DELAY);
+    }
+}
+
+void st_prep_unlock() {
+    if (st_prep_mutex != NULL) {
+        xSemaphoreGiveRecursive(st_prep_mutex);
+    }
+}
+
+void IRAM_ATTR st_prep_wake() {
+    if (st_prep_task_handle == NULL) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t higher_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(st_prep_task_handle, &higher_woken);
+        if (higher_woken) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        // ST_I2S_STREAM calls the pulse function from the I2S render task
+        xTaskNotifyGive(st_prep_task_handle);
+    }
+}
+
+// Keeps the segment buffer full in the same states the main loop refills it in.
+// Homing and parking drive their system motion from their own loops, which also
+// set up the planner block and prep state in several steps, so leave those alone.
+static void st_prep_task(void* pvParameters) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ST_PREP_TASK_PERIOD_MS));
+        st_prep_lock();
+        if (!sys.step_control.executeSysMotion) {
+            switch (sys.state) {
+                case State::Cycle:
+                case State::Hold:
+                case State::SafetyDoor:
+                case State::Sleep:
+                case State::Jog:
+                    st_prep_buffer_locked();
+                    break;
+                default:
+                    break;
+            }
+        }
+        st_prep_unlock();
+    }
+}
+
 void stepper_init() {
     busy.store(false); 
+    st_read_settings();
+    st_isr_stats_reset();
+
+    if (!st_alloc_buffers(stepper_segments->get())) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot allocate %d step segments", stepper_segments->get());
+        if (!st_alloc_buffers(SEGMENT_BUFFER_SIZE)) {
+            // Nothing can move without step segments. Stop the boot here rather than run on no buffer.
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot allocate the step segments. Halted");
+            while (true) {
+                vTaskDelay(portMAX_DELAY);
+            }
+        }
+    }
+    size_t segment_bytes = sizeof(segment_t);
+#ifdef STEP_PATTERN_PRERENDER
+    segment_bytes += STEP_PATTERN_MAX_TICKS;
+#endif
+    grbl_msg_sendf(CLIENT_SERIAL,
+                   MsgLevel::Info,
+                   "Step segments %d, %d bytes",
+                   segment_buffer_size,
+                   segment_buffer_size * segment_bytes + st_block_count(segment_buffer_size) * sizeof(st_block_t));
     
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Axis count %d", number_axis->get());
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "%s", stepper_names[current_stepper]);
 
 #ifdef USE_I2S_STEPS
     // I2S stepper stream mode use callback but timer interrupt
-    i2s_out_set_pulse_callback(stepper_pulse_func);
+    i2s_out_set_pulse_callback(stepper_pulse_stream);
 #endif
     // Other stepper use timer interrupt
     Stepper_Timer_Init();
+
+    st_prep_mutex = xSemaphoreCreateRecursiveMutex();
+    xTaskCreatePinnedToCore(st_prep_task,           // task
+                            "segPrepTask",          // name for task
+                            4096,                   // size of task stack
+                            NULL,                   // parameters
+                            ST_PREP_TASK_PRIORITY,  // priority
+                            &st_prep_task_handle,   // handle
+                            ST_PREP_TASK_CORE       // core opposite WiFi
+    );
 }
 
 void stepper_switch(stepper_id_t new_stepper) {
@@ -431,10 +773,18 @@ void st_reset() {
         i2s_out_reset();
     }
 #endif
+    st_prep_lock();
     st_go_idle();
+    // Keep the steps of a segment cut short by the reset.
+    st_fold_position();
     // Initialize stepper algorithm variables.
     memset(&prep, 0, sizeof(st_prep_t));
     memset(&st, 0, sizeof(stepper_t));
+    st_shaper_reset();
+#ifdef ASYNC_AXIS
+    // The async steps in the dropped segments are lost with them, so its queue goes too.
+    async_reset();
+#endif
     st.exec_segment     = NULL;
     pl_block            = NULL;  // Planner block pointer used by segment buffer
     segment_buffer_tail = 0;
@@ -442,16 +792,17 @@ void st_reset() {
     segment_next_head   = 1;
     st.step_outbits     = 0;
     st.dir_outbits      = 0;  // Initialize direction bits to default.
+    st_prep_unlock();
     // TODO do we need to turn step pins off?
 }
 
 // Stepper shutdown
-void st_go_idle() {
+void IRAM_ATTR st_go_idle() {
     // Disable Stepper Driver Interrupt. Allow Stepper Port Reset Interrupt to finish, if active.
     Stepper_Timer_Stop();
 
     // Set stepper driver idle state, disabled or enabled, depending on settings and circumstances.
-    if (((stepper_idle_lock_time->get() != 0xff) || sys_rt_exec_alarm != ExecAlarm::None || sys.state == State::Sleep) &&
+    if (((st_config.idle_lock_time != 0xff) || sys_rt_exec_alarm != ExecAlarm::None || sys.state == State::Sleep) &&
         sys.state != State::Homing) {
         // Force stepper dwell to lock axes for a defined amount of time to ensure the axes come to a complete
         // stop and not drift from residual inertial forces at the end of the last movement.
@@ -460,7 +811,7 @@ void st_go_idle() {
             motors_set_disable(true);
         } else {
             stepper_idle         = true;  // esp32 work around for disable in main loop
-            stepper_idle_counter = esp_timer_get_time() + (stepper_idle_lock_time->get() * 1000);  // * 1000 because the time is in uSecs
+            stepper_idle_counter = esp_timer_get_time() + (st_config.idle_lock_time * 1000);  // * 1000 because the time is in uSecs
             // after idle countdown will be disabled in protocol loop
         }
     } else {
@@ -471,33 +822,58 @@ void st_go_idle() {
     st.step_outbits = 0;
 }
 
+// Copies the exact machine position in steps, including the steps of the segment being
+// executed, into position. Safe to call from the main loop and from any ISR. The fold runs in
+// a critical section, so it is never waited on from an interrupt that preempted it.
+void IRAM_ATTR st_get_realtime_position(int32_t* position) {
+    uint32_t seq;
+    do {
+        seq = position_seq;
+        for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+            if (st.dir_outbits & bit(axis)) {
+                position[axis] = sys_position[axis] - st.seg_steps[axis];
+            } else {
+                position[axis] = sys_position[axis] + st.seg_steps[axis];
+            }
+        }
+    } while ((seq & 1) || seq != position_seq);
+}
+
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 void st_update_plan_block_parameters() {
+    st_prep_lock();
     if (pl_block != NULL) {  // Ignore if at start of a new block.
         prep.recalculate_flag.recalculate = 1;
         pl_block->entry_speed_sqr         = prep.current_speed * prep.current_speed;  // Update entry speed.
         pl_block                          = NULL;  // Flag st_prep_segment() to load and check active velocity profile.
     }
+    st_prep_unlock();
 }
 
 #ifdef PARKING_ENABLE
 // Changes the run state of the step segment buffer to execute the special parking motion.
 void st_parking_setup_buffer() {
+    st_prep_lock();
     // Store step execution data of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         prep.last_st_block_index  = prep.st_block_index;
         prep.last_steps_remaining = prep.steps_remaining;
         prep.last_dt_remainder    = prep.dt_remainder;
         prep.last_step_per_mm     = prep.step_per_mm;
+#    ifdef STEP_PATTERN_PRERENDER
+        memcpy(prep.last_counter, prep.counter, sizeof(prep.counter));
+#    endif
     }
     // Set flags to execute a parking motion
     prep.recalculate_flag.parking     = 1;
     prep.recalculate_flag.recalculate = 0;
     pl_block                          = NULL;  // Always reset parking motion to reload new block.
+    st_prep_unlock();
 }
 
 // Restores the step segment buffer to the normal run state after a parking motion.
 void st_parking_restore_buffer() {
+    st_prep_lock();
     // Restore step execution data and flags of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         st_prep_block                          = &st_block_buffer[prep.last_st_block_index];
@@ -508,21 +884,378 @@ void st_parking_restore_buffer() {
         prep.recalculate_flag.holdPartialBlock = 1;
         prep.recalculate_flag.recalculate      = 1;
         prep.req_mm_increment                  = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;  // Recompute this value.
+#    ifdef STEP_PATTERN_PRERENDER
+        memcpy(prep.counter, prep.last_counter, sizeof(prep.counter));
+#    endif
     } else {
         prep.recalculate_flag = {};
     }
 
     pl_block = NULL;  // Set to reload next block.
+    st_prep_unlock();
 }
 #endif
 
 // Increments the step segment buffer block data ring buffer.
 static uint8_t st_next_block_index(uint8_t block_index) {
     block_index++;
-    return block_index == (SEGMENT_BUFFER_SIZE - 1) ? 0 : block_index;
+    return block_index == (segment_buffer_size - 1) ? 0 : block_index;
+}
+
+#ifdef STEP_PATTERN_PRERENDER
+#    ifdef ASYNC_AXIS
+// Adds the async axis steps to the step masks of a pre-rendered segment, spread over the ticks
+// the same way the ISR spreads them when it traces a segment.
+static void st_prep_render_async(segment_t* segment, uint8_t* pattern) {
+    uint32_t counter = segment->n_step >> 1;
+    for (uint16_t tick = 0; tick < segment->n_step; tick++) {
+        counter += segment->async_steps;
+        if (counter >= segment->n_step) {
+            pattern[tick] |= bit(ASYNC_AXIS);
+            counter -= segment->n_step;
+        }
+    }
+}
+#    endif
+
+// Runs the Bresenham line tracer over a prepped segment ahead of time, exactly as the stepper ISR
+// would, and stores the step bits of each ISR tick. The prep counters carry over from segment to
+// segment within a block. Segments too long for the pattern buffer (or with no steps) are left to
+// the ISR, which resumes tracing from the counters saved in the segment.
+static void st_prep_render_segment(segment_t* segment, uint8_t* pattern) {
+    auto     n_axis      = number_axis->get();
+    uint32_t event_count = st_prep_block->step_event_count;
+    uint32_t steps[MAX_N_AXIS];
+
+    memcpy(segment->counter, prep.counter, sizeof(prep.counter));
+    segment->prerendered = segment->n_step > 0 && segment->n_step <= STEP_PATTERN_MAX_TICKS;
+    for (int axis = 0; axis < n_axis; axis++) {
+        steps[axis] = st_prep_block->steps[axis] >> segment->amass_level;
+    }
+    for (uint16_t tick = 0; tick < segment->n_step; tick++) {
+        uint8_t step_bits = 0;
+        for (int axis = 0; axis < n_axis; axis++) {
+            prep.counter[axis] += steps[axis];
+            if (prep.counter[axis] > event_count) {
+                step_bits |= bit(axis);
+                prep.counter[axis] -= event_count;
+            }
+        }
+        if (segment->prerendered) {
+            pattern[tick] = step_bits;
+        }
+    }
+#    ifdef ASYNC_AXIS
+    if (segment->prerendered) {
+        st_prep_render_async(segment, pattern);
+    }
+#    endif
 }
+#endif
 
-/* Prepares step segment buffer. Continuously called from main program.
+/* Sets up a ramp from v0 to v1 over mm, starting mm_start from the end of the block. The ramp takes
+   the time of a constant acceleration ramp, 2*mm/(v0+v1), so it fits the planner's entry and exit
+   speeds. With a jerk limit the acceleration rises at the limit, holds, and falls again, symmetric
+   in time, or is a triangle at whatever jerk the ramp time allows if the ramp is too short for that.
+*/
+static void st_ramp_begin(float v0, float v1, float mm, float mm_start) {
+    mm = MAX(mm, 0.0);
+
+    prep.ramp.active    = true;
+    prep.ramp.v0        = v0;
+    prep.ramp.v1        = v1;
+    prep.ramp.mm_total  = mm;
+    prep.ramp.mm_start  = mm_start;
+    prep.ramp.time      = 0.0;
+    prep.ramp.duration  = (v0 + v1 > 0.0) ? 2.0 * mm / (v0 + v1) : 0.0;
+    prep.ramp.jerk      = 0.0;
+    prep.ramp.jerk_time = 0.0;
+    prep.ramp.accel     = 0.0;
+
+    float dv = fabs(v1 - v0);
+    float T  = prep.ramp.duration;
+    if (dv == 0.0 || T == 0.0) {
+        return;  // Constant speed
+    }
+    float sign = (v1 > v0) ? 1.0 : -1.0;
+    if (prep.jerk > 0.0) {
+        float disc = T * T - 4.0 * dv / prep.jerk;
+        float jerk = prep.jerk;
+        if (disc > 0.0) {
+            prep.ramp.jerk_time = 0.5 * (T - sqrt(disc));
+        } else {
+            prep.ramp.jerk_time = 0.5 * T;
+            jerk                = 4.0 * dv / (T * T);  // Triangle, steeper than the limit
+        }
+        prep.ramp.jerk  = sign * jerk;
+        prep.ramp.accel = prep.ramp.jerk * prep.ramp.jerk_time;
+    } else {
+        prep.ramp.accel = sign * dv / T;
+    }
+}
+
+// Distance from the start of the ramp and speed at time t into it
+static float st_ramp_distance(float t, float* speed) {
+    float v0 = prep.ramp.v0;
+    float j  = prep.ramp.jerk;
+    float tj = prep.ramp.jerk_time;
+    if (t >= prep.ramp.duration) {
+        *speed = prep.ramp.v1;
+        return prep.ramp.mm_total;
+    }
+    if (t < tj) {
+        *speed = v0 + 0.5 * j * t * t;
+        return t * (v0 + j * t * t / 6.0);
+    }
+    float u = prep.ramp.duration - t;
+    if (u < tj) {  // The last phase mirrors the first one
+        *speed = prep.ramp.v1 - 0.5 * j * u * u;
+        return prep.ramp.mm_total - u * (prep.ramp.v1 - j * u * u / 6.0);
+    }
+    float a  = prep.ramp.accel;
+    float vj = v0 + 0.5 * j * tj * tj;
+    u        = t - tj;
+    *speed   = vj + a * u;
+    return tj * (v0 + j * tj * tj / 6.0) + u * (vj + 0.5 * a * u);
+}
+
+// Advances the ramp by time_var. Returns true at the end of the ramp, with time_var cut to the
+// time that was left in it, for the caller to handle the ramp junction.
+static bool st_ramp_advance(float& time_var, float& mm_remaining) {
+    float t = prep.ramp.time + time_var;
+    if (t >= prep.ramp.duration) {
+        time_var         = prep.ramp.duration - prep.ramp.time;
+        prep.ramp.active = false;
+        return true;
+    }
+    prep.ramp.time = t;
+    mm_remaining   = prep.ramp.mm_start - st_ramp_distance(t, &prep.current_speed);
+    return false;
+}
+
+#ifdef ASYNC_AXIS
+// Takes the async axis steps for the dt minutes a prepped segment runs, at most max_steps.
+static void st_prep_async_steps(segment_t* segment, float dt, uint32_t max_steps) {
+    int32_t steps        = async_prep_steps(dt, max_steps, sys.step_control.executeHold);
+    segment->async_steps = labs(steps);
+    segment->async_dir   = steps < 0 ? bit(ASYNC_AXIS) : 0;
+}
+
+// Preps a DT_SEGMENT long segment that only steps the async axis, for while the planner is
+// empty. Returns false if there is nothing to step. A hold ends once the axis is at rest.
+static bool st_prep_async_segment() {
+    if (sys.step_control.executeSysMotion || !async_busy()) {
+        return false;
+    }
+    if (sys.step_control.executeHold && async_prep_stopped()) {
+        sys.step_control.endMotion = true;
+        return false;
+    }
+    segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+    // Enough ticks for the steps, and short enough ones for the 16 bit isrPeriod
+    uint32_t segment_ticks  = fStepperTimer * 60.0 * DT_SEGMENT;
+    prep_segment->n_step    = (segment_ticks + 0xfffe) / 0xffff;
+    prep_segment->isrPeriod = segment_ticks / prep_segment->n_step;
+    st_prep_async_steps(prep_segment, DT_SEGMENT, 0xffff);
+    if (prep_segment->async_steps > prep_segment->n_step) {
+        prep_segment->n_step    = prep_segment->async_steps;
+        prep_segment->isrPeriod = segment_ticks / prep_segment->n_step;
+    }
+    prep_segment->st_block_index = st_block_count(segment_buffer_size) - 1;  // All zero, moves no other axis
+    prep_segment->amass_level    = 0;
+    prep_segment->spindle_rpm    = prep.current_spindle_rpm;
+#    ifdef STEP_PATTERN_PRERENDER
+    uint8_t* pattern          = segment_pattern[segment_buffer_head];
+    prep_segment->prerendered = prep_segment->n_step <= STEP_PATTERN_MAX_TICKS;
+    memset(prep_segment->counter, 0, sizeof(prep_segment->counter));
+    if (prep_segment->prerendered) {
+        memset(pattern, 0, prep_segment->n_step);
+        st_prep_render_async(prep_segment, pattern);
+    }
+#    endif
+    segment_buffer_head = segment_next_head;
+    if (++segment_next_head == segment_buffer_size) {
+        segment_next_head = 0;
+    }
+    return true;
+}
+#endif
+
+// Picks the AMASS level and the ISR period of a prepped segment that takes inv_rate minutes per
+// step, adds the async axis steps and the step pattern, and hands the segment to the stepper ISR.
+static void st_prep_queue_segment(segment_t* prep_segment, float inv_rate) {
+    // Compute CPU cycles per step for the prepped segment.
+    // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
+    // timerTicks/sec * 60 sec/minute * minutes = timerTicks
+    uint32_t timerTicks = ceil((fStepperTimer * 60) * inv_rate);  // (timerTicks/step)
+    int      level;
+
+    // Compute step timing and multi-axis smoothing level.
+    for (level = 0; level < maxAmassLevel; level++) {
+        if (timerTicks < amassThreshold) {
+            break;
+        }
+        timerTicks >>= 1;
+    }
+#ifdef ASYNC_AXIS
+    // The ISR steps the async axis at most once per tick. Go up further levels for more ticks if
+    // it needs them, as far as the block scaling and the 16 bit tick count allow.
+    float    segment_time = ((uint32_t)prep_segment->n_step << level) * (float)MIN(timerTicks, 0xffff) / (fStepperTimer * 60.0);
+    int      max_level    = level;
+    while (max_level < maxBlockLevel && ((uint32_t)prep_segment->n_step << (max_level + 1)) <= 0xffff) {
+        max_level++;
+    }
+    st_prep_async_steps(prep_segment, segment_time, (uint32_t)prep_segment->n_step << max_level);
+    while (((uint32_t)prep_segment->n_step << level) < prep_segment->async_steps) {
+        level++;
+        timerTicks >>= 1;
+    }
+#endif
+    prep_segment->amass_level = level;
+    prep_segment->n_step <<= level;
+    // isrPeriod is stored as 16 bits, so limit timerTicks to the
+    // largest value that will fit in a uint16_t.
+    prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
+#ifdef STEP_PATTERN_PRERENDER
+    st_prep_render_segment(prep_segment, segment_pattern[segment_buffer_head]);
+#endif
+
+    // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
+    segment_buffer_head = segment_next_head;
+    if (++segment_next_head == segment_buffer_size) {
+        segment_next_head = 0;
+    }
+}
+
+// System motions are never shaped. They only run once the shaped motion has stopped.
+static bool st_shaping() {
+    return st_shaper.active && !sys.step_control.executeSysMotion;
+}
+
+static void st_shaper_reset() {
+    double origin[SHAPER_MAX_AXES] = {};
+    memset(&st_shaper, 0, sizeof(st_shaper));
+    st_shaper.stopped = true;
+    st_shaper.history.reset(0.0, origin, 0.0);
+}
+
+// True once the shaped motion has caught up with the stopped profile, or if nothing is shaped
+static bool st_shaper_drained() {
+    return !st_shaper.active || (st_shaper.stopped && st_shaper.time >= st_shaper.history.newest_time() + st_shaper.duration);
+}
+
+// Starts shaping, or not, for a motion that starts from rest once the last shaped one has stopped.
+// The impulses are rebuilt from the settings, so shaper changes apply from the next motion on.
+static void st_shaper_start(bool shape) {
+    auto n_axis        = number_axis->get();
+    st_shaper.active   = false;
+    st_shaper.duration = 0.0;
+    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        ShaperImpulses& impulses = st_shaper.axis[axis];
+        if (shape && axis < n_axis) {
+            shaper_impulses(static_cast<ShaperType>(axis_settings[axis]->shaper_type->get()),
+                            axis_settings[axis]->shaper_frequency->get(),
+                            axis_settings[axis]->shaper_damping->get(),
+                            impulses);
+        } else {
+            shaper_impulses(ShaperType::None, 0.0, 0.0, impulses);
+        }
+        st_shaper.active |= impulses.n > 1;
+        st_shaper.duration = MAX(st_shaper.duration, impulses.time[impulses.n - 1]);
+    }
+    // Space the samples so the history spans the shaper and a couple of segments
+    double position[SHAPER_MAX_AXES];
+    memcpy(position, st_shaper.history.newest_position(), sizeof(position));
+    st_shaper.history.reset(0.0, position, 2.0 * (st_shaper.duration + 2.0 * DT_SEGMENT) / (SHAPER_HISTORY_SIZE - 4));
+    st_shaper.time     = 0.0;
+    st_shaper.dt_carry = 0.0;
+    st_shaper.speed    = 0.0;
+}
+
+// Adds the end of a piece of the unshaped profile, dt minutes long and ending mm_remaining from
+// the end of the prepped block, to the history.
+static void st_shaper_log(float dt, float mm_remaining) {
+    double position[SHAPER_MAX_AXES];
+    double time = st_shaper.history.newest_time();
+    memcpy(position, st_shaper.history.newest_position(), sizeof(position));
+    if (st_shaper.stopped && st_shaper.time > time) {
+        // The profile stood still while the shaped motion caught up. Carry on from there.
+        time = st_shaper.time;
+        st_shaper.history.push(time, position);
+    }
+    double done = 1.0 - (double)mm_remaining * prep.step_per_mm / pl_block->step_event_count;
+    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        double steps   = pl_block->steps[axis] * done;
+        position[axis] = st_shaper.block_start[axis] + ((pl_block->direction_bits & bit(axis)) ? -steps : steps);
+    }
+    st_shaper.history.push(time + dt, position);
+}
+
+// Cuts the next shaped segment, DT_SEGMENT long, once the unshaped profile has run far enough ahead
+// of it, or whatever is left once the profile has stopped. Returns false if the profile must be
+// run further first, or if the shaped motion has caught up with the stopped profile.
+static bool st_shaper_prep_segment() {
+    double t_end = st_shaper.time + DT_SEGMENT;
+    if (st_shaper.stopped) {
+        t_end = MIN(t_end, st_shaper.history.newest_time() + st_shaper.duration);
+        if (t_end <= st_shaper.time) {
+            st_shaper.speed = 0.0;
+            return false;
+        }
+    } else if (st_shaper.history.newest_time() < t_end) {
+        return false;
+    }
+
+    auto     n_axis = number_axis->get();
+    int32_t  steps[MAX_N_AXIS];
+    uint32_t n_step = 0;
+    float    mm_sqr = 0.0;
+    for (uint8_t axis = 0; axis < n_axis; axis++) {
+        int32_t target           = lround(st_shaper.history.shaped_position(axis, t_end, st_shaper.axis[axis]));
+        steps[axis]              = target - st_shaper.position[axis];
+        st_shaper.position[axis] = target;
+        n_step                   = MAX(n_step, (uint32_t)labs(steps[axis]));
+        float mm                 = steps[axis] / axis_settings[axis]->steps_per_mm->get();
+        mm_sqr += mm * mm;
+    }
+    float dt       = (t_end - st_shaper.time) + st_shaper.dt_carry;
+    st_shaper.time = t_end;
+    st_shaper.history.discard_before(t_end - st_shaper.duration);
+    if (n_step == 0) {
+        st_shaper.dt_carry = dt;  // Too slow for a step yet. The next segment takes the time.
+        st_shaper.speed    = 0.0;
+        return true;
+    }
+    st_shaper.dt_carry = 0.0;
+    st_shaper.speed    = sqrt(mm_sqr) / dt;
+
+    // The segment is a Bresenham line of its own
+    prep.st_block_index           = st_next_block_index(prep.st_block_index);
+    st_prep_block                 = &st_block_buffer[prep.st_block_index];
+    st_prep_block->direction_bits = 0;
+    for (uint8_t axis = 0; axis < n_axis; axis++) {
+        if (steps[axis] < 0) {
+            st_prep_block->direction_bits |= bit(axis);
+        }
+        st_prep_block->steps[axis] = labs(steps[axis]) << maxBlockLevel;
+    }
+    st_prep_block->step_event_count     = n_step << maxBlockLevel;
+    st_prep_block->is_pwm_rate_adjusted = prep.is_pwm_rate_adjusted;
+#ifdef STEP_PATTERN_PRERENDER
+    for (uint8_t axis = 0; axis < n_axis; axis++) {
+        prep.counter[axis] = st_prep_block->step_event_count >> 1;
+    }
+#endif
+
+    segment_t* prep_segment      = &segment_buffer[segment_buffer_head];
+    prep_segment->st_block_index = prep.st_block_index;
+    prep_segment->n_step         = n_step;
+    prep_segment->spindle_rpm    = prep.current_spindle_rpm;
+    st_prep_queue_segment(prep_segment, dt / n_step);
+    return true;
+}
+
+/* Prepares step segment buffer. Called by the segment prep task and from the main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
    by the stepper algorithm and the velocity profiles generated by the planner. The stepper
@@ -534,14 +1267,38 @@ static uint8_t st_next_block_index(uint8_t block_index) {
    longer than the time it takes the stepper algorithm to empty it before refilling it.
    Currently, the segment buffer conservatively holds roughly up to 40-50 msec of steps.
    NOTE: Computation units are in steps, millimeters, and minutes.
+   NOTE: Must be called with the prep lock held. See st_prep_buffer().
 */
-void st_prep_buffer() {
+static void st_prep_buffer_locked() {
     // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
     if (sys.step_control.endMotion) {
+#ifdef ASYNC_AXIS
+        async_prep_halt();  // Stopped with the segment buffer. Resume from rest.
+#endif
         return;
     }
 
     while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+        bool shaping = st_shaping();
+        if (shaping) {
+            if (st_shaper_prep_segment()) {
+                continue;
+            }
+            if (st_shaper.held) {
+                if (sys.step_control.executeHold) {
+                    // The shaped motion has stopped at the end of the feed hold too.
+                    sys.step_control.endMotion = true;
+#ifdef PARKING_ENABLE
+                    if (!(prep.recalculate_flag.parking)) {
+                        prep.recalculate_flag.holdPartialBlock = 1;
+                    }
+#endif
+                    return;
+                }
+                st_shaper.held = false;  // Resumed
+            }
+        }
+
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -552,9 +1309,26 @@ void st_prep_buffer() {
             }
 
             if (pl_block == NULL) {
+#ifdef ASYNC_AXIS
+                if (st_prep_async_segment()) {
+                    continue;  // Keep the async axis going while the planner is empty.
+                }
+#endif
                 return;  // No planner blocks. Exit.
             }
 
+            if (!prep.recalculate_flag.recalculate && !sys.step_control.executeSysMotion && st_shaper.stopped) {
+                // A motion starts from rest. One that bypasses the shaper waits for the shaped one before it.
+                bool shape = !pl_block->motion.noShaping;
+                if (st_shaper_drained()) {
+                    st_shaper_start(shape);
+                } else if (!shape) {
+                    pl_block = NULL;
+                    continue;
+                }
+                shaping = st_shaper.active;
+            }
+
             // Check if we need to only recompute the velocity profile or load a new block.
             if (prep.recalculate_flag.recalculate) {
 #ifdef PARKING_ENABLE
@@ -567,23 +1341,31 @@ void st_prep_buffer() {
                 prep.recalculate_flag = {};
 #endif
             } else {
-                // Load the Bresenham stepping data for the block.
-                prep.st_block_index = st_next_block_index(prep.st_block_index);
-                // Prepare and copy Bresenham algorithm segment data from the new planner block, so that
-                // when the segment buffer completes the planner block, it may be discarded when the
-                // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
-                st_prep_block                 = &st_block_buffer[prep.st_block_index];
-                st_prep_block->direction_bits = pl_block->direction_bits;
-                uint8_t idx;
-                auto    n_axis = number_axis->get();
-
-                // Bit-shift multiply all Bresenham data by the max AMASS level so that
-                // we never divide beyond the original data anywhere in the algorithm.
-                // If the original data is divided, we can lose a step from integer roundoff.
-                for (idx = 0; idx < n_axis; idx++) {
-                    st_prep_block->steps[idx] = pl_block->steps[idx] << maxAmassLevel;
+                if (!shaping) {  // Shaped segments carry their own Bresenham data
+                    // Load the Bresenham stepping data for the block.
+                    prep.st_block_index = st_next_block_index(prep.st_block_index);
+                    // Prepare and copy Bresenham algorithm segment data from the new planner block, so that
+                    // when the segment buffer completes the planner block, it may be discarded when the
+                    // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
+                    st_prep_block                 = &st_block_buffer[prep.st_block_index];
+                    st_prep_block->direction_bits = pl_block->direction_bits;
+                    uint8_t idx;
+                    auto    n_axis = number_axis->get();
+
+                    // Bit-shift multiply all Bresenham data by the max AMASS level so that
+                    // we never divide beyond the original data anywhere in the algorithm.
+                    // If the original data is divided, we can lose a step from integer roundoff.
+                    for (idx = 0; idx < n_axis; idx++) {
+                        st_prep_block->steps[idx] = pl_block->steps[idx] << maxBlockLevel;
+                    }
+                    st_prep_block->step_event_count = pl_block->step_event_count << maxBlockLevel;
+#ifdef STEP_PATTERN_PRERENDER
+                    // Initialize Bresenham line and distance counters
+                    for (idx = 0; idx < n_axis; idx++) {
+                        prep.counter[idx] = st_prep_block->step_event_count >> 1;
+                    }
+#endif
                 }
-                st_prep_block->step_event_count = pl_block->step_event_count << maxAmassLevel;
 
                 // Initialize segment buffer data for generating the segments.
                 prep.steps_remaining  = (float)pl_block->step_event_count;
@@ -599,15 +1381,18 @@ void st_prep_buffer() {
                     prep.current_speed = sqrt(pl_block->entry_speed_sqr);
                 }
 
-                st_prep_block->is_pwm_rate_adjusted = false;  // set default value
+                prep.is_pwm_rate_adjusted = false;  // set default value
                 // prep.inv_rate is only used if is_pwm_rate_adjusted is true
                 if (spindle->inLaserMode()) {  //
                     if (pl_block->spindle == SpindleState::Ccw) {
                         // Pre-compute inverse programmed rate to speed up PWM updating per step segment.
-                        prep.inv_rate                       = 1.0 / pl_block->programmed_rate;
-                        st_prep_block->is_pwm_rate_adjusted = true;
+                        prep.inv_rate             = 1.0 / pl_block->programmed_rate;
+                        prep.is_pwm_rate_adjusted = true;
                     }
                 }
+                if (!shaping) {
+                    st_prep_block->is_pwm_rate_adjusted = prep.is_pwm_rate_adjusted;
+                }
             }
             /* ---------------------------------------------------------------------------------
              Compute the velocity profile of a new planner block based on its entry and exit
@@ -617,6 +1402,10 @@ void st_prep_buffer() {
             */
             prep.mm_complete  = 0.0;  // Default velocity profile complete at 0.0mm from end of block.
             float inv_2_accel = 0.5 / pl_block->acceleration;
+            // Feed holds always decelerate at constant acceleration. A recomputed profile starts new
+            // ramps from the current speed.
+            prep.jerk        = sys.step_control.executeHold ? 0.0 : pl_block->jerk;
+            prep.ramp.active = false;
             if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
                 // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
                 // the planner block profile, enforcing a deceleration to zero speed.
@@ -697,12 +1486,6 @@ void st_prep_buffer() {
             sys.step_control.updateSpindleRpm = true;  // Force update whenever updating block.
         }
 
-        // Initialize new segment
-        segment_t* prep_segment = &segment_buffer[segment_buffer_head];
-
-        // Set new segment to point to the current segment data block.
-        prep_segment->st_block_index = prep.st_block_index;
-
         /*------------------------------------------------------------------------------------
             Compute the average velocity of this new segment by determining the total distance
           traveled over the segment time DT_SEGMENT. The following code first attempts to create
@@ -747,21 +1530,32 @@ void st_prep_buffer() {
                     break;
                 case RAMP_ACCEL:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
-                    speed_var = pl_block->acceleration * time_var;
-                    mm_remaining -= time_var * (prep.current_speed + 0.5 * speed_var);
-                    if (mm_remaining < prep.accelerate_until) {  // End of acceleration ramp.
-                        // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    if (prep.jerk > 0.0) {
+                        if (!prep.ramp.active) {
+                            st_ramp_begin(prep.current_speed, prep.maximum_speed, mm_remaining - prep.accelerate_until, mm_remaining);
+                        }
+                        if (!st_ramp_advance(time_var, mm_remaining)) {
+                            break;  // Acceleration only.
+                        }
                         mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var     = 2.0 * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
-                        if (mm_remaining == prep.decelerate_after) {
-                            prep.ramp_type = RAMP_DECEL;
-                        } else {
-                            prep.ramp_type = RAMP_CRUISE;
+                    } else {
+                        speed_var = pl_block->acceleration * time_var;
+                        mm_remaining -= time_var * (prep.current_speed + 0.5 * speed_var);
+                        if (mm_remaining >= prep.accelerate_until) {  // Acceleration only.
+                            prep.current_speed += speed_var;
+                            break;
                         }
-                        prep.current_speed = prep.maximum_speed;
-                    } else {  // Acceleration only.
-                        prep.current_speed += speed_var;
+                        mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
+                        time_var     = 2.0 * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                     }
+                    // End of acceleration ramp.
+                    // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    if (mm_remaining == prep.decelerate_after) {
+                        prep.ramp_type = RAMP_DECEL;
+                    } else {
+                        prep.ramp_type = RAMP_CRUISE;
+                    }
+                    prep.current_speed = prep.maximum_speed;
                     break;
                 case RAMP_CRUISE:
                     // NOTE: mm_var used to retain the last mm_remaining for incomplete segment time_var calculations.
@@ -778,19 +1572,28 @@ void st_prep_buffer() {
                     }
                     break;
                 default:  // case RAMP_DECEL:
-                    // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
-                    speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
-                    if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
-                        // Compute distance from end of segment to end of block.
-                        mm_var = mm_remaining - time_var * (prep.current_speed - 0.5 * speed_var);  // (mm)
-                        if (mm_var > prep.mm_complete) {                                            // Typical case. In deceleration ramp.
-                            mm_remaining = mm_var;
-                            prep.current_speed -= speed_var;
-                            break;  // Segment complete. Exit switch-case statement. Continue do-while loop.
+                    if (prep.jerk > 0.0) {
+                        if (!prep.ramp.active) {
+                            st_ramp_begin(prep.current_speed, prep.exit_speed, mm_remaining - prep.mm_complete, mm_remaining);
+                        }
+                        if (!st_ramp_advance(time_var, mm_remaining)) {
+                            break;  // In deceleration ramp.
+                        }
+                    } else {
+                        // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
+                        speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
+                        if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
+                            // Compute distance from end of segment to end of block.
+                            mm_var = mm_remaining - time_var * (prep.current_speed - 0.5 * speed_var);  // (mm)
+                            if (mm_var > prep.mm_complete) {  // Typical case. In deceleration ramp.
+                                mm_remaining = mm_var;
+                                prep.current_speed -= speed_var;
+                                break;  // Segment complete. Exit switch-case statement. Continue do-while loop.
+                            }
                         }
+                        time_var = 2.0 * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
                     }
                     // Otherwise, at end of block or end of forced-deceleration.
-                    time_var           = 2.0 * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
                     mm_remaining       = prep.mm_complete;
                     prep.current_speed = prep.exit_speed;
             }
@@ -813,11 +1616,11 @@ void st_prep_buffer() {
         /* -----------------------------------------------------------------------------------
           Compute spindle speed PWM output for step segment
         */
-        if (st_prep_block->is_pwm_rate_adjusted || sys.step_control.updateSpindleRpm) {
+        if (prep.is_pwm_rate_adjusted || sys.step_control.updateSpindleRpm) {
             if (pl_block->spindle != SpindleState::Disable) {
                 float rpm = pl_block->spindle_speed;
                 // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.
-                if (st_prep_block->is_pwm_rate_adjusted) {
+                if (prep.is_pwm_rate_adjusted) {
                     rpm *= (prep.current_speed * prep.inv_rate);
                     //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "RPM %.2f", rpm);
                     //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Rates CV %.2f IV %.2f RPM %.2f", prep.current_speed, prep.inv_rate, rpm);
@@ -832,7 +1635,35 @@ void st_prep_buffer() {
             }
             sys.step_control.updateSpindleRpm = false;
         }
-        prep_segment->spindle_rpm = prep.current_spindle_rpm;  // Reload segment PWM value
+
+        bool stopped = mm_remaining == prep.mm_complete && prep.current_speed == 0.0;
+        if (shaping) {
+            // The shaped segments are cut from the history of the profile
+            st_shaper_log(dt, mm_remaining);
+            st_shaper.stopped     = stopped;
+            pl_block->millimeters = mm_remaining;
+            if (mm_remaining == prep.mm_complete) {
+                if (mm_remaining > 0.0) {
+                    st_shaper.held = true;  // End of a feed hold. Done once the shaped motion stops too.
+                } else {                    // End of planner block
+                    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+                        int32_t steps = pl_block->steps[axis];
+                        st_shaper.block_start[axis] += (pl_block->direction_bits & bit(axis)) ? -steps : steps;
+                    }
+                    pl_block = NULL;
+                    plan_discard_current_block();
+                }
+            }
+            continue;
+        }
+        st_shaper.stopped = stopped;
+
+        // Initialize new segment
+        segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+
+        // Set new segment to point to the current segment data block.
+        prep_segment->st_block_index = prep.st_block_index;
+        prep_segment->spindle_rpm    = prep.current_spindle_rpm;  // Reload segment PWM value
 
         /* -----------------------------------------------------------------------------------
            Compute segment step rate, steps to execute, and apply necessary rate corrections.
@@ -855,6 +1686,7 @@ void st_prep_buffer() {
                 // Less than one step to decelerate to zero speed, but already very close. AMASS
                 // requires full steps to execute. So, just bail.
                 sys.step_control.endMotion = true;
+                st_shaper.stopped          = true;
 #ifdef PARKING_ENABLE
                 if (!(prep.recalculate_flag.parking)) {
                     prep.recalculate_flag.holdPartialBlock = 1;
@@ -876,31 +1708,8 @@ void st_prep_buffer() {
         dt += prep.dt_remainder;  // Apply previous segment partial step execute time
         // dt is in minutes so inv_rate is in minutes
         float inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
+        st_prep_queue_segment(prep_segment, inv_rate);
 
-        // Compute CPU cycles per step for the prepped segment.
-        // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
-        // timerTicks/sec * 60 sec/minute * minutes = timerTicks
-        uint32_t timerTicks = ceil((fStepperTimer * 60) * inv_rate);  // (timerTicks/step)
-        int      level;
-
-        // Compute step timing and multi-axis smoothing level.
-        for (level = 0; level < maxAmassLevel; level++) {
-            if (timerTicks < amassThreshold) {
-                break;
-            }
-            timerTicks >>= 1;
-        }
-        prep_segment->amass_level = level;
-        prep_segment->n_step <<= level;
-        // isrPeriod is stored as 16 bits, so limit timerTicks to the
-        // largest value that will fit in a uint16_t.
-        prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
-
-        // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        segment_buffer_head = segment_next_head;
-        if (++segment_next_head == SEGMENT_BUFFER_SIZE) {
-            segment_next_head = 0;
-        }
         // Update the appropriate planner and segment data.
         pl_block->millimeters = mm_remaining;
         prep.steps_remaining  = n_steps_remaining;
@@ -932,6 +1741,12 @@ void st_prep_buffer() {
     }
 }
 
+void st_prep_buffer() {
+    st_prep_lock();
+    st_prep_buffer_locked();
+    st_prep_unlock();
+}
+
 // Called by realtime status reporting to fetch the current speed being executed. This value
 // however is not exactly the current speed, but the speed computed in the last step segment
 // in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
@@ -943,7 +1758,7 @@ float st_get_realtime_rate() {
         case State::Hold:
         case State::Jog:
         case State::SafetyDoor:
-            return prep.current_speed;
+            return st_shaping() ? st_shaper.speed : prep.current_speed;
         default:
             return 0.0f;
     }
@@ -959,7 +1774,7 @@ void IRAM_ATTR Stepper_Timer_WritePeriod(uint16_t timerTicks) {
         i2s_out_set_pulse_period(((uint32_t)timerTicks) / ticksPerMicrosecond);
 #endif
     } else {
-        timer_set_alarm_value(STEP_TIMER_GROUP, STEP_TIMER_INDEX, (uint64_t)timerTicks);
+        timer_group_set_alarm_value_in_isr(STEP_TIMER_GROUP, STEP_TIMER_INDEX, (uint64_t)timerTicks);
     }
 }
 
@@ -974,7 +1789,32 @@ void IRAM_ATTR Stepper_Timer_Init() {
     timer_init(STEP_TIMER_GROUP, STEP_TIMER_INDEX, &config);
     timer_set_counter_value(STEP_TIMER_GROUP, STEP_TIMER_INDEX, 0x00000000ULL);
     timer_enable_intr(STEP_TIMER_GROUP, STEP_TIMER_INDEX);
-    timer_isr_register(STEP_TIMER_GROUP, STEP_TIMER_INDEX, onStepperDriverTimer, NULL, 0, NULL);
+    // The interrupt itself is attached by st_isr_attach(), once the motors and the spindle exist
+}
+
+void st_isr_attach() {
+    if (spindle == NULL) {
+        return;  // Not set up yet. Spindles::Spindle::select() attaches it.
+    }
+    // GCC extension: the function a virtual method resolves to for this object
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+    st_spindle_set_rpm = (spindle_set_rpm_t)(spindle->*(&Spindles::Spindle::set_rpm));
+#pragma GCC diagnostic pop
+
+    bool iram = motors_isr_in_iram() && esp_ptr_in_iram((const void*)st_spindle_set_rpm);
+    if (st_timer_intr != NULL) {
+        if (iram == st_isr_in_iram) {
+            return;
+        }
+        esp_intr_free(st_timer_intr);
+        st_timer_intr = NULL;
+    }
+    st_isr_in_iram = iram;
+    timer_isr_register(STEP_TIMER_GROUP, STEP_TIMER_INDEX, onStepperDriverTimer, NULL, iram ? ESP_INTR_FLAG_IRAM : 0, &st_timer_intr);
+    if (!iram) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Stepper ISR waits for flash: a motor or the spindle is driven from flash");
+    }
 }
 
 void IRAM_ATTR Stepper_Timer_Start() {
@@ -1007,7 +1847,8 @@ void IRAM_ATTR Stepper_Timer_Stop() {
         i2s_out_set_passthrough();
 #endif
     } else {
-        timer_pause(STEP_TIMER_GROUP, STEP_TIMER_INDEX);
+        // Also called from the ISR via st_go_idle(), so use the ISR-safe call
+        timer_group_set_counter_enable_in_isr(STEP_TIMER_GROUP, STEP_TIMER_INDEX, TIMER_PAUSE);
     }
 }
 
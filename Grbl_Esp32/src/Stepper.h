@@ -24,12 +24,36 @@
   along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+// Default of the $Stepper/Segments setting, which sizes the segment buffer at boot
 #ifndef SEGMENT_BUFFER_SIZE
 #    define SEGMENT_BUFFER_SIZE 6
 #endif
 
+#ifndef MAX_SEGMENT_BUFFER_SIZE
+#    define MAX_SEGMENT_BUFFER_SIZE 32
+#endif
+
+#ifndef STEP_PATTERN_MAX_TICKS
+#    define STEP_PATTERN_MAX_TICKS 256
+#endif
+
+// Segment prep task. It runs on the core opposite WiFi, above the main loop and below the
+// I2S render task, so a busy parser cannot starve the segment buffer and the prep cannot
+// delay the step pulses. It is woken each time the stepper frees a segment or the planner
+// adds a block, and polls every ST_PREP_TASK_PERIOD_MS in case a wakeup is missed.
+#ifndef ST_PREP_TASK_PRIORITY
+#    define ST_PREP_TASK_PRIORITY (configMAX_PRIORITIES - 3)
+#endif
+#ifndef ST_PREP_TASK_CORE
+#    define ST_PREP_TASK_CORE SUPPORT_TASK_CORE
+#endif
+#ifndef ST_PREP_TASK_PERIOD_MS
+#    define ST_PREP_TASK_PERIOD_MS 10
+#endif
+
 #include "Grbl.h"
 #include "Config.h"
+#include "InputShaper.h"
 
 // Some useful constants.
 const double DT_SEGMENT              = (1.0 / (ACCELERATION_TICKS_PER_SECOND * 60.0));  // min/segment
@@ -64,6 +88,16 @@ const int ticksPerMicrosecond = fStepperTimer / 1000000;
 const uint32_t amassThreshold = fStepperTimer / 8000;
 const int maxAmassLevel = 3;  // Each level increase doubles the threshold
 
+// Stepper blocks hold their step counts scaled up by 2^maxBlockLevel, so a segment can run at any
+// AMASS level up to it. With ASYNC_AXIS, a segment goes past maxAmassLevel when the async axis
+// needs more ISR ticks than the other axes, so it isn't held to their step rate. A planner block
+// must then stay under 2^21 steps.
+#ifdef ASYNC_AXIS
+const int maxBlockLevel = 10;
+#else
+const int maxBlockLevel = maxAmassLevel;
+#endif
+
 const timer_group_t STEP_TIMER_GROUP = TIMER_GROUP_0;
 const timer_idx_t   STEP_TIMER_INDEX = TIMER_0;
 
@@ -93,6 +127,64 @@ enum stepper_id_t {
 extern const char*  stepper_names[];
 extern stepper_id_t current_stepper;
 
+// Settings used by the stepper ISR and the motor and probe functions it calls, copied out of
+// the Setting objects so the ISR doesn't chase Setting pointers or run Setting code from flash.
+typedef struct {
+    uint8_t  n_axis;
+    uint32_t pulse_microseconds;
+    uint32_t direction_delay_microseconds;
+    uint32_t enable_delay_microseconds;
+    uint8_t  idle_lock_time;
+    bool     step_enable_invert;
+    bool     probe_invert;
+} stepper_config_t;
+extern stepper_config_t st_config;
+
+// A stepper timer ISR entered more than this long after its alarm is counted as late
+#ifndef ST_ISR_LATE_USEC
+#    define ST_ISR_LATE_USEC 2
+#endif
+
+// Stepper timer ISR timing, reported by $SJ and ESP420. Latency is measured from the timer
+// alarm to the ISR entry, in timer ticks, so it includes interrupt masking and flash cache
+// stalls. Execution time is measured with CCOUNT from ISR entry to exit, in CPU cycles.
+// In ST_I2S_STREAM there is no stepper timer ISR. The pulse callback runs from the I2S render
+// task ahead of the DMA, so only its execution time is recorded, and the counterpart of a late
+// entry is a DMA underrun, counted by the I2S driver.
+// Histogram bin n counts values in [2^n, 2^(n+1)), the last bin everything above.
+const int ST_ISR_HIST_BINS = 16;
+
+typedef struct {
+    uint32_t ticks;        // ISR entries that ran stepper_pulse_func()
+    uint32_t busy;         // ISR entries that found stepper_pulse_func() still running
+    uint32_t late;         // Entries later than ST_ISR_LATE_USEC
+    uint32_t latency_min;  // Timer ticks
+    uint32_t latency_max;
+    uint64_t latency_sum;
+    uint32_t exec_min;  // CPU cycles
+    uint32_t exec_max;
+    uint64_t exec_sum;
+    uint32_t latency_hist[ST_ISR_HIST_BINS];
+    uint32_t exec_hist[ST_ISR_HIST_BINS];
+    uint32_t underrun_base;  // i2s_out_get_underruns() when the window started
+} st_isr_stats_t;
+extern st_isr_stats_t st_isr_stats;
+
+void st_isr_stats_reset();
+
+// DMA underruns in the window of stats, for ST_I2S_STREAM
+uint32_t st_isr_underruns(const st_isr_stats_t& stats);
+
+// Rebuilds st_config from the settings
+void st_read_settings();
+
+// Attaches the stepper timer interrupt, or re-attaches it when the spindle changes. Called by
+// Spindles::Spindle::select(), once the motors and the spindle are set up. The interrupt is
+// allocated with ESP_INTR_FLAG_IRAM, so it keeps stepping while the flash cache is off, only if
+// every motor and spindle method it calls is in IRAM. Otherwise it waits out flash writes.
+void st_isr_attach();
+extern bool st_isr_in_iram;  // The stepper timer interrupt is allocated with ESP_INTR_FLAG_IRAM
+
 // -- Task handles for use in the notifications
 void IRAM_ATTR onSteppertimer();
 void IRAM_ATTR onStepperOffTimer();
@@ -104,7 +196,7 @@ void stepper_switch(stepper_id_t new_stepper);
 void st_wake_up();
 
 // Immediately disables steppers
-void st_go_idle();
+void IRAM_ATTR st_go_idle();
 
 // Reset the stepper subsystem variables
 void st_reset();
@@ -115,15 +207,28 @@ void st_parking_setup_buffer();
 // Restores the step segment buffer to the normal run state after a parking motion.
 void st_parking_restore_buffer();
 
-// Reloads step segment buffer. Called continuously by realtime execution system.
+// Reloads step segment buffer. Called by the segment prep task and the realtime execution system.
 void st_prep_buffer();
 
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 void st_update_plan_block_parameters();
 
+// Serializes the planner and the segment buffer between the segment prep task and the
+// main loop. Take it around any sequence that changes planner blocks, prep state or
+// sys.step_control and must look atomic to st_prep_buffer(). It is recursive.
+void st_prep_lock();
+void st_prep_unlock();
+
+// Wakes the segment prep task. Safe to call from the stepper ISR.
+void IRAM_ATTR st_prep_wake();
+
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+// Exact machine position in steps, including the steps of the executing segment that
+// have not been added to sys_position yet.
+void st_get_realtime_position(int32_t* position);
+
 // disable (or enable) steppers via STEPPERS_DISABLE_PIN
 bool get_stepper_disable();  // returns the state of the pin
 
@@ -0,0 +1,65 @@
+/*
+  Syringe.cpp - Volumetric units for a syringe pump axis
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+#ifdef SYRINGE_AXIS
+
+#    ifdef ENABLE_PIECEWISE_LINEAR_SYRINGE
+static const float syringe_cal_mm[] = SYRINGE_CALIBRATION_MM;
+static const float syringe_cal_ul[] = SYRINGE_CALIBRATION_UL;
+
+const int SYRINGE_CAL_POINTS = sizeof(syringe_cal_mm) / sizeof(syringe_cal_mm[0]);
+static_assert(SYRINGE_CAL_POINTS >= 2, "SYRINGE_CALIBRATION_MM needs at least two points");
+static_assert(sizeof(syringe_cal_ul) == sizeof(syringe_cal_mm), "SYRINGE_CALIBRATION_MM and _UL differ in length");
+
+// Interpolates y at x on the calibration line through (xs, ys). The first and last pieces
+// extend past the ends of the table.
+static float syringe_interpolate(const float* xs, const float* ys, float x) {
+    int piece = 0;
+    while (piece < SYRINGE_CAL_POINTS - 2 && x > xs[piece + 1]) {
+        piece++;
+    }
+    return ys[piece] + (x - xs[piece]) * (ys[piece + 1] - ys[piece]) / (xs[piece + 1] - xs[piece]);
+}
+
+float syringe_mm_to_ul(float mm) {
+    return syringe_interpolate(syringe_cal_mm, syringe_cal_ul, mm);
+}
+
+float syringe_ul_to_mm(float ul) {
+    return syringe_interpolate(syringe_cal_ul, syringe_cal_mm, ul);
+}
+#    else
+float syringe_mm_to_ul(float mm) {
+    return mm * syringe_ul_per_mm->get();
+}
+
+float syringe_ul_to_mm(float ul) {
+    return ul / syringe_ul_per_mm->get();
+}
+#    endif
+
+float syringe_capacity() {
+    if (axis_settings[SYRINGE_AXIS]->max_travel->get() <= 0.0) {
+        return 0.0;
+    }
+    return syringe_mm_to_ul(limitsMaxPosition(SYRINGE_AXIS)) - syringe_mm_to_ul(limitsMinPosition(SYRINGE_AXIS));
+}
+
+#endif
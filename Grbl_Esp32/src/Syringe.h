@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+  Syringe.h - Volumetric units for a syringe pump axis
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// With SYRINGE_AXIS defined in the machine file, the axis position maps to the volume drawn
+// into the syringe, in uL. The map is linear at $Syringe/UlPerMm, or piecewise linear with
+// ENABLE_PIECEWISE_LINEAR_SYRINGE (see Config.h). It is zero at machine position zero and grows
+// with the axis position.
+//
+// $Syringe/Volumetric=On makes the syringe axis word of G0/G1, jog and '@' lines a volume:
+//
+//   G1 A250 F300     Draw the syringe to 250 uL (G91: draw 250 uL more)
+//   @G1 A0 F600      Empty it at 600 uL/min, on the async queue
+//
+// Volumes are absolute in the syringe, so work offsets do not apply to them, and G10/G92
+// cannot set the syringe axis in volumetric mode. F stays a path rate in mm/min on G0/G1
+// lines, which can move other axes too; on '@' lines, which only move the syringe, it is
+// in uL/min.
+//
+// M440 Q<area> turns on Z-follow for a liquid of cross-section Q mm^2, up to Z_FOLLOW_MAX_AREA,
+// and M441 turns it off. Without Q, M440 takes the well cross-section of the active labware (M460, see Settings.h).
+// A G0/G1 that moves the syringe and has no Z word then also moves Z by the volume change
+// over the cross-section, down while aspirating and up while dispensing, so the tip tracks
+// the liquid surface within the same planner block. Program end turns Z-follow off.
+//
+// M450 Q<uL> [R<mm>] [P<mm/min>] starts a multi-dispense, M451 ends it. Every G0/G1 in between
+// is the travel to a well, and dispenses Q uL into it with a syringe stroke blended into the last
+// R mm of the travel (2 mm by default), at P mm/min (the travel feed rate by default). The lines
+// must not move the syringe themselves. Streamed one after the other, the wells run as one
+// continuous block stream: the planner slows down for the strokes and the turns between wells, but
+// does not stop at each well. With M480 deck travel on, G0 travel lifts over the deck on its way.
+// Q and the total of a visit set (M471) must fit in the syringe. Program end ends the multi-dispense.
+
+#include "Grbl.h"
+
+// Largest liquid cross-section M440 takes (mm^2)
+const float Z_FOLLOW_MAX_AREA = 100000.0;
+
+#ifdef SYRINGE_AXIS
+
+// Volume in the syringe (uL) at the machine position of the syringe axis (mm)
+float syringe_mm_to_ul(float mm);
+
+// Machine position of the syringe axis (mm) that holds a volume (uL)
+float syringe_ul_to_mm(float ul);
+
+// Volume the syringe takes over the whole axis travel (uL), or 0 with $<axis>/MaxTravel=0
+float syringe_capacity();
+
+#endif
@@ -25,6 +25,8 @@
 system_t               sys;
 int32_t                sys_position[MAX_N_AXIS];        // Real-time machine (aka home) position vector in steps.
 int32_t                sys_probe_position[MAX_N_AXIS];  // Last probe position in machine coordinates and steps.
+int64_t                sys_probe_time;                  // esp_timer time of the last probe trigger (usecs).
+uint32_t               sys_probe_lead;                  // I2S stream output lead at the last probe trigger (usecs).
 volatile Probe         sys_probe_state;                 // Probing state value.  Used to coordinate the probing cycle with stepper ISR.
 volatile ExecState     sys_rt_exec_state;  // Global realtime executor bitflag variable for state management. See EXEC bitmasks.
 volatile ExecAlarm     sys_rt_exec_alarm;  // Global realtime executor bitflag variable for setting various alarms.
@@ -187,7 +189,9 @@ void system_convert_array_steps_to_mpos(float* position, int32_t* steps) {
 }
 float* system_get_mpos() {
     static float position[MAX_N_AXIS];
-    system_convert_array_steps_to_mpos(position, sys_position);
+    int32_t      steps[MAX_N_AXIS];
+    st_get_realtime_position(steps);
+    system_convert_array_steps_to_mpos(position, steps);
     return position;
 };
 
@@ -372,4 +376,5 @@ void __attribute__((weak)) user_defined_macro(uint8_t index) {
     user_macro.toCharArray(line, 255, 0);
     strcat(line, "\r");
     WebUI::inputBuffer.push(line);
+    client_rx_notify();
 }
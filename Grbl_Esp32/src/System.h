@@ -129,6 +129,8 @@ union ControlPins {
 // NOTE: These position variables may need to be declared as volatiles, if problems arise.
 extern int32_t sys_position[MAX_N_AXIS];        // Real-time machine (aka home) position vector in steps.
 extern int32_t sys_probe_position[MAX_N_AXIS];  // Last probe position in machine coordinates and steps.
+extern int64_t sys_probe_time;                  // esp_timer time of the last probe trigger (usecs).
+extern uint32_t sys_probe_lead;                 // I2S stream output lead at the last probe trigger (usecs).
 
 extern volatile Probe         sys_probe_state;    // Probing state value.  Used to coordinate the probing cycle with stepper ISR.
 extern volatile ExecState     sys_rt_exec_state;  // Global realtime executor bitflag variable for state management. See EXEC bitmasks.
@@ -155,7 +157,6 @@ void isr_control_inputs();
 
 // Execute the startup script lines stored in non-volatile storage upon initialization
 void  system_execute_startup(char* line);
-Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level);
 Error system_execute_line(char* line, WebUI::ESPResponseStream*, WebUI::AuthenticationLevel);
 Error system_execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel);
 Error do_command_or_setting(const char* key, char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream*);
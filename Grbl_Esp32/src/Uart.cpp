@@ -11,7 +11,7 @@
 #include "soc/dport_reg.h"
 #include "soc/rtc.h"
 
-Uart::Uart(int uart_num) : _uart_num(uart_port_t(uart_num)), _pushback(-1) {}
+Uart::Uart(int uart_num) : _uart_num(uart_port_t(uart_num)), _pushback(-1), _events(NULL), _onReceive(NULL) {}
 
 void Uart::begin(unsigned long baudrate, Data dataBits, Stop stopBits, Parity parity) {
     //    uart_driver_delete(_uart_num);
@@ -26,7 +26,41 @@ void Uart::begin(unsigned long baudrate, Data dataBits, Stop stopBits, Parity pa
     if (uart_param_config(_uart_num, &conf) != ESP_OK) {
         return;
     };
-    uart_driver_install(_uart_num, 256, 0, 0, NULL, 0);
+    uart_driver_install(_uart_num, 256, 0, 16, &_events, 0);
+}
+
+void Uart::eventTask(void* pvParameters) {
+    Uart*        uart = static_cast<Uart*>(pvParameters);
+    uart_event_t event;
+    while (true) {
+        if (xQueueReceive(uart->_events, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        switch (event.type) {
+            case UART_DATA:
+            case UART_FIFO_OVF:     // The reader fell behind. Let it take what is there.
+            case UART_BUFFER_FULL:
+                uart->_onReceive();
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void Uart::onReceive(void (*callback)()) {
+    if (_onReceive || !_events) {
+        return;
+    }
+    _onReceive = callback;
+    xTaskCreatePinnedToCore(eventTask,          // task
+                            "uartEventTask",    // name for task
+                            2048,               // size of task stack
+                            this,               // parameters
+                            2,                  // priority
+                            NULL,               // task handle
+                            SUPPORT_TASK_CORE   // core
+    );
 }
 
 int Uart::available() {
@@ -4,8 +4,12 @@
 
 class Uart : public Stream {
 private:
-    uart_port_t _uart_num;
-    int         _pushback;
+    uart_port_t   _uart_num;
+    int           _pushback;
+    QueueHandle_t _events;
+    void (*_onReceive)();
+
+    static void eventTask(void* pvParameters);
 
 public:
     enum class Data : int {
@@ -44,6 +48,9 @@ public:
     size_t        write(const char* text);
     void          flush() { uart_flush(_uart_num); }
     bool          flushTxTimed(TickType_t ticks);
+
+    // Calls callback from a task of its own each time the driver receives data. Call after begin().
+    void onReceive(void (*callback)());
 };
 
 extern Uart Uart0;
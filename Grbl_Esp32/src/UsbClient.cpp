@@ -0,0 +1,244 @@
+/*
+  UsbClient.cpp - Native USB-CDC client of the ESP32-S3
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+#ifdef ENABLE_USB_CDC
+
+#    if !defined(CONFIG_IDF_TARGET_ESP32S3) || !ARDUINO_USB_MODE || ARDUINO_USB_CDC_ON_BOOT
+#        error "ENABLE_USB_CDC needs an ESP32-S3 built with USB Mode Hardware CDC and JTAG and USB CDC On Boot disabled"
+#    endif
+
+#    include <HWCDC.h>
+#    include <atomic>
+
+// How long a write waits for the host to make room before it drops the rest (ms). Keeps a host
+// that stops reading from stalling the writer.
+const uint32_t USB_CDC_TX_TIMEOUT_MS = 20;
+
+const uint32_t USB_BENCH_MAX_KBYTES = 4096;
+
+// The USB Serial/JTAG controller, which the core names USBSerial in this USB mode
+static HWCDC& usb_cdc = USBSerial;
+
+static std::atomic<bool> usb_greet;  // A host opened the port. Send it the welcome line.
+
+// The receive event runs in the event loop task and the reads in the client reader task, and the
+// reports in either the reader or the protocol loop, so this lock covers all of the below.
+static portMUX_TYPE usb_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t      usb_rx_event_us;  // Time of the oldest receive event not picked up yet
+
+// Latency from a receive event until the reader task takes the bytes, since the last report
+static uint32_t usb_latency_count;
+static int64_t  usb_latency_sum_us;
+static int64_t  usb_latency_max_us;
+
+// $UB=RX. The sink fields are only touched by the reader task while usb_sinking is set.
+static std::atomic<bool> usb_sinking;
+static uint32_t          usb_sink_bytes;
+static int64_t           usb_sink_start_us;
+static int64_t           usb_sink_end_us;
+
+// $UB=<kbytes>
+static std::atomic<bool> usb_bench_running;
+static uint32_t          usb_bench_bytes;
+static uint8_t           usb_bench_client;
+
+static void usb_cdc_event(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    switch (id) {
+        case ARDUINO_HW_CDC_CONNECTED_EVENT:
+            usb_greet = true;
+            client_rx_notify();
+            break;
+        case ARDUINO_HW_CDC_RX_EVENT:
+            portENTER_CRITICAL(&usb_stats_mux);
+            if (usb_rx_event_us == 0) {
+                usb_rx_event_us = esp_timer_get_time();
+            }
+            portEXIT_CRITICAL(&usb_stats_mux);
+            client_rx_notify();
+            break;
+        default:
+            break;
+    }
+}
+
+void usb_client_init() {
+    usb_cdc.setRxBufferSize(USB_CDC_RX_BUFFER_SIZE);
+    usb_cdc.setTxTimeoutMs(USB_CDC_TX_TIMEOUT_MS);
+    usb_cdc.onEvent(usb_cdc_event);
+    usb_cdc.begin();
+}
+
+static void usb_report_latency(uint8_t client) {
+    portENTER_CRITICAL(&usb_stats_mux);
+    uint32_t count     = usb_latency_count;
+    int64_t  sum_us    = usb_latency_sum_us;
+    int64_t  max_us    = usb_latency_max_us;
+    usb_latency_count  = 0;
+    usb_latency_sum_us = 0;
+    usb_latency_max_us = 0;
+    portEXIT_CRITICAL(&usb_stats_mux);
+    if (count) {
+        grbl_msg_sendf(client, MsgLevel::Info, "USB reader latency: %d events, mean %.0fus, max %dus", count, (float)sum_us / count, (int)max_us);
+    }
+}
+
+// Counts and drops received bytes up to a Ctrl-D, which ends $UB=RX.
+static void usb_sink() {
+    uint8_t buf[256];
+    size_t  n;
+    while ((n = usb_cdc.read(buf, MIN(sizeof(buf), size_t(usb_cdc.available())))) > 0) {
+        int64_t now = esp_timer_get_time();
+        if (usb_sink_bytes == 0) {
+            usb_sink_start_us = now;
+        }
+        usb_sink_end_us = now;
+        uint8_t* eot    = (uint8_t*)memchr(buf, 0x04, n);
+        if (eot == NULL) {
+            usb_sink_bytes += n;
+            continue;
+        }
+        usb_sink_bytes += eot - buf;
+        usb_sinking = false;
+        float secs  = (usb_sink_end_us - usb_sink_start_us) / 1000000.0;
+        grbl_msg_sendf(CLIENT_USB,
+                       MsgLevel::Info,
+                       "USB RX %d bytes in %.1fms, %.0f bytes/s",
+                       usb_sink_bytes,
+                       secs * 1000.0,
+                       secs > 0 ? usb_sink_bytes / secs : 0.0);
+        usb_report_latency(CLIENT_USB);
+        return;  // Whatever followed the Ctrl-D in this read is dropped
+    }
+}
+
+size_t usb_client_read(uint8_t* data, size_t len) {
+    if (usb_greet) {
+        usb_greet = false;
+        report_init_message(CLIENT_USB);
+    }
+    size_t available = usb_cdc.available();
+    if (available == 0) {
+        return 0;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&usb_stats_mux);
+    if (usb_rx_event_us) {
+        int64_t latency = now - usb_rx_event_us;
+        usb_rx_event_us = 0;
+        usb_latency_count++;
+        usb_latency_sum_us += latency;
+        usb_latency_max_us = MAX(usb_latency_max_us, latency);
+    }
+    portEXIT_CRITICAL(&usb_stats_mux);
+    if (usb_sinking) {
+        usb_sink();
+        return 0;
+    }
+    return usb_cdc.read(data, MIN(len, available));
+}
+
+size_t usb_client_available() {
+    return usb_cdc.available();
+}
+
+void usb_client_write(const char* text) {
+    if (usb_cdc.isConnected()) {
+        usb_cdc.write((const uint8_t*)text, strlen(text));
+    }
+}
+
+// Sends usb_bench_bytes of filler lines and reports the bytes/s, then ends itself
+static void usb_bench_task(void* pvParameters) {
+    // Filler lines of 64 bytes that senders pass over like any other [...] report
+    char line[64];
+    memset(line, '.', sizeof(line));
+    memcpy(line, "[UBD:", 5);
+    memcpy(line + sizeof(line) - 3, "]\r\n", 3);
+
+    uint32_t total = usb_bench_bytes;
+    uint32_t sent  = 0;
+    int64_t  start = esp_timer_get_time();
+    while (sent < total) {
+        size_t n = usb_cdc.write((const uint8_t*)line, sizeof(line));
+        if (n == 0) {
+            break;  // The host stopped reading
+        }
+        sent += n;
+    }
+    usb_cdc.flush();
+    float secs = (esp_timer_get_time() - start) / 1000000.0;
+    grbl_msg_sendf(usb_bench_client,
+                   MsgLevel::Info,
+                   "USB TX %d of %d bytes in %.1fms, %.0f bytes/s",
+                   sent,
+                   total,
+                   secs * 1000.0,
+                   secs > 0 ? sent / secs : 0.0);
+    usb_bench_running = false;
+    vTaskDelete(NULL);
+}
+
+Error usb_client_bench(const char* value, uint8_t client) {
+    if (value == NULL || *value == '\0') {
+        grbl_msg_sendf(client,
+                       MsgLevel::Info,
+                       "USB %s, RX buffer %d bytes",
+                       usb_cdc.isConnected() ? "connected" : "not connected",
+                       USB_CDC_RX_BUFFER_SIZE);
+        usb_report_latency(client);
+        return Error::Ok;
+    }
+    if (strcasecmp(value, "RX") == 0) {
+        usb_sink_bytes = 0;
+        usb_sinking    = true;
+        grbl_msg_sendf(client, MsgLevel::Info, "USB input is counted and dropped until Ctrl-D");
+        return Error::Ok;
+    }
+    char* end;
+    long  kbytes = strtol(value, &end, 10);
+    if (*end != '\0' || kbytes <= 0 || kbytes > USB_BENCH_MAX_KBYTES) {
+        return Error::InvalidValue;
+    }
+    if (!usb_cdc.isConnected()) {
+        grbl_msg_sendf(client, MsgLevel::Info, "USB not connected");
+        return Error::Ok;
+    }
+    if (usb_bench_running.exchange(true)) {
+        grbl_msg_sendf(client, MsgLevel::Info, "USB TX benchmark already running");
+        return Error::Ok;
+    }
+    // Writing megabytes takes seconds, so a task of its own does it and the protocol loop goes on
+    usb_bench_bytes  = kbytes * 1024;
+    usb_bench_client = client;
+    if (xTaskCreatePinnedToCore(usb_bench_task,     // task
+                                "usbBenchTask",     // name for task
+                                3072,               // size of task stack
+                                NULL,               // parameters
+                                1,                  // priority
+                                NULL,               // task handle
+                                SUPPORT_TASK_CORE   // core
+                                ) != pdPASS) {
+        usb_bench_running = false;
+        grbl_msg_sendf(client, MsgLevel::Error, "No room for the benchmark task");
+    }
+    return Error::Ok;
+}
+
+#endif
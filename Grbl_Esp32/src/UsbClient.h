@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+  UsbClient.h - Native USB-CDC client of the ESP32-S3
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// With ENABLE_USB_CDC, the native USB port of the ESP32-S3 is a client of its own, CLIENT_USB,
+// next to the serial port behind the CH340 bridge. It runs at USB full speed instead of the
+// UART baud rate. The host opens it like any serial port (/dev/ttyACM*, COMx), and it carries
+// G-code, $ commands, realtime characters and reports exactly as the serial client does.
+//
+// The port is the USB Serial/JTAG controller of the chip (HWCDC, USBSerial in the core). Its driver
+// queues received packets in a buffer of USB_CDC_RX_BUFFER_SIZE bytes and wakes the client reader
+// task, which takes them out in bulk. Output is dropped while no host has the port open, so a
+// missing host never stalls Grbl.
+//
+// $UB (USB/Bench) measures the link:
+//
+//   $UB            Reports the connection, the buffer size, and the latency from the USB receive
+//                  event until the reader task picked the bytes up, since the last report
+//   $UB=<kbytes>   Sends kbytes of [UBD:...] filler lines to the host from a task of its own,
+//                  and reports the bytes/s when done
+//   $UB=RX         Sinks what the host sends next, up to a Ctrl-D (0x04), without parsing it,
+//                  then reports the bytes, bytes/s and reader latency on the USB port
+//
+// The USB mode of the build must be Hardware CDC and JTAG (ARDUINO_USB_MODE=1), with USB CDC On
+// Boot disabled so that Serial stays on the UART. platformio.ini builds that way.
+
+#include "Grbl.h"
+
+#ifdef ENABLE_USB_CDC
+
+#    ifndef USB_CDC_RX_BUFFER_SIZE
+#        define USB_CDC_RX_BUFFER_SIZE 4096
+#    endif
+
+void usb_client_init();
+
+// Moves up to len received bytes into data. Returns the number of bytes moved. Called by the
+// client reader task only.
+size_t usb_client_read(uint8_t* data, size_t len);
+
+// Bytes received and not read yet
+size_t usb_client_available();
+
+void usb_client_write(const char* text);
+
+// Runs $UB. See above.
+Error usb_client_bench(const char* value, uint8_t client);
+
+#endif
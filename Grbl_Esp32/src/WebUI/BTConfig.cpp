@@ -60,6 +60,9 @@ namespace WebUI {
                 BTConfig::_btclient = str;
                 grbl_sendf(CLIENT_ALL, "[MSG:BT Connected with %s]\r\n", str);
             } break;
+            case ESP_SPP_DATA_IND_EVT:  //Data received, now queued in SerialBT
+                client_rx_notify();
+                break;
             case ESP_SPP_CLOSE_EVT:  //Client connection closed
                 grbl_send(CLIENT_ALL, "[MSG:BT Disconnected]\r\n");
                 BTConfig::_btclient = "";
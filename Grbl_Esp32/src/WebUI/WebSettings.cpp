@@ -592,6 +592,19 @@ namespace WebUI {
         }
         webPrintln("");
 #endif
+        if (st_isr_stats.ticks) {
+            // A snapshot; $SJ gives the histograms and starts a new measurement window
+            st_isr_stats_t stats           = st_isr_stats;
+            float          cycles_per_usec = ESP.getCpuFreqMHz();
+            if (current_stepper == ST_I2S_STREAM) {
+                webPrintln("Stepper I2S stream DMA underruns: ", String(st_isr_underruns(stats)));
+            } else {
+                webPrintln("Stepper ISR latency max: ", String((float)stats.latency_max / ticksPerMicrosecond, 2) + "us");
+                webPrintln("Stepper ISR late/busy: ", String(stats.late) + "/" + String(stats.busy));
+            }
+            webPrintln("Stepper ISR execution max: ", String(stats.exec_max / cycles_per_usec, 2) + "us");
+            webPrintln("Stepper ISR mean execution: ", String((float)stats.exec_sum / stats.ticks / cycles_per_usec, 2) + "us");
+        }
         webPrint("FW version: ");
         webPrint(GRBL_VERSION);
         webPrint(" (");
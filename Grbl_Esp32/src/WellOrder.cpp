@@ -0,0 +1,171 @@
+/*
+  WellOrder.cpp - Travel order of a set of well visits
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+#ifdef LABWARE_SLOTS
+
+static uint16_t well_set[WELL_ORDER_MAX];
+static uint16_t well_set_count;
+static uint16_t well_set_ordered[WELL_ORDER_MAX];
+
+static well_tour_t well_tour;  // The tour being ordered
+
+typedef struct {
+    uint16_t     n;          // Number of visits
+    float        nn_time;    // Travel time of the nearest-neighbour tour (sec)
+    float        time;       // Travel time of the final tour (sec)
+    uint32_t     passes;     // 2-opt passes over the tour
+    bool         converged;  // 2-opt ran out of improving moves within the budget
+    uint32_t     cpu_us;     // Time the search took
+    TaskHandle_t caller;     // Notified when the search is done
+} well_order_job_t;
+static well_order_job_t well_order_job;
+
+void well_order_clear() {
+    well_set_count = 0;
+}
+
+bool well_order_add(uint16_t well) {
+    if (well_set_count == WELL_ORDER_MAX) {
+        return false;
+    }
+    well_set[well_set_count++] = well;
+    return true;
+}
+
+uint16_t well_order_count() {
+    return well_set_count;
+}
+
+// Reads the X and Y max rate and acceleration from the settings before a search
+static void well_order_load_axes() {
+    for (uint8_t axis = X_AXIS; axis <= Y_AXIS; axis++) {
+        well_tour.rate[axis]  = axis_settings[axis]->max_rate->get() / 60.0;
+        well_tour.accel[axis] = axis_settings[axis]->acceleration->get();
+    }
+}
+
+static int64_t well_order_deadline;
+
+static bool well_order_expired() {
+    return esp_timer_get_time() > well_order_deadline;
+}
+
+static void well_order_search() {
+    well_order_job_t* job   = &well_order_job;
+    int64_t           start = esp_timer_get_time();
+    well_order_deadline     = start + WELL_ORDER_BUDGET_MS * 1000;
+    well_tour.n             = job->n;
+    well_tour_nearest_neighbour(&well_tour);
+    job->nn_time   = well_tour_time(&well_tour);
+    job->passes    = 0;
+    job->converged = well_tour_two_opt(&well_tour, well_order_expired, &job->passes);
+    job->time      = well_tour_time(&well_tour);
+    job->cpu_us    = esp_timer_get_time() - start;
+}
+
+static void well_order_task(void* pvParameters) {
+    well_order_search();
+    xTaskNotifyGive(well_order_job.caller);
+    vTaskDelete(NULL);
+}
+
+// Orders points 1..n from the start position (x, y) into well_tour.tour[].
+static void well_order_run(uint16_t n, float x, float y) {
+    well_tour.x[0] = x;
+    well_tour.y[0] = y;
+    well_order_load_axes();
+    well_order_job.n      = n;
+    well_order_job.caller = xTaskGetCurrentTaskHandle();
+    if (xTaskCreatePinnedToCore(well_order_task,     // task
+                                "wellOrderTask",     // name for task
+                                4096,                // size of task stack
+                                NULL,                // parameters
+                                1,                   // priority
+                                NULL,                // task handle
+                                SUPPORT_TASK_CORE    // core
+                                ) != pdPASS) {
+        well_order_search();  // No room for the task. Search from here.
+        return;
+    }
+    // Keep the realtime commands going while the task searches.
+    while (ulTaskNotifyTake(pdTRUE, 1) == 0) {
+        protocol_execute_realtime();
+    }
+}
+
+const uint16_t* well_order_solve(Labware* lw, float x, float y) {
+    for (uint16_t i = 0; i < well_set_count; i++) {
+        lw->wellPosition(well_set[i], &well_tour.x[i + 1], &well_tour.y[i + 1]);
+    }
+    well_order_run(well_set_count, x, y);
+    for (uint16_t i = 0; i < well_set_count; i++) {
+        well_set_ordered[i] = well_set[well_tour.tour[i + 1] - 1];
+    }
+    return well_set_ordered;
+}
+
+void well_order_benchmark(uint8_t client) {
+    const struct {
+        uint8_t rows;
+        uint8_t cols;
+        float   pitch;
+    } plates[] = { { 8, 12, 9.0 }, { 16, 24, 4.5 } };
+
+    uint32_t seed = 1;  // Fixed, so runs compare
+    well_order_load_axes();
+    for (auto plate : plates) {
+        uint16_t n = plate.rows * plate.cols;
+        // A1 of a standard plate sits 14.38 x 11.24 mm in from its corner, at the start position.
+        float* x = well_tour.x;
+        float* y = well_tour.y;
+        for (uint16_t i = 0; i < n; i++) {
+            x[i + 1] = 14.38 + (i % plate.cols) * plate.pitch;
+            y[i + 1] = 11.24 + (i / plate.cols) * plate.pitch;
+        }
+        x[0] = 0.0;
+        y[0] = 0.0;
+        // Shuffle the wells into the host order.
+        for (uint16_t i = n; i > 1; i--) {
+            seed       = seed * 1103515245 + 12345;
+            uint16_t j = 1 + (seed >> 16) % i;
+            std::swap(x[i], x[j]);
+            std::swap(y[i], y[j]);
+        }
+        well_tour.n = n;
+        for (uint16_t i = 0; i <= n; i++) {
+            well_tour.tour[i] = i;
+        }
+        float host_time = well_tour_time(&well_tour);
+
+        well_order_run(n, 0.0, 0.0);
+        grbl_msg_sendf(client,
+                       MsgLevel::Info,
+                       "Order %d wells: host %.2fs, NN %.2fs, 2-opt %.2fs in %d passes%s, %.1fms",
+                       n,
+                       host_time,
+                       well_order_job.nn_time,
+                       well_order_job.time,
+                       well_order_job.passes,
+                       well_order_job.converged ? "" : " (budget)",
+                       well_order_job.cpu_us / 1000.0);
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+  WellOrder.h - Travel order of a set of well visits
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// M470 starts a visit set on the active labware (M460). The lines that follow hold one W word
+// each, and are collected instead of executed. M471 then visits the collected wells, as G0/G1
+// moves in the current motion mode, in the order that takes the least gantry travel time:
+//
+//   M450 Q20        Dispense 20 uL into each well
+//   M470            Start the visit set
+//   W17             Wells in any order
+//   W3
+//   W40
+//   M471            Visit them, shortest travel first
+//
+// The order starts with a nearest-neighbour tour from the current position, which 2-opt then
+// improves until no move helps or the CPU budget runs out. A move costs the longer of the X and
+// Y travel times, each from the axis max rate and acceleration (see WellTour.h). The search runs
+// in a task of its own on the support core, while the main loop keeps serving realtime commands.
+
+#include "Grbl.h"
+#include "WellTour.h"
+
+#ifdef LABWARE_SLOTS
+
+// Number of visits a set holds.
+const uint16_t WELL_ORDER_MAX = WELL_TOUR_MAX;
+
+// CPU time the 2-opt search may take (milliseconds). The nearest-neighbour tour is always built.
+#    ifndef WELL_ORDER_BUDGET_MS
+#        define WELL_ORDER_BUDGET_MS 200
+#    endif
+
+// Empties the visit set.
+void well_order_clear();
+
+// Adds a well to the visit set. Returns false if the set is full.
+bool well_order_add(uint16_t well);
+
+uint16_t well_order_count();
+
+// Orders the visit set for the least travel time from machine position (x, y) through the wells of
+// the labware. Returns the well indices in visit order, well_order_count() of them.
+const uint16_t* well_order_solve(Labware* lw, float x, float y);
+
+// Times the ordering of shuffled 96- and 384-well plates and reports the travel time of the host
+// order, the nearest-neighbour tour and the 2-opt tour.
+void well_order_benchmark(uint8_t client);
+
+#endif
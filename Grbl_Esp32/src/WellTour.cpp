@@ -0,0 +1,100 @@
+/*
+  WellTour.cpp - Least travel time tour through a set of well visits
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WellTour.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Smallest travel time gain (sec) a 2-opt move must make, so rounding can't make it cycle.
+const float WELL_TOUR_EPSILON = 1e-6;
+
+// Time one axis takes to travel a distance from rest to rest.
+static float well_tour_axis_time(const well_tour_t* t, float distance, uint8_t axis) {
+    float v = t->rate[axis];
+    float a = t->accel[axis];
+    distance = fabsf(distance);
+    if (distance * a < v * v) {
+        return 2.0 * sqrtf(distance / a);  // Triangle profile, never reaches the max rate
+    }
+    return distance / v + v / a;
+}
+
+float well_tour_cost(const well_tour_t* t, uint16_t from, uint16_t to) {
+    return std::max(well_tour_axis_time(t, t->x[to] - t->x[from], 0), well_tour_axis_time(t, t->y[to] - t->y[from], 1));
+}
+
+float well_tour_time(well_tour_t* t) {
+    float time = 0.0;
+    for (uint16_t i = 0; i < t->n; i++) {
+        t->edge_cost[i] = well_tour_cost(t, t->tour[i], t->tour[i + 1]);
+        time += t->edge_cost[i];
+    }
+    return time;
+}
+
+void well_tour_nearest_neighbour(well_tour_t* t) {
+    uint16_t* tour = t->tour;
+    for (uint16_t i = 0; i <= t->n; i++) {
+        tour[i] = i;
+    }
+    for (uint16_t i = 1; i < t->n; i++) {
+        uint16_t best      = i;
+        float    best_cost = well_tour_cost(t, tour[i - 1], tour[i]);
+        for (uint16_t j = i + 1; j <= t->n; j++) {
+            float cost = well_tour_cost(t, tour[i - 1], tour[j]);
+            if (cost < best_cost) {
+                best      = j;
+                best_cost = cost;
+            }
+        }
+        std::swap(tour[i], tour[best]);
+    }
+}
+
+bool well_tour_two_opt(well_tour_t* t, bool (*expired)(), uint32_t* passes) {
+    uint16_t  n        = t->n;
+    uint16_t* tour     = t->tour;
+    float*    cost     = t->edge_cost;
+    bool      improved = true;
+    while (improved) {
+        improved = false;
+        for (uint16_t i = 1; i < n; i++) {
+            if (expired()) {
+                return false;
+            }
+            for (uint16_t j = i + 1; j <= n; j++) {
+                // Reversing tour[i..j] replaces the edges into tour[i] and out of tour[j]. The
+                // last point has no edge out.
+                float delta = well_tour_cost(t, tour[i - 1], tour[j]) - cost[i - 1];
+                if (j < n) {
+                    delta += well_tour_cost(t, tour[i], tour[j + 1]) - cost[j];
+                }
+                if (delta < -WELL_TOUR_EPSILON) {
+                    std::reverse(tour + i, tour + j + 1);
+                    for (uint16_t k = i - 1; k <= j && k < n; k++) {
+                        cost[k] = well_tour_cost(t, tour[k], tour[k + 1]);
+                    }
+                    improved = true;
+                }
+            }
+        }
+        (*passes)++;
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+  WellTour.h - Least travel time tour through a set of well visits
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The search behind the visit sets of WellOrder.h. A move costs the longer of the X and Y travel
+// times, each from rest to rest with the axis max rate and acceleration. The tour is open: it
+// starts at the start position and ends at its last visit.
+//
+// Nothing here depends on the ESP32, so it builds on the host for the tests in test/.
+
+#include "Labware.h"
+
+#include <cstdint>
+
+// Number of visits a tour holds, every well of the largest plate
+const uint16_t WELL_TOUR_MAX = LABWARE_MAX_ROWS * LABWARE_MAX_COLS;
+
+typedef struct {
+    uint16_t n;                         // Number of visits
+    float    x[WELL_TOUR_MAX + 1];      // Point 0 is the start position, points 1..n are the visits
+    float    y[WELL_TOUR_MAX + 1];
+    float    rate[2];                   // X and Y max rate (mm/sec)
+    float    accel[2];                  // X and Y acceleration (mm/sec^2)
+    uint16_t tour[WELL_TOUR_MAX + 1];   // Point indices in visit order, always starting at point 0
+    float    edge_cost[WELL_TOUR_MAX];  // Travel time from tour[i] to tour[i + 1] (sec)
+} well_tour_t;
+
+// Travel time between two points (sec)
+float well_tour_cost(const well_tour_t* t, uint16_t from, uint16_t to);
+
+// Travel time of the tour (sec). Also refreshes edge_cost.
+float well_tour_time(well_tour_t* t);
+
+// Builds the tour by always going to the closest point not visited yet.
+void well_tour_nearest_neighbour(well_tour_t* t);
+
+// Improves the tour by reversing stretches of it, until no reversal shortens the travel time or
+// expired() returns true. edge_cost must be fresh. Counts the passes over the tour in passes.
+// Returns true if it ran out of improving reversals.
+bool well_tour_two_opt(well_tour_t* t, bool (*expired)(), uint32_t* passes);
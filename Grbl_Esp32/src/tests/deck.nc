@@ -0,0 +1,31 @@
+; Deck map and deck travel (M480, M481). Needs a machine with DECK_MAP_ROWS 16 x DECK_MAP_COLS 24.
+; paste with a terminal emulator with a 200 ms delay between lines
+; each "; expect" line gives the response to the line after it
+$X
+; expect error:20, no deck map yet (on a fresh map)
+m480
+; 10 mm cells from the machine origin
+$DM=O 0 0 10
+; a 30 mm high obstacle in row 2, columns 3 to 5
+$DM=2 0 0 0 30 30 30 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0
+$DM
+; expect [DM:0.000,0.000,10.000] then 16 [DMn:...] rows
+; expect error:81, a row needs 24 heights
+$DM=3 0 0 0
+; expect error:81, cells must be larger than 0
+$DM=O 0 0 0
+$Deck/Clearance=5
+g90 g21 g0 x0 y25 z0
+m480
+$G
+; expect [GC:... M480 ...]
+; G0 over the obstacle lifts Z to 35 on the way and comes back down
+g0 x70 y25
+g4 p0
+?
+; expect MPos:70.000,25.000,0.000
+; G1 moves don't lift
+g1 x0 f1000
+m481
+$G
+; expect no M480 in [GC:...]
@@ -0,0 +1,44 @@
+; Multi-dispense (M450, M451). Needs a machine with SYRINGE_AXIS A and LABWARE_SLOTS.
+; paste with a terminal emulator with a 200 ms delay between lines
+; each "; expect" line gives the response to the line after it
+$X
+$Syringe/UlPerMm=24.1
+$A/MaxTravel=41.5
+; 96 well plate in slot 0, A1 at X10 Y20, rows toward -Y
+$LW=0 10 20 -5 9 -9 8 12 10.5 15
+g90 g21 m460 p0
+; fill the syringe to 500 uL
+$Syringe/Volumetric=On
+g1 a500 f300
+; 20 uL into each well, blended into the last 2 mm
+m450 q20
+$G
+; expect [GC:... M450 Q20.0 ...]
+g0 w0
+g0 w1
+g0 w2
+g4 p0
+?
+; expect A at 440 uL (18.257 mm)
+; expect error:24, a syringe word while dispensing
+g0 w3 a100
+; expect error:4, Q not positive
+m450 q0
+; expect error:4, negative blend
+m450 q20 r-1
+; expect error:28, Q missing
+m450
+; expect error:38, more than the syringe holds (41.5 mm at 24.1 uL/mm, 1000 uL)
+m450 q1001
+; a visit set of three wells of 400 uL doesn't fit in the syringe
+m450 q400
+m470
+w10
+w11
+w12
+; expect error:38
+m471
+m451
+$G
+; expect no M450 in [GC:...]
+$Syringe/Volumetric=Off
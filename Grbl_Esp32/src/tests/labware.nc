@@ -0,0 +1,39 @@
+; Labware table and well words (M460, W). Needs a machine with LABWARE_SLOTS.
+; paste with a terminal emulator with a 200 ms delay between lines
+; each "; expect" line gives the response to the line after it
+$X
+$rst=#
+; 96 well plate in slot 0, A1 at X10 Y20, rows toward -Y
+$LW=0 10 20 -5 9 -9 8 12 10.5 15
+$LW=0
+; expect [LW0:10.000,20.000,-5.000,9.000,-9.000,8,12,10.500,15.000,0.000]
+; expect error:81, too few fields
+$LW=1 10 20 -5 9 -9 8 12 10.5
+; expect error:81, part of a row
+$LW=1 10 20 -5 9 -9 8.5 12 10.5 15
+; expect error:81, 17 rows
+$LW=1 10 20 -5 9 -9 17 12 10.5 15
+; expect error:2
+$LW=1 10 20 -5 9 -9 8 x 10.5 15
+; expect error:81, no such slot
+$LW=99
+g90 g21 m460 p0
+g0 w0
+?
+; expect MPos:10.000,20.000
+g0 w13
+?
+; expect MPos:19.000,11.000 (B2)
+; expect error:33, no such well
+g0 w96
+; expect error:24, W with X
+g0 w1 x5
+; expect error:20, W with G92
+g92 w1
+; expect error:38, no such slot
+m460 p99
+; expect error:28, P missing
+m460
+g0 w95
+?
+; expect MPos:109.000,-43.000 (H12)
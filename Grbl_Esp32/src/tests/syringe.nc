@@ -0,0 +1,43 @@
+; Volumetric syringe words and Z-follow (M440, M441). Needs a machine with SYRINGE_AXIS A.
+; paste with a terminal emulator with a 200 ms delay between lines
+; each "; expect" line gives the response to the line after it
+$X
+$Syringe/UlPerMm=24.1
+$Syringe/Volumetric=On
+g90 g21 g0 z0 a0
+; draw 241 uL, 10 mm of syringe travel
+g1 a241 f300
+g4 p0
+?
+; expect MPos:...,10.000 on A
+; G91 draws more, and inches don't scale a volume
+g91 g20 g1 a24.1 f10
+g4 p0
+?
+; expect MPos:...,11.000 on A
+g90 g21
+; expect error:20, G92 can't set a volume
+g92 a0
+; expect error:20, nor G10
+g10 l20 p1 a0
+; Z-follow over a 100 mm^2 well
+m440 q100
+$G
+; expect [GC:... M440 Q100.0 ...]
+; dispense 241 uL: Z rises 2.41 mm with the surface
+g1 a24.1 f300
+g4 p0
+?
+; expect Z up by 2.410, A at 1.000
+; a Z word overrides the follow
+g1 a0 z0
+; expect error:4, area not positive
+m440 q0
+; expect error:38, area over Z_FOLLOW_MAX_AREA
+m440 q100001
+m441
+; expect error:28, no Q and no well area in the active labware
+m440
+$G
+; expect no M440 in [GC:...]
+$Syringe/Volumetric=Off
@@ -0,0 +1,32 @@
+; Well visit sets (M470, M471). Needs a machine with LABWARE_SLOTS.
+; paste with a terminal emulator with a 200 ms delay between lines
+; each "; expect" line gives the response to the line after it
+$X
+; 96 well plate in slot 0, A1 at X10 Y20, rows toward -Y
+$LW=0 10 20 -5 9 -9 8 12 10.5 15
+g90 g21 m460 p0
+g0 w0
+m470
+w95
+w1
+w94
+w2
+; expect error:20, only W words while collecting
+g0 x5
+; expect error:33, no such well
+w96
+; visits A2, A3, H11, H12: the nearest first, not the order sent
+m471
+g4 p0
+?
+; expect MPos:109.000,-43.000
+; expect error:20, M471 needs G0 or G1
+m470
+w1
+g2 m471
+m471
+; expect ok, an empty set visits nothing
+m470
+m471
+$LWB
+; expect [MSG:Order 96 wells: ...] and [MSG:Order 384 wells: ...]
@@ -0,0 +1,366 @@
+/*
+  test_main.cpp - Host tests of the client receive queue
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unity.h>
+
+#include "ClientBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+void setUp() {}
+void tearDown() {}
+
+static inline uint8_t pattern(uint32_t i) {
+    return i % 251;  // Prime period, so a lost or doubled byte shows up
+}
+
+static void test_empty_before_begin() {
+    ClientBuffer buffer;
+    TEST_ASSERT_EQUAL(0, buffer.capacity());
+    TEST_ASSERT_EQUAL(0, buffer.available());
+    TEST_ASSERT_EQUAL(0, buffer.availableForWrite());
+    TEST_ASSERT_FALSE(buffer.write('a'));
+    TEST_ASSERT_EQUAL(-1, buffer.read());
+}
+
+static void test_begin_rounds_down_to_a_power_of_two() {
+    ClientBuffer buffer;
+    TEST_ASSERT_TRUE(buffer.begin(1000));
+    TEST_ASSERT_EQUAL(512, buffer.capacity());
+    TEST_ASSERT_EQUAL(512, buffer.availableForWrite());
+
+    ClientBuffer exact;
+    TEST_ASSERT_TRUE(exact.begin(256));
+    TEST_ASSERT_EQUAL(256, exact.capacity());
+}
+
+static void test_bytes_in_order_until_full() {
+    ClientBuffer buffer;
+    buffer.begin(16);
+    for (uint32_t i = 0; i < 16; i++) {
+        TEST_ASSERT_TRUE(buffer.write(pattern(i)));
+    }
+    TEST_ASSERT_FALSE(buffer.write(0));
+    TEST_ASSERT_EQUAL(16, buffer.available());
+    TEST_ASSERT_EQUAL(0, buffer.availableForWrite());
+    for (uint32_t i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(pattern(i), buffer.read());
+    }
+    TEST_ASSERT_EQUAL(-1, buffer.read());
+    TEST_ASSERT_EQUAL(16, buffer.availableForWrite());
+}
+
+static void test_bulk_write_stops_at_full() {
+    ClientBuffer buffer;
+    buffer.begin(16);
+    uint8_t data[24];
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = pattern(i);
+    }
+    TEST_ASSERT_EQUAL(16, buffer.write(data, sizeof(data)));
+    TEST_ASSERT_EQUAL(0, buffer.write(data, sizeof(data)));
+
+    uint8_t out[24];
+    TEST_ASSERT_EQUAL(16, buffer.read(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, 16);
+    TEST_ASSERT_EQUAL(0, buffer.read(out, sizeof(out)));
+}
+
+static void test_spans_stop_at_the_end_of_the_storage() {
+    ClientBuffer buffer;
+    buffer.begin(16);
+    uint8_t data[16];
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = pattern(i);
+    }
+    buffer.write(data, 12);
+    uint8_t out[16];
+    buffer.read(out, 10);
+
+    // 2 bytes at the end of the storage, then the room wraps to the start
+    uint8_t* wspan;
+    TEST_ASSERT_EQUAL(4, buffer.writeSpan(&wspan));
+    const uint8_t* rspan;
+    TEST_ASSERT_EQUAL(2, buffer.readSpan(&rspan));
+    TEST_ASSERT_EQUAL(pattern(10), rspan[0]);
+
+    // A bulk write and read cross the end in two spans
+    TEST_ASSERT_EQUAL(14, buffer.write(data, 14));
+    TEST_ASSERT_EQUAL(16, buffer.available());
+    TEST_ASSERT_EQUAL(16, buffer.read(out, 16));
+    TEST_ASSERT_EQUAL(pattern(10), out[0]);
+    TEST_ASSERT_EQUAL(pattern(11), out[1]);
+    TEST_ASSERT_EQUAL_MEMORY(data, out + 2, 14);
+}
+
+static void test_commit_and_consume() {
+    ClientBuffer buffer;
+    buffer.begin(8);
+    uint8_t* span;
+    size_t   room = buffer.writeSpan(&span);
+    TEST_ASSERT_EQUAL(8, room);
+    memcpy(span, "abc", 3);
+    TEST_ASSERT_EQUAL(0, buffer.available());  // Not published yet
+    buffer.commitWrite(3);
+    TEST_ASSERT_EQUAL(3, buffer.available());
+
+    const uint8_t* data;
+    TEST_ASSERT_EQUAL(3, buffer.readSpan(&data));
+    TEST_ASSERT_EQUAL_MEMORY("abc", data, 3);
+    buffer.consume(2);
+    TEST_ASSERT_EQUAL('c', buffer.read());
+}
+
+static void test_clear_drops_everything() {
+    ClientBuffer buffer;
+    buffer.begin(8);
+    buffer.write((const uint8_t*)"abcdef", 6);
+    buffer.clear();
+    TEST_ASSERT_EQUAL(0, buffer.available());
+    TEST_ASSERT_EQUAL(8, buffer.availableForWrite());
+    TEST_ASSERT_TRUE(buffer.write('x'));
+    TEST_ASSERT_EQUAL('x', buffer.read());
+}
+
+static void test_counters_wrap() {
+    ClientBuffer buffer;
+    buffer.begin(256);
+    // Run the free-running counters past 2^32
+    for (uint32_t i = 0; i < (1u << 24) + 1; i++) {
+        buffer.commitWrite(255);
+        buffer.consume(255);
+    }
+    uint8_t data[200];
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = pattern(i);
+    }
+    TEST_ASSERT_EQUAL(200, buffer.write(data, sizeof(data)));
+    TEST_ASSERT_EQUAL(200, buffer.available());
+    TEST_ASSERT_EQUAL(56, buffer.availableForWrite());
+    uint8_t out[200];
+    TEST_ASSERT_EQUAL(200, buffer.read(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(data));
+}
+
+// One writer thread and one reader thread, as the client reader task and the protocol loop.
+// Every byte must come out once and in order. The writer mixes byte, bulk and span writes and
+// the reader mixes byte reads and spans, so every pair of the two sides races.
+static void test_two_threads() {
+    const uint32_t total = 4 * 1024 * 1024;
+    ClientBuffer   buffer;
+    buffer.begin(256);
+
+    std::thread writer([&buffer, total]() {
+        uint32_t sent = 0;
+        while (sent < total) {
+            if (buffer.availableForWrite() == 0) {
+                std::this_thread::yield();  // The host may have fewer cores than threads
+                continue;
+            }
+            switch (sent % 3) {
+                case 0:
+                    sent += buffer.write(pattern(sent));
+                    break;
+                case 1: {
+                    uint8_t  chunk[64];
+                    uint32_t n = std::min<uint32_t>(sizeof(chunk), total - sent);
+                    for (uint32_t i = 0; i < n; i++) {
+                        chunk[i] = pattern(sent + i);
+                    }
+                    sent += buffer.write(chunk, n);  // A partial write is fine, the rest goes next time
+                } break;
+                default: {
+                    uint8_t* span;
+                    uint32_t n = std::min<uint32_t>(buffer.writeSpan(&span), total - sent);
+                    for (uint32_t i = 0; i < n; i++) {
+                        span[i] = pattern(sent + i);
+                    }
+                    buffer.commitWrite(n);
+                    sent += n;
+                } break;
+            }
+        }
+    });
+
+    uint32_t received = 0;
+    uint32_t errors   = 0;
+    while (received < total) {
+        if (buffer.available() == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (received & 1) {
+            int c = buffer.read();
+            if (c != -1) {
+                errors += c != pattern(received++);
+            }
+        } else {
+            const uint8_t* span;
+            size_t         n = buffer.readSpan(&span);
+            for (size_t i = 0; i < n; i++) {
+                errors += span[i] != pattern(received++);
+            }
+            buffer.consume(n);
+        }
+    }
+    writer.join();
+    TEST_ASSERT_EQUAL(0, errors);
+    TEST_ASSERT_EQUAL(0, buffer.available());
+}
+
+// Host stand-in for WebUI::InputBuffer: the same ring of a read position and a fill count, which
+// both sides update, so it needs a lock around every byte. The firmware benchmark takes a critical
+// section there; a mutex is the host equivalent.
+class LockedQueue {
+public:
+    bool write(uint8_t c) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_size == sizeof(_data)) {
+            return false;
+        }
+        _data[(_pos + _size) % sizeof(_data)] = c;
+        _size++;
+        return true;
+    }
+
+    int read() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_size == 0) {
+            return -1;
+        }
+        int c = _data[_pos];
+        _pos  = (_pos + 1) % sizeof(_data);
+        _size--;
+        return c;
+    }
+
+private:
+    std::mutex _mutex;
+    uint8_t    _data[256];  // The size of an InputBuffer
+    uint32_t   _pos  = 0;
+    uint32_t   _size = 0;
+};
+
+enum class BenchPath : uint8_t {
+    Locked,  // LockedQueue, one byte at a time
+    Byte,    // ClientBuffer, one byte at a time
+    Span,    // ClientBuffer, in spans
+};
+
+// Moves total bytes from a writer thread to this one along one path. Returns the bytes/s and
+// counts the bytes that did not match what was written.
+static double bench_transfer(BenchPath path, uint32_t total, uint32_t* errors) {
+    LockedQueue  locked;
+    ClientBuffer ring;
+    ring.begin(256);
+
+    auto        start = std::chrono::steady_clock::now();
+    std::thread writer([&]() {
+        uint32_t sent = 0;
+        while (sent < total) {
+            uint32_t n = 0;
+            switch (path) {
+                case BenchPath::Locked:
+                    n = locked.write(pattern(sent));
+                    break;
+                case BenchPath::Byte:
+                    n = ring.write(pattern(sent));
+                    break;
+                case BenchPath::Span: {
+                    uint8_t* span;
+                    n = std::min<uint32_t>(ring.writeSpan(&span), total - sent);
+                    for (uint32_t i = 0; i < n; i++) {
+                        span[i] = pattern(sent + i);
+                    }
+                    ring.commitWrite(n);
+                } break;
+            }
+            if (n == 0) {
+                std::this_thread::yield();  // Full. The host may have fewer cores than threads
+            }
+            sent += n;
+        }
+    });
+
+    uint32_t received = 0;
+    *errors           = 0;
+    while (received < total) {
+        uint32_t n = 0;
+        switch (path) {
+            case BenchPath::Locked:
+            case BenchPath::Byte: {
+                int c = path == BenchPath::Locked ? locked.read() : ring.read();
+                if (c != -1) {
+                    *errors += c != pattern(received);
+                    n = 1;
+                }
+            } break;
+            case BenchPath::Span: {
+                const uint8_t* span;
+                n = ring.readSpan(&span);
+                for (uint32_t i = 0; i < n; i++) {
+                    *errors += span[i] != pattern(received + i);
+                }
+                ring.consume(n);
+            } break;
+        }
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        received += n;
+    }
+    writer.join();
+    return total / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The host version of $Client/Bench: the InputBuffer baseline against the ring, in bytes/s.
+// Only the data is checked; the numbers are reported for comparison.
+static void test_benchmark_against_a_locked_queue() {
+    const uint32_t total = 1024 * 1024;
+    const struct {
+        BenchPath   path;
+        const char* name;
+    } paths[] = { { BenchPath::Locked, "InputBuffer+lock" }, { BenchPath::Byte, "ring by byte" }, { BenchPath::Span, "ring by span" } };
+
+    for (auto path : paths) {
+        uint32_t errors;
+        double   rate = bench_transfer(path.path, total, &errors);
+        char     message[80];
+        snprintf(message, sizeof(message), "%s: %u bytes, %.0f bytes/s", path.name, total, rate);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_EQUAL(0, errors);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_before_begin);
+    RUN_TEST(test_begin_rounds_down_to_a_power_of_two);
+    RUN_TEST(test_bytes_in_order_until_full);
+    RUN_TEST(test_bulk_write_stops_at_full);
+    RUN_TEST(test_spans_stop_at_the_end_of_the_storage);
+    RUN_TEST(test_commit_and_consume);
+    RUN_TEST(test_clear_drops_everything);
+    RUN_TEST(test_counters_wrap);
+    RUN_TEST(test_two_threads);
+    RUN_TEST(test_benchmark_against_a_locked_queue);
+    return UNITY_END();
+}
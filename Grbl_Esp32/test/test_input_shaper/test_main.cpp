@@ -0,0 +1,204 @@
+/*
+  test_main.cpp - Host tests of the input shaper impulse trains and shaped positions
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unity.h>
+
+#include "InputShaper.h"
+
+#include <cmath>
+#include <initializer_list>
+
+void setUp() {}
+void tearDown() {}
+
+// Residual vibration of an impulse train, relative to a single impulse, for a resonance of
+// frequency Hz and damping ratio damping. The times of the impulses are in minutes.
+static double residual_vibration(const ShaperImpulses& impulses, double frequency, double damping) {
+    double w  = 2.0 * M_PI * frequency;
+    double wd = w * sqrt(1.0 - damping * damping);
+    double tn = impulses.time[impulses.n - 1] * 60.0;
+    double c  = 0.0;
+    double s  = 0.0;
+    for (uint8_t i = 0; i < impulses.n; i++) {
+        double t = impulses.time[i] * 60.0;
+        double a = impulses.amplitude[i] * exp(-damping * w * (tn - t));
+        c += a * cos(wd * t);
+        s += a * sin(wd * t);
+    }
+    return sqrt(c * c + s * s);
+}
+
+static double amplitude_sum(const ShaperImpulses& impulses) {
+    double sum = 0.0;
+    for (uint8_t i = 0; i < impulses.n; i++) {
+        sum += impulses.amplitude[i];
+    }
+    return sum;
+}
+
+static void test_none_is_one_impulse() {
+    ShaperImpulses impulses;
+    shaper_impulses(ShaperType::None, 40.0, 0.1, impulses);
+    TEST_ASSERT_EQUAL(1, impulses.n);
+    TEST_ASSERT_EQUAL_FLOAT(1.0, impulses.amplitude[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0, impulses.time[0]);
+
+    // No frequency is no shaping either
+    shaper_impulses(ShaperType::ZVD, 0.0, 0.1, impulses);
+    TEST_ASSERT_EQUAL(1, impulses.n);
+}
+
+static void test_zv_undamped() {
+    ShaperImpulses impulses;
+    shaper_impulses(ShaperType::ZV, 40.0, 0.0, impulses);
+    TEST_ASSERT_EQUAL(2, impulses.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.5, impulses.amplitude[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.5, impulses.amplitude[1]);
+    // Half a period of 40 Hz, in minutes
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.5 / 40.0 / 60.0, impulses.time[1]);
+}
+
+static void test_amplitudes_add_up_to_one() {
+    const ShaperType types[] = { ShaperType::ZV, ShaperType::ZVD, ShaperType::EI };
+    for (ShaperType type : types) {
+        for (float damping : { 0.0f, 0.05f, 0.2f }) {
+            ShaperImpulses impulses;
+            shaper_impulses(type, 55.0, damping, impulses);
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, amplitude_sum(impulses));
+            TEST_ASSERT_EQUAL_FLOAT(0.0, impulses.time[0]);
+            for (uint8_t i = 1; i < impulses.n; i++) {
+                TEST_ASSERT_GREATER_THAN(impulses.time[i - 1], impulses.time[i]);
+            }
+        }
+    }
+}
+
+static void test_zero_vibration_at_the_resonance() {
+    for (float damping : { 0.0f, 0.1f }) {
+        ShaperImpulses impulses;
+        shaper_impulses(ShaperType::ZV, 40.0, damping, impulses);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.0, residual_vibration(impulses, 40.0, damping));
+        shaper_impulses(ShaperType::ZVD, 40.0, damping, impulses);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.0, residual_vibration(impulses, 40.0, damping));
+    }
+}
+
+static void test_ei_holds_the_tolerance_at_the_resonance() {
+    ShaperImpulses impulses;
+    shaper_impulses(ShaperType::EI, 40.0, 0.0, impulses);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.05, residual_vibration(impulses, 40.0, 0.0));
+}
+
+static void test_robustness_to_frequency_error() {
+    // 20% off the resonance, ZVD and EI leave less vibration than ZV
+    ShaperImpulses zv, zvd, ei;
+    shaper_impulses(ShaperType::ZV, 40.0, 0.0, zv);
+    shaper_impulses(ShaperType::ZVD, 40.0, 0.0, zvd);
+    shaper_impulses(ShaperType::EI, 40.0, 0.0, ei);
+    double v_zv = residual_vibration(zv, 48.0, 0.0);
+    TEST_ASSERT_LESS_THAN(v_zv, residual_vibration(zvd, 48.0, 0.0));
+    TEST_ASSERT_LESS_THAN(v_zv, residual_vibration(ei, 48.0, 0.0));
+}
+
+static void test_history_interpolates_and_holds() {
+    ShaperHistory history;
+    double        p[SHAPER_MAX_AXES] = { 0.0, 10.0 };
+    history.reset(1.0, p, 0.0);
+    p[0] = 10.0;
+    history.push(2.0, p);
+
+    TEST_ASSERT_EQUAL(2, history.size());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0.0, history.position(0, 0.5));   // Before the first sample
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 2.5, history.position(0, 1.25));  // On the line
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 10.0, history.position(0, 3.0));  // After the last sample
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 10.0, history.position(1, 1.5));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 2.0, history.newest_time());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 10.0, history.newest_position()[0]);
+}
+
+static void test_history_discards_old_samples() {
+    ShaperHistory history;
+    double        p[SHAPER_MAX_AXES] = {};
+    history.reset(0.0, p, 0.0);
+    for (int i = 1; i <= 4; i++) {
+        p[0] = i;
+        history.push(i, p);
+    }
+    history.discard_before(2.5);
+    // The sample at 2 stays, for the line from 2 to 3
+    TEST_ASSERT_EQUAL(3, history.size());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 2.5, history.position(0, 2.5));
+    history.discard_before(10.0);
+    TEST_ASSERT_EQUAL(1, history.size());
+}
+
+static void test_history_spacing_bounds_the_samples() {
+    ShaperHistory history;
+    double        p[SHAPER_MAX_AXES] = {};
+    history.reset(0.0, p, 1.0);
+    // 1000 samples over 10 time units, 0.01 apart, with a spacing of 1
+    for (int i = 1; i <= 1000; i++) {
+        p[0] = i * 0.01;
+        history.push(i * 0.01, p);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(SHAPER_HISTORY_SIZE, history.size());
+    TEST_ASSERT_LESS_OR_EQUAL(12, history.size());
+    // On a straight line the merged samples lose nothing
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 5.555, history.position(0, 5.555));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 10.0, history.newest_position()[0]);
+
+    // Without a spacing, the oldest samples go once the history is full
+    history.reset(0.0, p, 0.0);
+    for (int i = 1; i <= 2 * SHAPER_HISTORY_SIZE; i++) {
+        history.push(i, p);
+    }
+    TEST_ASSERT_EQUAL(SHAPER_HISTORY_SIZE, history.size());
+}
+
+static void test_shaped_position() {
+    ShaperImpulses impulses;
+    shaper_impulses(ShaperType::ZV, 40.0, 0.0, impulses);
+    double dt = impulses.time[1];
+
+    ShaperHistory history;
+    double        p[SHAPER_MAX_AXES] = {};
+    history.reset(0.0, p, 0.0);
+    p[0] = 100.0;
+    history.push(100.0 * dt, p);  // A ramp at 1 per dt
+
+    // Holds still at the start and end
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0.0, history.shaped_position(0, 0.0, impulses));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 100.0, history.shaped_position(0, 101.0 * dt, impulses));
+    // On the ramp, the shaped position lags by the weighted mean delay of half an impulse step
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 49.5, history.shaped_position(0, 50.0 * dt, impulses));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_none_is_one_impulse);
+    RUN_TEST(test_zv_undamped);
+    RUN_TEST(test_amplitudes_add_up_to_one);
+    RUN_TEST(test_zero_vibration_at_the_resonance);
+    RUN_TEST(test_ei_holds_the_tolerance_at_the_resonance);
+    RUN_TEST(test_robustness_to_frequency_error);
+    RUN_TEST(test_history_interpolates_and_holds);
+    RUN_TEST(test_history_discards_old_samples);
+    RUN_TEST(test_history_spacing_bounds_the_samples);
+    RUN_TEST(test_shaped_position);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+/*
+  test_main.cpp - Host tests of the labware table and well addressing
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unity.h>
+
+#include "Labware.h"
+
+void setUp() {}
+void tearDown() {}
+
+// A 96 well plate with A1 at (10, 20), and rows running toward -Y
+static const char* PLATE_96 = "10 20 -5 9 -9 8 12 10.5 15";
+
+static void test_parse_a_plate() {
+    labware_t lw;
+    TEST_ASSERT_EQUAL(Error::Ok, labware_parse(PLATE_96, &lw));
+    TEST_ASSERT_EQUAL_FLOAT(10.0, lw.origin[0]);
+    TEST_ASSERT_EQUAL_FLOAT(20.0, lw.origin[1]);
+    TEST_ASSERT_EQUAL_FLOAT(-5.0, lw.origin[2]);
+    TEST_ASSERT_EQUAL_FLOAT(9.0, lw.pitch[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-9.0, lw.pitch[1]);
+    TEST_ASSERT_EQUAL(8, lw.rows);
+    TEST_ASSERT_EQUAL(12, lw.cols);
+    TEST_ASSERT_EQUAL_FLOAT(10.5, lw.depth);
+    TEST_ASSERT_EQUAL_FLOAT(15.0, lw.z_safe);
+    TEST_ASSERT_EQUAL_FLOAT(0.0, lw.well_area);  // Not given
+}
+
+static void test_parse_commas_and_well_area() {
+    labware_t lw;
+    TEST_ASSERT_EQUAL(Error::Ok, labware_parse("0,0,0, 4.5,4.5, 16,24, 11.5,20, 12.25", &lw));
+    TEST_ASSERT_EQUAL(16, lw.rows);
+    TEST_ASSERT_EQUAL(24, lw.cols);
+    TEST_ASSERT_EQUAL_FLOAT(12.25, lw.well_area);
+}
+
+static void test_parse_rejects_bad_definitions() {
+    labware_t lw;
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 8 12 10.5", &lw));          // Too few
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 8 12 10.5 15 1 2", &lw));   // Too many
+    TEST_ASSERT_EQUAL(Error::BadNumberFormat, labware_parse("10 20 -5 9 -9 8 x 10.5 15", &lw));     // Not a number
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 0 12 10.5 15", &lw));       // No rows
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 17 12 10.5 15", &lw));      // Too many rows
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 8 25 10.5 15", &lw));       // Too many columns
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 8.5 12 10.5 15", &lw));     // Part of a row
+    TEST_ASSERT_EQUAL(Error::InvalidValue, labware_parse("10 20 -5 9 -9 8 12 10.5 15 -1", &lw));    // Negative area
+}
+
+static void test_well_positions() {
+    labware_t lw;
+    labware_parse(PLATE_96, &lw);
+    LabwareWells wells;
+    wells.set(lw);
+    TEST_ASSERT_EQUAL(96, wells.wells());
+
+    float x, y;
+    TEST_ASSERT_TRUE(wells.position(0, &x, &y));  // A1
+    TEST_ASSERT_EQUAL_FLOAT(10.0, x);
+    TEST_ASSERT_EQUAL_FLOAT(20.0, y);
+    TEST_ASSERT_TRUE(wells.position(11, &x, &y));  // A12
+    TEST_ASSERT_EQUAL_FLOAT(109.0, x);
+    TEST_ASSERT_EQUAL_FLOAT(20.0, y);
+    TEST_ASSERT_TRUE(wells.position(12, &x, &y));  // B1
+    TEST_ASSERT_EQUAL_FLOAT(10.0, x);
+    TEST_ASSERT_EQUAL_FLOAT(11.0, y);
+    TEST_ASSERT_TRUE(wells.position(95, &x, &y));  // H12
+    TEST_ASSERT_EQUAL_FLOAT(109.0, x);
+    TEST_ASSERT_EQUAL_FLOAT(-43.0, y);
+}
+
+static void test_no_such_well() {
+    labware_t lw;
+    labware_parse(PLATE_96, &lw);
+    LabwareWells wells;
+    wells.set(lw);
+    float x = 1.0, y = 2.0;
+    TEST_ASSERT_FALSE(wells.position(-1, &x, &y));
+    TEST_ASSERT_FALSE(wells.position(96, &x, &y));
+    TEST_ASSERT_EQUAL_FLOAT(1.0, x);  // Left alone
+    TEST_ASSERT_EQUAL_FLOAT(2.0, y);
+
+    LabwareWells empty;  // An unset slot has no wells
+    TEST_ASSERT_EQUAL(0, empty.wells());
+    TEST_ASSERT_FALSE(empty.position(0, &x, &y));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_a_plate);
+    RUN_TEST(test_parse_commas_and_well_area);
+    RUN_TEST(test_parse_rejects_bad_definitions);
+    RUN_TEST(test_well_positions);
+    RUN_TEST(test_no_such_well);
+    return UNITY_END();
+}
@@ -0,0 +1,223 @@
+/*
+  test_main.cpp - Host tests of the well visit ordering
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unity.h>
+
+#include "WellTour.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void setUp() {}
+void tearDown() {}
+
+static well_tour_t t;
+
+static bool never() {
+    return false;
+}
+
+static bool always() {
+    return true;
+}
+
+// 100 mm/sec and 1000 mm/sec^2 on both axes, start at the origin
+static void tour_axes() {
+    t.rate[0]  = 100.0;
+    t.rate[1]  = 100.0;
+    t.accel[0] = 1000.0;
+    t.accel[1] = 1000.0;
+    t.x[0]     = 0.0;
+    t.y[0]     = 0.0;
+}
+
+static void tour_identity() {
+    for (uint16_t i = 0; i <= t.n; i++) {
+        t.tour[i] = i;
+    }
+}
+
+// Every point once, starting at point 0
+static bool tour_is_permutation() {
+    bool seen[WELL_TOUR_MAX + 1] = {};
+    if (t.tour[0] != 0) {
+        return false;
+    }
+    for (uint16_t i = 0; i <= t.n; i++) {
+        if (t.tour[i] > t.n || seen[t.tour[i]]) {
+            return false;
+        }
+        seen[t.tour[i]] = true;
+    }
+    return true;
+}
+
+// A plate of rows x cols wells at pitch, shuffled with a fixed seed
+static void tour_shuffled_plate(uint8_t rows, uint8_t cols, float pitch) {
+    tour_axes();
+    t.n = rows * cols;
+    for (uint16_t i = 0; i < t.n; i++) {
+        t.x[i + 1] = 14.38 + (i % cols) * pitch;
+        t.y[i + 1] = 11.24 + (i / cols) * pitch;
+    }
+    uint32_t seed = 1;
+    for (uint16_t i = t.n; i > 1; i--) {
+        seed       = seed * 1103515245 + 12345;
+        uint16_t j = 1 + (seed >> 16) % i;
+        std::swap(t.x[i], t.x[j]);
+        std::swap(t.y[i], t.y[j]);
+    }
+    tour_identity();
+}
+
+static void test_cost_profiles() {
+    tour_axes();
+    t.x[1] = 1.0;  // Short: a triangle profile, 2 * sqrt(d / a)
+    t.y[1] = 0.0;
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0 * sqrt(1.0 / 1000.0), well_tour_cost(&t, 0, 1));
+    t.x[1] = 100.0;  // Long: a trapezoid, d / v + v / a
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0 + 0.1, well_tour_cost(&t, 0, 1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, well_tour_cost(&t, 0, 1), well_tour_cost(&t, 1, 0));
+
+    // The slower axis sets the time. Y alone at half the rate takes longer.
+    t.rate[1] = 50.0;
+    t.x[1]    = 0.0;
+    t.y[1]    = 100.0;
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0 + 0.05, well_tour_cost(&t, 0, 1));
+    t.x[1] = 100.0;
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0 + 0.05, well_tour_cost(&t, 0, 1));
+}
+
+static void test_tour_time_adds_the_edges() {
+    tour_axes();
+    t.n    = 2;
+    t.x[1] = 100.0;
+    t.y[1] = 0.0;
+    t.x[2] = 200.0;
+    t.y[2] = 0.0;
+    tour_identity();
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.2, well_tour_time(&t));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.1, t.edge_cost[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.1, t.edge_cost[1]);
+}
+
+static void test_nearest_neighbour_on_a_line() {
+    tour_axes();
+    const float x[] = { 30.0, 10.0, 50.0, 20.0, 40.0 };
+    t.n             = 5;
+    for (uint16_t i = 0; i < t.n; i++) {
+        t.x[i + 1] = x[i];
+        t.y[i + 1] = 0.0;
+    }
+    well_tour_nearest_neighbour(&t);
+    TEST_ASSERT_TRUE(tour_is_permutation());
+    for (uint16_t i = 1; i < t.n; i++) {
+        TEST_ASSERT_LESS_THAN(t.x[t.tour[i + 1]], t.x[t.tour[i]]);  // Out along the line
+    }
+}
+
+static void test_two_opt_uncrosses() {
+    tour_axes();
+    t.n = 5;
+    for (uint16_t i = 1; i <= t.n; i++) {
+        t.x[i] = 10.0 * i;
+        t.y[i] = 0.0;
+    }
+    const uint16_t zigzag[] = { 0, 3, 1, 4, 2, 5 };
+    std::copy(zigzag, zigzag + 6, t.tour);
+    float    before = well_tour_time(&t);
+    uint32_t passes = 0;
+    TEST_ASSERT_TRUE(well_tour_two_opt(&t, never, &passes));
+    TEST_ASSERT_GREATER_THAN(0, passes);
+    TEST_ASSERT_TRUE(tour_is_permutation());
+    for (uint16_t i = 0; i <= t.n; i++) {
+        TEST_ASSERT_EQUAL(i, t.tour[i]);
+    }
+    TEST_ASSERT_LESS_THAN(before, well_tour_time(&t));
+}
+
+static void test_two_opt_stops_at_the_deadline() {
+    tour_shuffled_plate(8, 12, 9.0);
+    float    before = well_tour_time(&t);
+    uint32_t passes = 0;
+    TEST_ASSERT_FALSE(well_tour_two_opt(&t, always, &passes));
+    TEST_ASSERT_EQUAL(0, passes);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, before, well_tour_time(&t));  // Left as it was
+}
+
+// Shuffled 96 and 384 well plates. Nearest neighbour then 2-opt must beat the host order and
+// come close to a serpentine, the row-by-row order a person would pick.
+static void test_plates() {
+    const struct {
+        uint8_t rows;
+        uint8_t cols;
+        float   pitch;
+    } plates[] = { { 8, 12, 9.0 }, { 16, 24, 4.5 } };
+    for (auto plate : plates) {
+        tour_shuffled_plate(plate.rows, plate.cols, plate.pitch);
+        float host_time = well_tour_time(&t);
+
+        well_tour_nearest_neighbour(&t);
+        float    nn_time = well_tour_time(&t);
+        uint32_t passes  = 0;
+        TEST_ASSERT_TRUE(well_tour_two_opt(&t, never, &passes));
+        float time = well_tour_time(&t);
+        TEST_ASSERT_TRUE(tour_is_permutation());
+
+        // The serpentine through the same wells
+        static well_tour_t serpentine;
+        serpentine = t;
+        uint16_t i = 0;
+        for (uint16_t row = 0; row < plate.rows; row++) {
+            for (uint16_t c = 0; c < plate.cols; c++) {
+                uint16_t col       = row % 2 ? plate.cols - 1 - c : c;
+                serpentine.x[++i]  = 14.38 + col * plate.pitch;
+                serpentine.y[i]    = 11.24 + row * plate.pitch;
+                serpentine.tour[i] = i;
+            }
+        }
+        float serpentine_time = well_tour_time(&serpentine);
+
+        char message[120];
+        snprintf(message,
+                 sizeof(message),
+                 "%d wells: host %.2fs, NN %.2fs, 2-opt %.2fs in %u passes, serpentine %.2fs",
+                 t.n,
+                 host_time,
+                 nn_time,
+                 time,
+                 passes,
+                 serpentine_time);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_LESS_OR_EQUAL_FLOAT(nn_time, time);
+        TEST_ASSERT_LESS_THAN(host_time / 2, time);
+        TEST_ASSERT_LESS_OR_EQUAL_FLOAT(serpentine_time * 1.02, time);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_cost_profiles);
+    RUN_TEST(test_tour_time_adds_the_edges);
+    RUN_TEST(test_nearest_neighbour_on_a_line);
+    RUN_TEST(test_two_opt_uncrosses);
+    RUN_TEST(test_two_opt_stops_at_the_deadline);
+    RUN_TEST(test_plates);
+    return UNITY_END();
+}
@@ -71,7 +71,10 @@ parser.add_argument('-s','--settings',action='store_true', default=False,
         help='settings write mode')        
 parser.add_argument('-c','--check',action='store_true', default=False,
         help='stream in check mode')
+parser.add_argument('-b','--buffer',type=int, default=RX_BUFFER_SIZE,
+        help='grbl receive buffer size, the last number of the [OPT:] line of $I ($Client/RxBuffer)')
 args = parser.parse_args()
+RX_BUFFER_SIZE = args.buffer
 
 # Periodic timer to query for status reports
 # TODO: Need to track down why this doesn't restart consistently before a release.